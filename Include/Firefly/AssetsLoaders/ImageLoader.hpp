@@ -17,21 +17,26 @@ namespace Firefly
 
 	/**
 	 * Load an image from a given directory.
+	 * KTX2 files are loaded using LoadKTX2ImageFromFile(), which keeps their mip levels and block compressed formats.
+	 * The image is returned in the shader read only layout. The upload is executed along with the next submission.
 	 *
 	 * @param pEngine The engine pointer to which the image is bound to.
 	 * @param path The file path.
+	 * @param bGenerateMipMaps Whether or not to create and generate the full mip chain. Default is true.
 	 * @return The created image.
 	 */
-	std::shared_ptr<Image> LoadImageFromFile(const std::shared_ptr<Engine>& pEngine, const std::filesystem::path& path);
+	std::shared_ptr<Image> LoadImageFromFile(const std::shared_ptr<Engine>& pEngine, const std::filesystem::path& path, const bool bGenerateMipMaps = true);
 
 	/**
 	 * Load an image from memory.
+	 * The image is returned in the shader read only layout. The upload is executed along with the next submission.
 	 *
 	 * @param pEngine The engine pointer.
 	 * @param pImageData The image data to load.
 	 * @param size The image data size.
 	 * @param format The image data format.
+	 * @param bGenerateMipMaps Whether or not to create and generate the full mip chain. Default is true.
 	 * @return The created image.
 	 */
-	std::shared_ptr<Image> LoadImageFromMemory(const std::shared_ptr<Engine>& pEngine, const unsigned char* pImageData, const uint64_t size, const ImageDataFormat format);
+	std::shared_ptr<Image> LoadImageFromMemory(const std::shared_ptr<Engine>& pEngine, const unsigned char* pImageData, const uint64_t size, const ImageDataFormat format, const bool bGenerateMipMaps = true);
 }
\ No newline at end of file
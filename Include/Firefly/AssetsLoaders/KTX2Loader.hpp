@@ -0,0 +1,32 @@
+#pragma once
+
+#include <filesystem>
+#include "Firefly/Image.hpp"
+
+namespace Firefly
+{
+	/**
+	 * Load a KTX2 image from a given directory.
+	 * Block compressed payloads (BCn, ETC2, ASTC) are uploaded as they are, along with all of their mip levels. If the device does not support
+	 * the format, BC1 - BC5 payloads are decoded to RGBA8 on the CPU. If the file does not contain mip levels, they are generated.
+	 * The image is returned in the shader read only layout. The upload is executed along with the next submission.
+	 *
+	 * @param pEngine The engine pointer to which the image is bound to.
+	 * @param path The file path.
+	 * @return The created image.
+	 * @throws BackendError if the file is not a valid KTX2 file, or if it uses a feature which is not supported.
+	 */
+	std::shared_ptr<Image> LoadKTX2ImageFromFile(const std::shared_ptr<Engine>& pEngine, const std::filesystem::path& path);
+
+	/**
+	 * Load a KTX2 image from memory.
+	 * The image is returned in the shader read only layout. The upload is executed along with the next submission.
+	 *
+	 * @param pEngine The engine pointer.
+	 * @param pImageData The KTX2 file data.
+	 * @param size The file data size.
+	 * @return The created image.
+	 * @throws BackendError if the data is not a valid KTX2 file, or if it uses a feature which is not supported.
+	 */
+	std::shared_ptr<Image> LoadKTX2ImageFromMemory(const std::shared_ptr<Engine>& pEngine, const unsigned char* pImageData, const uint64_t size);
+}
\ No newline at end of file
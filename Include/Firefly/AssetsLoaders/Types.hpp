@@ -37,6 +37,10 @@ namespace Firefly
 		std::shared_ptr<Buffer> m_VertexBuffer = nullptr;
 		std::shared_ptr<Buffer> m_IndexBuffer = nullptr;
 
+		// Tightly packed vertex positions, in the same order as the vertex buffer. Depth only passes use this with the same index buffer, so they
+		// only fetch 12 bytes per vertex.
+		std::shared_ptr<Buffer> m_PositionBuffer = nullptr;
+
 		uint64_t m_VertexCount = 0;
 		uint64_t m_IndexCount = 0;
 	};
@@ -2,12 +2,18 @@
 
 #include "EngineBoundObject.hpp"
 
+#include <type_traits>
+#include <unordered_set>
+
 namespace Firefly
 {
 	class RenderTarget;
 	class GraphicsPipeline;
 	class Package;
+	class BindlessTable;
 	class Buffer;
+	class Shader;
+	struct GraphicsPipelineSpecification;
 
 	/**
 	 * Command buffer object.
@@ -36,11 +42,14 @@ namespace Firefly
 
 		/**
 		 * Begin the command buffer recording.
+		 *
+		 * @param vUsageFlags The command buffer usage flags. Use 0 if the recorded commands are to be submitted more than once. Default is one time submit.
 		 */
-		void begin();
+		void begin(const VkCommandBufferUsageFlags vUsageFlags = VkCommandBufferUsageFlagBits::VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 
 		/**
 		 * Bind an render target to the command buffer.
+		 * If the render target uses dynamic rendering, the attachments are transitioned and rendered to directly.
 		 *
 		 * @param pRenderTarget The render target to bind.
 		 * @param vClearColors The clear color values.
@@ -52,6 +61,12 @@ namespace Firefly
 		 */
 		void unbindRenderTarget() const;
 
+		/**
+		 * Advance to the next subpass of the bound render target.
+		 * Pipelines bound after this must be created for the new subpass. This must not be called when the render target uses dynamic rendering.
+		 */
+		void nextSubpass() const;
+
 		/**
 		 * Bind a graphics pipeline to the command buffer.
 		 *
@@ -75,6 +90,80 @@ namespace Firefly
 		 */
 		void bindGraphicsPipeline(const GraphicsPipeline* pPipeline, const std::vector<Package*>& pPackages) const;
 
+		/**
+		 * Bind resource packages without binding the pipeline.
+		 * This is useful when the pipeline is already bound and only the resources change between draws. Packages which are already bound to
+		 * their set with a compatible pipeline layout are skipped.
+		 *
+		 * @param pPipeline The pipeline whose layout the packages are bound with.
+		 * @param pPackages The resource packages to bind. Null packages are skipped.
+		 */
+		void bindPackages(const GraphicsPipeline* pPipeline, const std::vector<Package*>& pPackages) const;
+
+		/**
+		 * Bind a bindless table to its set.
+		 * The table stays bound across pipelines with compatible layouts, so this only needs to be called again when switching to a pipeline with
+		 * different shader set layouts.
+		 *
+		 * @param pPipeline The pipeline whose layout the table is bound with.
+		 * @param pBindlessTable The bindless table to bind.
+		 * @throws BackendError if the pipeline was not created with the table's set layout.
+		 */
+		void bindBindlessTable(const GraphicsPipeline* pPipeline, const BindlessTable* pBindlessTable) const;
+
+		/**
+		 * Prepare a set of shaders so that they can be bound using bindShaders().
+		 * This creates the fast linked pipeline of the shader combination, so it must be called before recording. Extended dynamic state is used
+		 * when supported, so the pipeline does not depend on the dynamic states.
+		 *
+		 * @param pShaders The shaders to prepare.
+		 * @param pRenderTarget The render target the shaders render to.
+		 * @return The prepared pipeline. Keep it alive for as long as the shaders are bound.
+		 * @throws BackendError if the command buffer is recording.
+		 */
+		std::shared_ptr<GraphicsPipeline> prepareShaders(const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget) const;
+
+		/**
+		 * Prepare a set of shaders so that they can be bound using bindShaders().
+		 * This creates the fast linked pipeline of the shader combination, so it must be called before recording. Extended dynamic state is used
+		 * when supported, so the pipeline does not depend on the dynamic states.
+		 *
+		 * @param pShaders The shaders to prepare.
+		 * @param pRenderTarget The render target the shaders render to.
+		 * @param specification The pipeline specification.
+		 * @return The prepared pipeline. Keep it alive for as long as the shaders are bound.
+		 * @throws BackendError if the command buffer is recording.
+		 */
+		std::shared_ptr<GraphicsPipeline> prepareShaders(const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification) const;
+
+		/**
+		 * Bind a set of shaders to the command buffer.
+		 * This resolves the graphics pipeline of the shader combination from the engine's pipeline cache, without compiling anything. The shaders
+		 * must be prepared using prepareShaders(). The states of the default specification are set if extended dynamic state is used.
+		 * The command buffer keeps the resolved pipelines alive till it's recorded again.
+		 *
+		 * @param pShaders The shaders to bind.
+		 * @param pRenderTarget The render target the shaders render to.
+		 * @return The graphics pipeline used. This can be used to create packages and bind them.
+		 * @throws BackendError if the shaders were not prepared.
+		 */
+		std::shared_ptr<GraphicsPipeline> bindShaders(const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget) const;
+
+		/**
+		 * Bind a set of shaders to the command buffer.
+		 * This resolves the graphics pipeline of the shader combination from the engine's pipeline cache, without compiling anything. The shaders
+		 * must be prepared using prepareShaders() with the same specification. The states of the specification are set if extended dynamic state
+		 * is used.
+		 * The command buffer keeps the resolved pipelines alive till it's recorded again.
+		 *
+		 * @param pShaders The shaders to bind.
+		 * @param pRenderTarget The render target the shaders render to.
+		 * @param specification The pipeline specification.
+		 * @return The graphics pipeline used. This can be used to create packages and bind them.
+		 * @throws BackendError if the shaders were not prepared.
+		 */
+		std::shared_ptr<GraphicsPipeline> bindShaders(const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification) const;
+
 		/**
 		 * Bind a vertex buffer to the command buffer.
 		 * Make sure that the buffer type is vertex.
@@ -83,6 +172,15 @@ namespace Firefly
 		 */
 		void bindVertexBuffer(const Buffer* pVertexBuffer) const;
 
+		/**
+		 * Bind a per instance vertex buffer to the command buffer.
+		 * This is read by the pipelines which have per instance inputs (see GraphicsPipelineSpecification::firstInstanceLocation).
+		 * Make sure that the buffer type is vertex.
+		 *
+		 * @param pInstanceBuffer The buffer to bind.
+		 */
+		void bindInstanceBuffer(const Buffer* pInstanceBuffer) const;
+
 		/**
 		 * Bind a index buffer to the command buffer.
 		 * Make sure that the buffer type is index.
@@ -106,20 +204,135 @@ namespace Firefly
 		 */
 		void bindScissor(const VkRect2D scissor) const;
 
+		/**
+		 * Set all the extended dynamic states using a pipeline specification.
+		 * The pipeline must be created with extended dynamic state enabled, and the states must be set after binding it and before drawing.
+		 * Depth bias, primitive restart and rasterizer discard are disabled.
+		 *
+		 * @param specification The specification to get the states from.
+		 */
+		void setDynamicState(const GraphicsPipelineSpecification& specification) const;
+
+		/**
+		 * Set the cull mode.
+		 * The bound pipeline must be created with extended dynamic state enabled.
+		 *
+		 * @param vCullMode The cull mode to set.
+		 */
+		void setCullMode(const VkCullModeFlags vCullMode) const;
+
+		/**
+		 * Set the front face.
+		 * The bound pipeline must be created with extended dynamic state enabled.
+		 *
+		 * @param vFrontFace The front face to set.
+		 */
+		void setFrontFace(const VkFrontFace vFrontFace) const;
+
+		/**
+		 * Set the primitive topology.
+		 * The topology must be of the same class as the one the pipeline was created with.
+		 * The bound pipeline must be created with extended dynamic state enabled.
+		 *
+		 * @param vPrimitiveTopology The primitive topology to set.
+		 */
+		void setPrimitiveTopology(const VkPrimitiveTopology vPrimitiveTopology) const;
+
+		/**
+		 * Enable or disable depth testing.
+		 * The bound pipeline must be created with extended dynamic state enabled.
+		 *
+		 * @param bEnable Whether or not to enable depth testing.
+		 */
+		void setDepthTestEnable(const bool bEnable) const;
+
+		/**
+		 * Enable or disable depth writes.
+		 * The bound pipeline must be created with extended dynamic state enabled.
+		 *
+		 * @param bEnable Whether or not to enable depth writes.
+		 */
+		void setDepthWriteEnable(const bool bEnable) const;
+
+		/**
+		 * Set the depth compare operation.
+		 * The bound pipeline must be created with extended dynamic state enabled.
+		 *
+		 * @param vCompareOp The compare operation to set.
+		 */
+		void setDepthCompareOp(const VkCompareOp vCompareOp) const;
+
+		/**
+		 * Enable or disable depth bias.
+		 * The bound pipeline must be created with extended dynamic state enabled.
+		 *
+		 * @param bEnable Whether or not to enable depth bias.
+		 */
+		void setDepthBiasEnable(const bool bEnable) const;
+
+		/**
+		 * Enable or disable primitive restart.
+		 * The bound pipeline must be created with extended dynamic state enabled.
+		 *
+		 * @param bEnable Whether or not to enable primitive restart.
+		 */
+		void setPrimitiveRestartEnable(const bool bEnable) const;
+
+		/**
+		 * Enable or disable rasterizer discard.
+		 * The bound pipeline must be created with extended dynamic state enabled.
+		 *
+		 * @param bEnable Whether or not to enable rasterizer discard.
+		 */
+		void setRasterizerDiscardEnable(const bool bEnable) const;
+
+		/**
+		 * Update push constants of the last bound graphics pipeline.
+		 * The stage flags are extended with the stages of every pipeline push constant range overlapping the updated bytes.
+		 *
+		 * @param vStageFlags The shader stages which use the push constants.
+		 * @param offset The byte offset to update from.
+		 * @param size The number of bytes to update.
+		 * @param pData The data to copy.
+		 * @throws BackendError if no pipeline is bound, or if the updated bytes are not fully covered by the push constant ranges of every updated stage.
+		 */
+		void pushConstants(const VkShaderStageFlags vStageFlags, const uint32_t offset, const uint32_t size, const void* pData) const;
+
+		/**
+		 * Update push constants of the last bound graphics pipeline.
+		 *
+		 * @tparam Type The value type. This must be trivially copyable.
+		 * @param vStageFlags The shader stages which use the push constants.
+		 * @param value The value to copy.
+		 * @param offset The byte offset to update from. Default is 0.
+		 */
+		template<class Type>
+		void pushConstants(const VkShaderStageFlags vStageFlags, const Type& value, const uint32_t offset = 0) const
+		{
+			static_assert(std::is_trivially_copyable_v<Type>, "Push constant values must be trivially copyable!");
+			pushConstants(vStageFlags, offset, static_cast<uint32_t>(sizeof(Type)), &value);
+		}
+
 		/**
 		 * Issue the draw vertices call.
 		 *
 		 * @param vertexCount The number of vertices to draw.
+		 * @param instanceCount The number of instances to draw. Default is 1.
+		 * @param firstVertex The first vertex to draw. Default is 0.
+		 * @param firstInstance The first instance to draw. Default is 0.
 		 */
-		void drawVertices(const uint32_t vertexCount) const;
+		void drawVertices(const uint32_t vertexCount, const uint32_t instanceCount = 1, const uint32_t firstVertex = 0, const uint32_t firstInstance = 0) const;
 
 		/**
 		 * Issue the draw indices call.
 		 *
 		 * @param indexCount The number of indices to draw.
 		 * @param vertexOffset The vertex offset to draw from. Default is 0.
+		 * @param instanceCount The number of instances to draw. Default is 1.
+		 * @param firstIndex The first index to draw. Default is 0.
+		 * @param firstInstance The first instance to draw. Default is 0.
 		 */
-		void drawIndices(const uint32_t indexCount, const uint32_t vertexOffset = 0) const;
+		void drawIndices(const uint32_t indexCount, const uint32_t vertexOffset = 0, const uint32_t instanceCount = 1, const uint32_t firstIndex = 0, const uint32_t firstInstance = 0) const;
 
 		/**
 		 * End command buffer recording.
@@ -133,6 +346,20 @@ namespace Firefly
 		 */
 		void submit(bool shouldWait = true);
 
+		/**
+		 * Wait till the last submission of the command buffer finishes execution.
+		 * This returns immediately if the command buffer was never submitted.
+		 */
+		void wait() const;
+
+		/**
+		 * Check if the last submission of the command buffer finished execution.
+		 * This returns true if the command buffer was never submitted.
+		 *
+		 * @return Whether the last submission finished execution.
+		 */
+		bool isExecuted() const;
+
 		/**
 		 * Terminate the command buffer.
 		 */
@@ -152,6 +379,14 @@ namespace Firefly
 		 */
 		bool isRecording() const { return m_bIsRecording; }
 
+		/**
+		 * Check if any of the recorded pipelines has swapped its Vulkan pipeline since it was bound.
+		 * This happens once an asynchronously compiled or an optimized pipeline is ready, and the commands need to be recorded again to use it.
+		 *
+		 * @return Boolean value stating if the recorded pipelines are outdated or not.
+		 */
+		bool hasOutdatedPipelines() const;
+
 		/**
 		 * Get the in flight semaphore.
 		 *
@@ -177,13 +412,46 @@ namespace Firefly
 		 */
 		void createSemaphores();
 
+		/**
+		 * Create the fence.
+		 */
+		void createFence();
+
+		/**
+		 * Begin dynamic rendering to the attachments of a render target.
+		 *
+		 * @param pRenderTarget The render target to render to.
+		 * @param vClearColors The clear color values.
+		 */
+		void beginRendering(const RenderTarget* pRenderTarget, const std::vector<VkClearValue>& vClearColors) const;
+
+		/**
+		 * Bind descriptor sets using the layout of a pipeline.
+		 * Sets which are still bound from a compatible pipeline layout are not bound again.
+		 *
+		 * @param pPipeline The pipeline whose layout the sets are bound with.
+		 * @param vDescriptorSets The set index and descriptor set pairs.
+		 */
+		void bindDescriptorSets(const GraphicsPipeline* pPipeline, const std::vector<std::pair<uint32_t, VkDescriptorSet>>& vDescriptorSets) const;
+
 	private:
 		VkSemaphore m_vInFlightSemaphore = VK_NULL_HANDLE;
 		VkSemaphore m_vRenderFinishedSemaphore = VK_NULL_HANDLE;
+		VkFence m_vFence = VK_NULL_HANDLE;
 
 		VkCommandPool m_vCommandPool = VK_NULL_HANDLE;
 		VkCommandBuffer m_vCommandBuffer = VK_NULL_HANDLE;
 
+		mutable std::unordered_set<std::shared_ptr<GraphicsPipeline>> m_pShaderPipelines;
+		mutable std::vector<std::pair<const GraphicsPipeline*, VkPipeline>> m_RecordedPipelines;
+		mutable const GraphicsPipeline* m_pBoundPipeline = nullptr;
+		mutable const RenderTarget* m_pBoundRenderTarget = nullptr;
+
+		mutable std::vector<VkDescriptorSet> m_vBoundDescriptorSets;
+		mutable std::vector<VkDescriptorSetLayout> m_vBoundDescriptorSetLayouts;
+		mutable std::vector<VkPushConstantRange> m_BoundPushConstantRanges;
+		mutable VkPipelineLayout m_vBoundPipelineLayout = VK_NULL_HANDLE;
+
 		bool m_bIsRecording = false;
 	};
 }
\ No newline at end of file
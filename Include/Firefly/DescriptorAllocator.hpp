@@ -0,0 +1,87 @@
+#pragma once
+
+#include "EngineBoundObject.hpp"
+
+namespace Firefly
+{
+	/**
+	 * Descriptor allocator object.
+	 * The allocator hands out descriptor sets from fixed size descriptor pools (blocks). When a block runs out, a new one is created and the
+	 * existing ones are kept as they are, so the sets which were already allocated never need to be moved or copied. If a set does not fit in an
+	 * empty block, the descriptor counts of the new blocks are doubled until it does.
+	 *
+	 * Sets are never freed individually. Either all of them are released at once using reset, or when the allocator is terminated.
+	 */
+	class DescriptorAllocator final : public EngineBoundObject
+	{
+	public:
+		/**
+		 * Constructor.
+		 *
+		 * @param pEngine The engine pointer.
+		 * @param vPoolSizes The descriptor counts of a single set. Each block has room for this multiplied by the sets per block.
+		 * @param setsPerBlock The maximum number of sets in a single block.
+		 */
+		explicit DescriptorAllocator(const std::shared_ptr<Engine>& pEngine, const std::vector<VkDescriptorPoolSize>& vPoolSizes, const uint32_t setsPerBlock);
+
+		/**
+		 * Destructor.
+		 */
+		~DescriptorAllocator() override;
+
+		/**
+		 * Create a new descriptor allocator.
+		 * Descriptor counts of the same type are merged together.
+		 *
+		 * @param pEngine The engine pointer.
+		 * @param vPoolSizes The descriptor counts of a single set.
+		 * @param setsPerBlock The maximum number of sets in a single block. Default is 32.
+		 * @return The allocator pointer.
+		 */
+		static std::shared_ptr<DescriptorAllocator> create(const std::shared_ptr<Engine>& pEngine, const std::vector<VkDescriptorPoolSize>& vPoolSizes, const uint32_t setsPerBlock = 32);
+
+		/**
+		 * Allocate a descriptor set.
+		 * If the current block is full, the next block is used, creating it if needed.
+		 *
+		 * @param vDescriptorSetLayout The layout of the set.
+		 * @return The descriptor pool which the set was allocated from and the descriptor set.
+		 * @throws BackendError if the layout uses a descriptor type which is not in the pool sizes of the allocator.
+		 */
+		std::pair<VkDescriptorPool, VkDescriptorSet> allocate(const VkDescriptorSetLayout vDescriptorSetLayout);
+
+		/**
+		 * Reset the allocator.
+		 * This releases all the allocated sets at once. The blocks are kept and reused by the next allocations.
+		 * Make sure that none of the sets are in use by the device.
+		 */
+		void reset();
+
+		/**
+		 * Terminate the allocator.
+		 */
+		void terminate() override;
+
+		/**
+		 * Get the number of blocks.
+		 *
+		 * @return The block count.
+		 */
+		uint64_t getBlockCount() const { return m_vBlocks.size(); }
+
+	private:
+		/**
+		 * Create a new block.
+		 *
+		 * @return The descriptor pool.
+		 */
+		VkDescriptorPool createBlock() const;
+
+	private:
+		std::vector<VkDescriptorPoolSize> m_vPoolSizes;
+		std::vector<VkDescriptorPool> m_vBlocks;
+
+		uint64_t m_CurrentBlock = 0;
+		const uint32_t m_SetsPerBlock = 0;
+	};
+}
\ No newline at end of file
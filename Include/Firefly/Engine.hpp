@@ -2,8 +2,36 @@
 
 #include "Instance.hpp"
 
+#include <mutex>
+#include <unordered_map>
+
 namespace Firefly
 {
+	class ShaderReflectionCache;
+
+	/**
+	 * Sampler specification structure.
+	 * This describes a sampler. Samplers with the same specification are shared through the engine's sampler cache.
+	 */
+	struct SamplerSpecification
+	{
+		VkFilter vMagFilter = VkFilter::VK_FILTER_LINEAR;
+		VkFilter vMinFilter = VkFilter::VK_FILTER_LINEAR;
+		VkSamplerMipmapMode vMipmapMode = VkSamplerMipmapMode::VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		VkSamplerAddressMode vAddressMode = VkSamplerAddressMode::VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		VkBorderColor vBorderColor = VkBorderColor::VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		VkCompareOp vCompareOp = VkCompareOp::VK_COMPARE_OP_ALWAYS;
+		bool bEnableCompare = false;
+
+		// The maximum anisotropy is clamped to the device limit. Anisotropic filtering is disabled if this is 1 or less.
+		float maxAnisotropy = 16.0f;
+
+		// The LOD range is not clamped to the mip levels by default, so the same sampler works for images with any number of mip levels.
+		float minLod = 0.0f;
+		float maxLod = VK_LOD_CLAMP_NONE;
+		float mipLodBias = 0.0f;
+	};
+
 	/**
 	 * RCHAC Engine class.
 	 * This class is the base class for the three engines, Graphics, Encoder and Decoder.
@@ -46,6 +74,43 @@ namespace Firefly
 		 */
 		void executeRecordedCommands(bool shouldWait = true);
 
+		/**
+		 * Queue image memory barriers.
+		 * Queued barriers are not submitted one by one. They are merged into a single pipeline barrier which is recorded at the start of the
+		 * engine's next command buffer recording, or at the end of the current one. Submitting a command buffer submits them as well.
+		 *
+		 * @param vBarriers The barriers to queue.
+		 */
+		void queueImageBarriers(const std::vector<VkImageMemoryBarrier2>& vBarriers);
+
+		/**
+		 * Submit the queued image barriers and the deferred uploads if there are any.
+		 * This waits till the commands finish execution.
+		 */
+		void submitPendingCommands();
+
+		/**
+		 * Copy data to the staging memory.
+		 * The staging memory is an arena of persistently mapped buffers which is shared by all the uploads, so uploading does not need a staging
+		 * buffer of its own. When the current buffer is full, a new one is chained instead of executing the pending uploads, so this can be called
+		 * while recording. The copied data must be consumed by commands recorded to the engine's command buffer. It stays valid till those
+		 * commands are executed, after which the memory is reused.
+		 *
+		 * @param pData The data to copy.
+		 * @param size The size of the data.
+		 * @return The staging buffer and the offset of the data in it.
+		 */
+		std::pair<VkBuffer, uint64_t> stageData(const void* pData, const uint64_t size);
+
+		/**
+		 * Record image memory barriers as a single pipeline barrier.
+		 * Synchronization 2 is used if it's enabled. Else the barriers are converted to a legacy pipeline barrier.
+		 *
+		 * @param vCommandBuffer The command buffer to record to.
+		 * @param vBarriers The barriers to record.
+		 */
+		void recordImageBarriers(const VkCommandBuffer vCommandBuffer, const std::vector<VkImageMemoryBarrier2>& vBarriers) const;
+
 		/**
 		 * Get the logical device of the engine.
 		 *
@@ -97,6 +162,95 @@ namespace Firefly
 		 */
 		VkPhysicalDeviceProperties getPhysicalDeviceProperties() const { return m_Properties; }
 
+		/**
+		 * Get the Vulkan API version usable by the engine.
+		 * This is the lower of the instance version and the physical device version.
+		 *
+		 * @return The API version.
+		 */
+		uint32_t getAPIVersion() const;
+
+		/**
+		 * Get the enabled core features.
+		 * Requested features which are not supported by the device are disabled.
+		 *
+		 * @return The features.
+		 */
+		const VkPhysicalDeviceFeatures& getFeatures() const { return m_Features; }
+
+		/**
+		 * Get the enabled Vulkan 1.2 features.
+		 * All the features will be disabled if the device does not support Vulkan 1.2.
+		 *
+		 * @return The features.
+		 */
+		const VkPhysicalDeviceVulkan12Features& getVulkan12Features() const { return m_Vulkan12Features; }
+
+		/**
+		 * Get the enabled Vulkan 1.3 features.
+		 * All the features will be disabled if the device does not support Vulkan 1.3.
+		 *
+		 * @return The features.
+		 */
+		const VkPhysicalDeviceVulkan13Features& getVulkan13Features() const { return m_Vulkan13Features; }
+
+		/**
+		 * Check if synchronization 2 is supported and enabled.
+		 *
+		 * @return Boolean stating if its supported or not.
+		 */
+		bool isSynchronization2Supported() const { return m_Vulkan13Features.synchronization2 == VK_TRUE; }
+
+		/**
+		 * Get the shader reflection cache.
+		 * Shaders created using this engine look up their reflection data here before reflecting the code.
+		 *
+		 * @return The reflection cache.
+		 */
+		ShaderReflectionCache& getShaderReflectionCache() const { return *m_pShaderReflectionCache; }
+
+		/**
+		 * Get a descriptor set layout with the given bindings.
+		 * Layouts are cached by their binding description, so identical bindings always return the same handle. This keeps descriptor sets of
+		 * different pipelines compatible with each other. The layouts are owned by the engine and are destroyed with it.
+		 *
+		 * @param vBindings The descriptor set layout bindings. The order does not matter.
+		 * @param vFlags The descriptor set layout create flags. Default is 0.
+		 * @param vBindingFlags The flags of each binding, in the same order as the bindings. Default is none.
+		 * @return The descriptor set layout.
+		 */
+		VkDescriptorSetLayout getDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& vBindings, const VkDescriptorSetLayoutCreateFlags vFlags = 0,
+			const std::vector<VkDescriptorBindingFlags>& vBindingFlags = {});
+
+		/**
+		 * Get a pipeline layout with the given set layouts and push constant ranges.
+		 * Like the descriptor set layouts, pipeline layouts are cached and owned by the engine.
+		 *
+		 * @param vDescriptorSetLayouts The descriptor set layouts, in set order.
+		 * @param vPushConstantRanges The push constant ranges.
+		 * @return The pipeline layout.
+		 */
+		VkPipelineLayout getPipelineLayout(const std::vector<VkDescriptorSetLayout>& vDescriptorSetLayouts, const std::vector<VkPushConstantRange>& vPushConstantRanges);
+
+		/**
+		 * Get the descriptor update template of a descriptor set layout.
+		 * Templates are cached per layout and owned by the engine. The entries must be the same for every call using the same layout.
+		 *
+		 * @param vDescriptorSetLayout The descriptor set layout.
+		 * @param vEntries The template entries.
+		 * @return The descriptor update template. This is null if the device does not support Vulkan 1.1.
+		 */
+		VkDescriptorUpdateTemplate getDescriptorUpdateTemplate(const VkDescriptorSetLayout vDescriptorSetLayout, const std::vector<VkDescriptorUpdateTemplateEntry>& vEntries);
+
+		/**
+		 * Get a sampler with the given specification.
+		 * Samplers are cached by their specification and owned by the engine, so the images using the same specification share a single sampler.
+		 *
+		 * @param specification The sampler specification.
+		 * @return The sampler.
+		 */
+		VkSampler getSampler(const SamplerSpecification& specification);
+
 		/**
 		 * Find a supported format from a given list.
 		 *
@@ -115,6 +269,18 @@ namespace Firefly
 		VkFormat findBestDepthFormat() const;
 
 	private:
+		/**
+		 * Staging block structure.
+		 * A single persistently mapped buffer of the staging arena.
+		 */
+		struct StagingBlock final
+		{
+			VkBuffer m_vBuffer = VK_NULL_HANDLE;
+			VmaAllocation m_Allocation = nullptr;
+			std::byte* m_pMemory = nullptr;
+			uint64_t m_Capacity = 0;
+		};
+
 		/**
 		 * Select a suitable physical device.
 		 *
@@ -159,6 +325,19 @@ namespace Firefly
 		 */
 		void destroyAllocator();
 
+		/**
+		 * Create a staging buffer.
+		 *
+		 * @param size The size of the buffer.
+		 * @return The staging block.
+		 */
+		StagingBlock createStagingBuffer(const uint64_t size) const;
+
+		/**
+		 * Destroy all the staging buffers.
+		 */
+		void destroyStagingBuffers();
+
 		/**
 		 * Destroy a created command pool.
 		 */
@@ -169,7 +348,33 @@ namespace Firefly
 		 */
 		void freeCommandBuffer();
 
+		/**
+		 * Destroy all the cached descriptor set layouts, pipeline layouts and descriptor update templates.
+		 */
+		void destroyLayouts();
+
+		/**
+		 * Destroy all the cached samplers.
+		 */
+		void destroySamplers();
+
+		/**
+		 * Record the queued image barriers, if there are any.
+		 *
+		 * @param vCommandBuffer The command buffer to record to.
+		 */
+		void recordQueuedImageBarriers(const VkCommandBuffer vCommandBuffer);
+
 	protected:
+		/**
+		 * Request Vulkan 1.2 and 1.3 features.
+		 * This must be called before initializing. Only the features which are supported by the device will be enabled.
+		 *
+		 * @param vFeatures12 The Vulkan 1.2 features to request.
+		 * @param vFeatures13 The Vulkan 1.3 features to request.
+		 */
+		void requestFeatures(const VkPhysicalDeviceVulkan12Features& vFeatures12, const VkPhysicalDeviceVulkan13Features& vFeatures13);
+
 		/**
 		 * Initialize the engine.
 		 *
@@ -182,11 +387,26 @@ namespace Firefly
 
 	private:
 		VkPhysicalDeviceProperties m_Properties = {};
+		VkPhysicalDeviceFeatures m_Features = {};
+		VkPhysicalDeviceVulkan12Features m_Vulkan12Features = {};
+		VkPhysicalDeviceVulkan13Features m_Vulkan13Features = {};
 
 		std::shared_ptr<Instance> m_pInstance = nullptr;
+		std::shared_ptr<ShaderReflectionCache> m_pShaderReflectionCache = nullptr;
 
 		std::vector<Queue> m_Queues;
 
+		std::unordered_map<std::string, VkDescriptorSetLayout> m_vDescriptorSetLayouts;
+		std::unordered_map<std::string, VkPipelineLayout> m_vPipelineLayouts;
+		std::unordered_map<VkDescriptorSetLayout, VkDescriptorUpdateTemplate> m_vDescriptorUpdateTemplates;
+		std::mutex m_LayoutMutex;
+
+		std::unordered_map<std::string, VkSampler> m_vSamplers;
+		std::mutex m_SamplerMutex;
+
+		std::vector<VkImageMemoryBarrier2> m_QueuedImageBarriers;
+		std::mutex m_BarrierMutex;
+
 		VkDevice m_vLogicalDevice = VK_NULL_HANDLE;
 		VkPhysicalDevice m_vPhysicalDevice = VK_NULL_HANDLE;
 
@@ -196,6 +416,10 @@ namespace Firefly
 		VolkDeviceTable m_DeviceTable;
 		VmaAllocator m_vAllocator;
 
+		std::vector<StagingBlock> m_StagingBlocks;
+		uint64_t m_StagingOffset = 0;
+		std::mutex m_StagingMutex;
+
 		bool m_bIsCommandBufferRecording = false;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "GraphicsEngine.hpp"
+#include "Firefly/Image.hpp"
+#include "Firefly/CommandBuffer.hpp"
+
+namespace Firefly
+{
+	/**
+	 * Bindless table object.
+	 * The bindless table is a single, global descriptor set which contains all the registered images and storage buffers. Resources are registered
+	 * once and are referenced by their index in the shaders (for example through push constants or instance data), so changing materials does not
+	 * require binding new descriptor sets.
+	 *
+	 * The set uses descriptor indexing (update after bind, partially bound and variable descriptor count), so resources can be registered while the
+	 * set is bound. Shaders access the table like this, where N is the number of shaders in the pipeline:
+	 *
+	 * layout(set = N, binding = 0) buffer Buffers { ... } buffers[];
+	 * layout(set = N, binding = 1) uniform sampler2D images[];
+	 *
+	 * Runtime sized arrays are not part of the shader's own descriptor set layout, so they can only be provided by the table.
+	 * To use the table, set its descriptor set layout in the pipeline specification and bind it using the command buffer.
+	 *
+	 * Unregistered resources and their indexes are not released right away, as frames in flight could still use them. Call endFrame() after
+	 * submitting each frame, and they are released once that frame's command buffer finished execution.
+	 */
+	class BindlessTable final : public EngineBoundObject
+	{
+	public:
+		static constexpr uint32_t BufferBinding = 0;
+		static constexpr uint32_t ImageBinding = 1;
+
+		/**
+		 * Constructor.
+		 *
+		 * @param pEngine The engine pointer.
+		 * @param imageCapacity The maximum number of images which can be registered.
+		 * @param bufferCapacity The maximum number of buffers which can be registered.
+		 */
+		explicit BindlessTable(const std::shared_ptr<GraphicsEngine>& pEngine, const uint32_t imageCapacity, const uint32_t bufferCapacity);
+
+		/**
+		 * Destructor.
+		 */
+		~BindlessTable() override;
+
+		/**
+		 * Create a new bindless table.
+		 *
+		 * @param pEngine The engine pointer.
+		 * @param imageCapacity The maximum number of images which can be registered. Default is 4096.
+		 * @param bufferCapacity The maximum number of buffers which can be registered. Default is 1024.
+		 * @return The bindless table pointer.
+		 * @throws BackendError if descriptor indexing is not supported, or if the capacities exceed the device limits.
+		 */
+		static std::shared_ptr<BindlessTable> create(const std::shared_ptr<GraphicsEngine>& pEngine, const uint32_t imageCapacity = 4096, const uint32_t bufferCapacity = 1024);
+
+		/**
+		 * Register an image in the table.
+		 * The image is bound as a combined image sampler, using the image's sampler.
+		 *
+		 * @param pImage The image to register.
+		 * @return The index of the image in the table.
+		 * @throws BackendError if the table is full.
+		 */
+		uint32_t registerImage(const std::shared_ptr<Image>& pImage);
+
+		/**
+		 * Register a storage buffer in the table.
+		 *
+		 * @param pBuffer The buffer to register. The buffer type must be storage.
+		 * @return The index of the buffer in the table.
+		 * @throws BackendError if the table is full or if the buffer is not a storage buffer.
+		 */
+		uint32_t registerBuffer(const std::shared_ptr<Buffer>& pBuffer);
+
+		/**
+		 * Unregister an image.
+		 * The image and its index are released once the frame which ends with the next endFrame() call finished execution.
+		 *
+		 * @param index The image index.
+		 * @throws BackendError if the index is not registered.
+		 */
+		void unregisterImage(const uint32_t index);
+
+		/**
+		 * Unregister a buffer.
+		 * The buffer and its index are released once the frame which ends with the next endFrame() call finished execution.
+		 *
+		 * @param index The buffer index.
+		 * @throws BackendError if the index is not registered.
+		 */
+		void unregisterBuffer(const uint32_t index);
+
+		/**
+		 * End the current frame.
+		 * The resources unregistered during the frame are queued until the command buffer's current submission finished execution, and the
+		 * queued resources of previous frames which finished execution are released, so their indexes can be reused.
+		 *
+		 * @param pCommandBuffer The command buffer the frame was submitted with. Call this after submitting it.
+		 */
+		void endFrame(const std::shared_ptr<CommandBuffer>& pCommandBuffer);
+
+		/**
+		 * Terminate the table.
+		 */
+		void terminate() override;
+
+		/**
+		 * Get the descriptor set layout.
+		 * Set this as the bindless set layout of the pipeline specification for pipelines which use the table.
+		 *
+		 * @return The descriptor set layout.
+		 */
+		VkDescriptorSetLayout getDescriptorSetLayout() const { return m_vDescriptorSetLayout; }
+
+		/**
+		 * Get the descriptor set.
+		 *
+		 * @return The descriptor set.
+		 */
+		VkDescriptorSet getDescriptorSet() const { return m_vDescriptorSet; }
+
+		/**
+		 * Get the image capacity.
+		 *
+		 * @return The maximum number of images.
+		 */
+		uint32_t getImageCapacity() const { return m_ImageCapacity; }
+
+		/**
+		 * Get the buffer capacity.
+		 *
+		 * @return The maximum number of buffers.
+		 */
+		uint32_t getBufferCapacity() const { return m_BufferCapacity; }
+
+	private:
+		/**
+		 * Initialize the table.
+		 */
+		void initialize();
+
+		/**
+		 * Create the descriptor set layout.
+		 */
+		void createDescriptorSetLayout();
+
+		/**
+		 * Create the descriptor pool and allocate the descriptor set.
+		 */
+		void createDescriptorSet();
+
+		/**
+		 * Allocate an index from a free list.
+		 *
+		 * @param freeIndexes The free indexes.
+		 * @param nextIndex The next index which was never used.
+		 * @param capacity The capacity of the array.
+		 * @return The allocated index.
+		 */
+		static uint32_t AllocateIndex(std::vector<uint32_t>& freeIndexes, uint32_t& nextIndex, const uint32_t capacity);
+
+	private:
+		/**
+		 * Released resources structure.
+		 * This holds the resources which were unregistered during a frame, till that frame finishes execution.
+		 */
+		struct ReleasedResources final
+		{
+			std::shared_ptr<CommandBuffer> m_pCommandBuffer = nullptr;
+
+			std::vector<std::shared_ptr<Image>> m_pImages;
+			std::vector<std::shared_ptr<Buffer>> m_pBuffers;
+
+			std::vector<uint32_t> m_ImageIndexes;
+			std::vector<uint32_t> m_BufferIndexes;
+		};
+
+		std::vector<std::shared_ptr<Image>> m_pImages;
+		std::vector<std::shared_ptr<Buffer>> m_pBuffers;
+
+		std::vector<uint32_t> m_FreeImageIndexes;
+		std::vector<uint32_t> m_FreeBufferIndexes;
+
+		ReleasedResources m_CurrentReleases;
+		std::vector<ReleasedResources> m_PendingReleases;
+
+		std::mutex m_Mutex;
+
+		VkDescriptorSetLayout m_vDescriptorSetLayout = VK_NULL_HANDLE;
+		VkDescriptorPool m_vDescriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSet m_vDescriptorSet = VK_NULL_HANDLE;
+
+		const uint32_t m_ImageCapacity = 0;
+		const uint32_t m_BufferCapacity = 0;
+
+		uint32_t m_NextImageIndex = 0;
+		uint32_t m_NextBufferIndex = 0;
+	};
+}
\ No newline at end of file
@@ -1,9 +1,15 @@
 #pragma once
 
 #include "Firefly/Engine.hpp"
+#include "Firefly/Tools/WorkerPool.hpp"
+
+#include <mutex>
+#include <unordered_map>
 
 namespace Firefly
 {
+	class GraphicsPipeline;
+
 	/**
 	 * Firefly Encoder class.
 	 * This class is the main Encoder engine.
@@ -21,6 +27,11 @@ namespace Firefly
 		 */
 		explicit GraphicsEngine(const std::shared_ptr<Instance>& pInstance);
 
+		/**
+		 * Destructor.
+		 */
+		~GraphicsEngine() override;
+
 		/**
 		 * Create a new graphics engine.
 		 *
@@ -28,5 +39,83 @@ namespace Firefly
 		 * @rerurn The created engine pointer.
 		 */
 		static std::shared_ptr<GraphicsEngine> create(const std::shared_ptr<Instance>& pInstance);
+
+		/**
+		 * Find a cached graphics pipeline.
+		 *
+		 * @param key The pipeline key.
+		 * @return The pipeline if one with the key is still alive, else nullptr.
+		 */
+		std::shared_ptr<GraphicsPipeline> findPipeline(const std::string& key);
+
+		/**
+		 * Register a graphics pipeline in the cache.
+		 * The cache does not own the pipeline, it is removed once all the references are released.
+		 *
+		 * @param key The pipeline key.
+		 * @param pPipeline The pipeline to register.
+		 */
+		void registerPipeline(const std::string& key, const std::shared_ptr<GraphicsPipeline>& pPipeline);
+
+		/**
+		 * Check if the extended dynamic state (1 and 2) commands are supported.
+		 * These are core in Vulkan 1.3.
+		 *
+		 * @return Boolean stating if its supported or not.
+		 */
+		bool isExtendedDynamicStateSupported() const { return getAPIVersion() >= VK_API_VERSION_1_3; }
+
+		/**
+		 * Check if dynamic rendering is supported and enabled.
+		 * This lets render targets render without render pass and frame buffer objects.
+		 *
+		 * @return Boolean stating if its supported or not.
+		 */
+		bool isDynamicRenderingSupported() const { return getVulkan13Features().dynamicRendering == VK_TRUE; }
+
+		/**
+		 * Check if pipeline creation cache control is supported and enabled.
+		 * This lets pipelines be created only if they are found in the pipeline cache.
+		 *
+		 * @return Boolean stating if its supported or not.
+		 */
+		bool isPipelineCreationCacheControlSupported() const { return getVulkan13Features().pipelineCreationCacheControl == VK_TRUE; }
+
+		/**
+		 * Check if the descriptor indexing features needed by bindless tables are supported and enabled.
+		 *
+		 * @return Boolean stating if its supported or not.
+		 */
+		bool isBindlessSupported() const;
+
+		/**
+		 * Get the pipeline cache shared by all the pipelines of the engine.
+		 *
+		 * @return The Vulkan pipeline cache.
+		 */
+		VkPipelineCache getPipelineCache() const { return m_vPipelineCache; }
+
+		/**
+		 * Get the worker pool used to compile pipelines asynchronously.
+		 * The pool is created on first use.
+		 *
+		 * @return The worker pool reference.
+		 */
+		WorkerPool& getWorkerPool();
+
+	private:
+		/**
+		 * Create the pipeline cache.
+		 */
+		void createPipelineCache();
+
+	private:
+		std::unordered_map<std::string, std::weak_ptr<GraphicsPipeline>> m_pPipelines;
+		std::mutex m_PipelineMutex;
+
+		std::unique_ptr<WorkerPool> m_pWorkerPool = nullptr;
+		std::mutex m_WorkerPoolMutex;
+
+		VkPipelineCache m_vPipelineCache = VK_NULL_HANDLE;
 	};
 }
\ No newline at end of file
@@ -2,8 +2,13 @@
 
 #include "RenderTarget.hpp"
 #include "Firefly/Shader.hpp"
+#include "Firefly/DescriptorAllocator.hpp"
 #include "Package.hpp"
 
+#include <atomic>
+#include <future>
+#include <limits>
+
 namespace Firefly
 {
 	/**
@@ -15,8 +20,35 @@ namespace Firefly
 		VkCullModeFlags vCullMode = VkCullModeFlagBits::VK_CULL_MODE_BACK_BIT;
 		VkFrontFace vFrontFace = VkFrontFace::VK_FRONT_FACE_CLOCKWISE;
 		VkPolygonMode vPolygonMode = VkPolygonMode::VK_POLYGON_MODE_FILL;
+		VkPrimitiveTopology vPrimitiveTopology = VkPrimitiveTopology::VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		VkCompareOp vDepthCompareOp = VkCompareOp::VK_COMPARE_OP_LESS_OR_EQUAL;
+		bool bEnableDepthTest = true;
+		bool bEnableDepthWrite = true;
+
+		// When disabled, the color attachments are not written. This is used by depth only pipelines, which can leave out the fragment shader.
+		bool bEnableColorWrite = true;
+
+		// The subpass of the render target which the pipeline is used in. Must be 0 for dynamic rendering.
+		uint32_t subpass = 0;
+
+		// When enabled, the cull mode, front face, primitive topology and depth states are dynamic and are set using the command buffer.
+		// A single pipeline can then be used for draws which only differ by these, by setting them after binding it. Requires Vulkan 1.3.
+		bool bUseExtendedDynamicState = false;
+
+		// The descriptor set layout of a bindless table. When set, it is added to the pipeline layout after the sets of the shaders.
+		VkDescriptorSetLayout vBindlessSetLayout = VK_NULL_HANDLE;
+
+		// The vertex shader inputs at or after this location are read per instance from the buffer bound using CommandBuffer::bindInstanceBuffer(),
+		// tightly packed in the order of their locations. Default is none, so every input is read per vertex.
+		uint32_t firstInstanceLocation = std::numeric_limits<uint32_t>::max();
 	};
 
+	/**
+	 * Stage specialization constants type.
+	 * This maps a shader stage to the specialization constants used by the shader of that stage.
+	 */
+	using StageSpecializationConstants = std::map<VkShaderStageFlagBits, SpecializationConstants>;
+
 	/**
 	 * Graphics pipeline object.
 	 * The graphics pipeline is used to render data to a render target and specifies all the rendering steps.
@@ -32,9 +64,11 @@ namespace Firefly
 		 * @param pShaders The shaders used by the pipeline.
 		 * @param pRenderTarget The render target pointer to which this pipeline is bound to.
 		 * @param specification The pipeline specification.
+		 * @param specializationConstants The specialization constants of each shader stage. Default is none.
 		 */
 		explicit GraphicsPipeline(const std::shared_ptr<GraphicsEngine>& pEngine, const std::string& pipelineName, const std::vector<std::shared_ptr<Shader>>& pShaders,
-			const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification = GraphicsPipelineSpecification());
+			const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification = GraphicsPipelineSpecification(),
+			const StageSpecializationConstants& specializationConstants = StageSpecializationConstants());
 
 		/**
 		 * Destructor.
@@ -43,16 +77,75 @@ namespace Firefly
 
 		/**
 		 * Create a new graphics pipeline.
+		 * If a pipeline with the same name, shaders, specialization constants, specification and render pass (or attachment formats) is alive, it is returned instead.
 		 *
 		 * @param pEngine The engine pointer.
 		 * @param pipelineName The unique name given to the pipeline. This will be used for caching.
 		 * @param pShaders The shaders used by the pipeline.
 		 * @param pRenderTarget The render target pointer to which this pipeline is bound to.
 		 * @param specification The pipeline specification.
+		 * @param specializationConstants The specialization constants of each shader stage. Default is none.
 		 * @return The graphics pipeline.
 		 */
 		static std::shared_ptr<GraphicsPipeline> create(const std::shared_ptr<GraphicsEngine>& pEngine, const std::string& pipelineName, const std::vector<std::shared_ptr<Shader>>& pShaders,
-			const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification = GraphicsPipelineSpecification());
+			const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification = GraphicsPipelineSpecification(),
+			const StageSpecializationConstants& specializationConstants = StageSpecializationConstants());
+
+		/**
+		 * Create a new graphics pipeline and compile it asynchronously on the engine's worker pool.
+		 * The pipeline layout is created right away, so packages can be created before the compilation finishes.
+		 * If a pipeline with the same name, shaders, specialization constants, specification and render pass (or attachment formats) is alive, it is returned instead.
+		 * The returned pipeline keeps the fallback it was created with, so the fallback pipeline given here is ignored in that case.
+		 * Baked frames which were recorded with the fallback pipeline report that they need to be recorded again once this one is ready.
+		 *
+		 * @param pEngine The engine pointer.
+		 * @param pipelineName The unique name given to the pipeline. This will be used for caching.
+		 * @param pShaders The shaders used by the pipeline.
+		 * @param pRenderTarget The render target pointer to which this pipeline is bound to.
+		 * @param specification The pipeline specification.
+		 * @param specializationConstants The specialization constants of each shader stage.
+		 * @param pFallbackPipeline The pipeline to use while this one is compiling. It must have a compatible pipeline layout. Default is nullptr.
+		 * @return The graphics pipeline.
+		 */
+		static std::shared_ptr<GraphicsPipeline> createAsync(const std::shared_ptr<GraphicsEngine>& pEngine, const std::string& pipelineName, const std::vector<std::shared_ptr<Shader>>& pShaders,
+			const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification = GraphicsPipelineSpecification(),
+			const StageSpecializationConstants& specializationConstants = StageSpecializationConstants(), const std::shared_ptr<GraphicsPipeline>& pFallbackPipeline = nullptr);
+
+		/**
+		 * Create a new graphics pipeline which is usable right away.
+		 * If the optimized pipeline is already in the engine's pipeline cache, it is used directly. Else a pipeline is first compiled without
+		 * optimizations, which is considerably faster. The optimized pipeline is then compiled on the engine's worker pool and swapped in once
+		 * done. Command buffers which are recorded after that will use the optimized pipeline, and baked frames of a render target which used
+		 * the unoptimized one report that they need to be recorded again (see RenderTarget::isFrameRecorded()).
+		 * If a pipeline with the same name, shaders, specialization constants, specification and render pass (or attachment formats) is alive, it is returned instead.
+		 *
+		 * @param pEngine The engine pointer.
+		 * @param pipelineName The unique name given to the pipeline. This will be used for caching.
+		 * @param pShaders The shaders used by the pipeline.
+		 * @param pRenderTarget The render target pointer to which this pipeline is bound to.
+		 * @param specification The pipeline specification.
+		 * @param specializationConstants The specialization constants of each shader stage. Default is none.
+		 * @return The graphics pipeline.
+		 */
+		static std::shared_ptr<GraphicsPipeline> createFastLinked(const std::shared_ptr<GraphicsEngine>& pEngine, const std::string& pipelineName, const std::vector<std::shared_ptr<Shader>>& pShaders,
+			const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification = GraphicsPipelineSpecification(),
+			const StageSpecializationConstants& specializationConstants = StageSpecializationConstants());
+
+		/**
+		 * Find an alive graphics pipeline in the engine's pipeline cache.
+		 * This never compiles anything, so it's safe to call while recording.
+		 *
+		 * @param pEngine The engine pointer.
+		 * @param pipelineName The name the pipeline was created with.
+		 * @param pShaders The shaders used by the pipeline.
+		 * @param pRenderTarget The render target pointer to which the pipeline is bound to.
+		 * @param specification The pipeline specification.
+		 * @param specializationConstants The specialization constants of each shader stage. Default is none.
+		 * @return The graphics pipeline, or nullptr if no such pipeline is alive.
+		 */
+		static std::shared_ptr<GraphicsPipeline> find(const std::shared_ptr<GraphicsEngine>& pEngine, const std::string& pipelineName, const std::vector<std::shared_ptr<Shader>>& pShaders,
+			const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification = GraphicsPipelineSpecification(),
+			const StageSpecializationConstants& specializationConstants = StageSpecializationConstants());
 
 		/**
 		 * Terminate the pipeline.
@@ -67,6 +160,17 @@ namespace Firefly
 		 */
 		std::shared_ptr<Package> createPackage(const Shader* pShader);
 
+		/**
+		 * Create a new transient package.
+		 * The descriptor set is allocated from the current frame of the render target, so the package is only valid for that frame. Use this for
+		 * bindings which change every frame, instead of creating and keeping a package per frame.
+		 *
+		 * @param pShader The shader to which the package is bound to.
+		 * @param pRenderTarget The render target to allocate the descriptor set from.
+		 * @return The created package.
+		 */
+		std::shared_ptr<Package> createTransientPackage(const Shader* pShader, RenderTarget* pRenderTarget) const;
+
 		/**
 		 * Get the pipeline layout.
 		 *
@@ -76,10 +180,79 @@ namespace Firefly
 
 		/**
 		 * Get the pipeline.
+		 * If the pipeline is still compiling, the fallback pipeline is returned. If there is no fallback, this waits till the compilation finishes.
 		 *
 		 * @return The Vulkan pipeline.
+		 * @throws BackendError if the compilation failed and there is no usable pipeline.
 		 */
-		VkPipeline getPipeline() const { return m_vPipeline; }
+		VkPipeline getPipeline() const;
+
+		/**
+		 * Check if the pipeline has finished compiling.
+		 *
+		 * @return Boolean stating if its ready or not.
+		 */
+		bool isReady() const { return m_bIsReady; }
+
+		/**
+		 * Check if the asynchronous compilation has failed.
+		 * Call wait() to get the error.
+		 *
+		 * @return Boolean stating if it failed or not.
+		 */
+		bool hasFailed() const { return m_bHasFailed; }
+
+		/**
+		 * Check if the current pipeline is the optimized one.
+		 *
+		 * @return Boolean stating if its optimized or not.
+		 */
+		bool isOptimized() const { return m_bIsOptimized; }
+
+		/**
+		 * Wait till the pipeline finishes compiling.
+		 * For fast linked pipelines, this waits till the optimized pipeline is swapped in.
+		 * This rethrows the error if the compilation failed.
+		 */
+		void wait() const;
+
+		/**
+		 * Get the push constant ranges of the pipeline layout.
+		 * Overlapping ranges of different stages are merged into one.
+		 *
+		 * @return The push constant ranges.
+		 */
+		const std::vector<VkPushConstantRange>& getPushConstantRanges() const { return m_PushConstantRanges; }
+
+		/**
+		 * Get the descriptor set layouts of the pipeline layout.
+		 * The set index of each layout is the index of its shader.
+		 *
+		 * @return The descriptor set layouts.
+		 */
+		const std::vector<VkDescriptorSetLayout>& getDescriptorSetLayouts() const { return m_vDescriptorSetLayouts; }
+
+		/**
+		 * Get the bindless set layout of the pipeline.
+		 *
+		 * @return The bindless set layout. This is null if the pipeline does not use a bindless table.
+		 */
+		VkDescriptorSetLayout getBindlessSetLayout() const { return m_Specification.vBindlessSetLayout; }
+
+		/**
+		 * Get the pipeline specification.
+		 *
+		 * @return The specification.
+		 */
+		const GraphicsPipelineSpecification& getSpecification() const { return m_Specification; }
+
+		/**
+		 * Get the set index of the bindless table.
+		 * The bindless set comes right after the sets of the shaders.
+		 *
+		 * @return The set index.
+		 */
+		uint32_t getBindlessSetIndex() const { return static_cast<uint32_t>(m_pShaders.size()); }
 
 	private:
 		/**
@@ -89,14 +262,41 @@ namespace Firefly
 
 		/**
 		 * Create the pipeline.
+		 * If a pipeline already exists, it is replaced and destroyed when the pipeline is terminated.
+		 *
+		 * @param vFlags The pipeline create flags. Default is 0.
+		 * @return False if VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT was set and the pipeline was not in the cache, else true.
+		 */
+		bool createPipeline(const VkPipelineCreateFlags vFlags = 0);
+
+		/**
+		 * Create the pipeline on a worker thread.
+		 * If this fails, the pipeline is marked as failed so that the fallback pipeline is no longer used in its place.
 		 */
-		void createPipeline();
+		void compileOnWorker();
 
 		/**
 		 * Initialize the graphics pipeline.
 		 */
 		void initialize();
 
+		/**
+		 * Initialize the graphics pipeline and compile it on the worker pool.
+		 *
+		 * @param pFallbackPipeline The pipeline to use while compiling.
+		 */
+		void initializeAsync(const std::shared_ptr<GraphicsPipeline>& pFallbackPipeline);
+
+		/**
+		 * Initialize the graphics pipeline using an unoptimized pipeline and compile the optimized one on the worker pool.
+		 */
+		void initializeFastLinked();
+
+		/**
+		 * Validate the pipeline specification against the engine's capabilities and the render target.
+		 */
+		void validateSpecification() const;
+
 		/**
 		 * Check if a shader exists in the pipeline.
 		 *
@@ -109,16 +309,26 @@ namespace Firefly
 		const std::string m_Name;
 		const std::vector<std::shared_ptr<Shader>> m_pShaders;
 		std::vector<VkDescriptorPoolSize> m_DescriptorPoolSizes;
+		std::vector<VkPushConstantRange> m_PushConstantRanges;
+		std::vector<VkDescriptorSetLayout> m_vDescriptorSetLayouts;
 		std::vector<std::shared_ptr<Package>> m_pPackages;
 
 		const std::shared_ptr<RenderTarget> m_pRenderTarget = nullptr;
+		std::shared_ptr<GraphicsPipeline> m_pFallbackPipeline = nullptr;
+
+		std::shared_future<void> m_CompileFuture;
 
 		VkPipelineLayout m_vPipelineLayout = VK_NULL_HANDLE;
-		VkPipeline m_vPipeline = VK_NULL_HANDLE;
-		VkPipelineCache m_vPipelineCache = VK_NULL_HANDLE;
+		std::atomic<VkPipeline> m_vPipeline = VK_NULL_HANDLE;
+		VkPipeline m_vRetiredPipeline = VK_NULL_HANDLE;
 
-		VkDescriptorPool m_vDescriptorPool = VK_NULL_HANDLE;
+		std::shared_ptr<DescriptorAllocator> m_pDescriptorAllocator = nullptr;
 
 		GraphicsPipelineSpecification m_Specification = {};
+		StageSpecializationConstants m_SpecializationConstants = {};
+
+		std::atomic<bool> m_bIsReady = false;
+		std::atomic<bool> m_bHasFailed = false;
+		std::atomic<bool> m_bIsOptimized = false;
 	};
 }
\ No newline at end of file
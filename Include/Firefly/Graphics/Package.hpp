@@ -2,6 +2,7 @@
 
 #include "GraphicsEngine.hpp"
 #include "Firefly/Image.hpp"
+#include "Firefly/Shader.hpp"
 
 #include <unordered_map>
 
@@ -10,6 +11,10 @@ namespace Firefly
 	/**
 	 * Package object.
 	 * This object is used to submit resources to a pipeline when rendering.
+	 * Bound resources are kept in a CPU side shadow of the descriptor set, and each bindResources() call writes the descriptors it changed to
+	 * the set right away. Re-binding the same resources does not touch the set.
+	 * Since the set is written immediately, resources must not be re-bound while a submitted command buffer which uses the package is still
+	 * executing. Command buffers recorded earlier (such as baked frames) see the new resources the next time they are submitted.
 	 *
 	 * Note: Make sure that whatever the resource bound to this package lives longer than this object's lifetime.
 	 */
@@ -32,6 +37,16 @@ namespace Firefly
 			uint32_t m_DestinationArrayElement;
 		};
 
+		/**
+		 * Descriptor info union.
+		 * This is a single descriptor within the shadow, laid out the way the update template expects it.
+		 */
+		union DescriptorInfo
+		{
+			VkDescriptorBufferInfo m_BufferInfo;
+			VkDescriptorImageInfo m_ImageInfo;
+		};
+
 	public:
 		/**
 		 * Constructor.
@@ -41,17 +56,10 @@ namespace Firefly
 		 * @param vDescriptorPool The descriptor pool which the descriptor set is made with.
 		 * @param vDescriptorSet The descriptor set used by this package.
 		 * @param setIndex The descriptor set index.
+		 * @param bindings The bindings of the shader which the set layout was made from.
 		 */
-		explicit Package(const std::shared_ptr<GraphicsEngine>& pEngine, const VkDescriptorSetLayout vDescriptorSetLayout, const VkDescriptorPool vDescriptorPool, const VkDescriptorSet vDescriptorSet, const uint32_t setIndex);
-
-		/**
-		 * Swap the descriptors.
-		 * This is done once a new package is made.
-		 *
-		 * @param vDescriptorPool The new descriptor pool which the descriptor set is made with.
-		 * @param vDescriptorSet The new descriptor set.
-		 */
-		void swapDescriptors(const VkDescriptorPool vDescriptorPool, const VkDescriptorSet vDescriptorSet);
+		explicit Package(const std::shared_ptr<GraphicsEngine>& pEngine, const VkDescriptorSetLayout vDescriptorSetLayout, const VkDescriptorPool vDescriptorPool, const VkDescriptorSet vDescriptorSet, const uint32_t setIndex,
+			const std::unordered_map<std::string, ShaderBinding>& bindings);
 
 		/**
 		 * Create a new package.
@@ -60,9 +68,12 @@ namespace Firefly
 		 * @param vDescriptorSetLayout The descriptor set layout.
 		 * @param vDescriptorPool The descriptor pool which the descriptor set is made with.
 		 * @param vDescriptorSet The descriptor set used by this package.
+		 * @param setIndex The descriptor set index.
+		 * @param bindings The bindings of the shader which the set layout was made from.
 		 * @return The created package.
 		 */
-		static std::shared_ptr<Package> create(const std::shared_ptr<GraphicsEngine>& pEngine, const VkDescriptorSetLayout vDescriptorSetLayout, const VkDescriptorPool vDescriptorPool, const VkDescriptorSet vDescriptorSet, const uint32_t setIndex);
+		static std::shared_ptr<Package> create(const std::shared_ptr<GraphicsEngine>& pEngine, const VkDescriptorSetLayout vDescriptorSetLayout, const VkDescriptorPool vDescriptorPool, const VkDescriptorSet vDescriptorSet, const uint32_t setIndex,
+			const std::unordered_map<std::string, ShaderBinding>& bindings);
 
 		/**
 		 * Bind an buffer resources to the package.
@@ -71,6 +82,7 @@ namespace Firefly
 		 * @param pBuffers The buffer pointers.
 		 * @param vDescriptorType The type of the descriptor. Default is Uniform buffer.
 		 * @param arrayElement The destination array element to bind the resource to.
+		 * @throws BackendError if the binding does not exist in the layout, or if its type or size does not match.
 		 */
 		void bindResources(const uint32_t binding, const std::vector<std::shared_ptr<Buffer>>& pBuffers, const VkDescriptorType vDescriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, const uint32_t arrayElement = 0);
 
@@ -81,6 +93,7 @@ namespace Firefly
 		 * @param pImapImagesge The image pointers.
 		 * @param vDescriptorType The type of the descriptor. Default is Combined Image Sampler.
 		 * @param arrayElement The destination array element to bind the resource to.
+		 * @throws BackendError if the binding does not exist in the layout, or if its type or size does not match.
 		 */
 		void bindResources(const uint32_t binding, const std::vector<std::shared_ptr<Image>>& pImages, const VkDescriptorType vDescriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, const uint32_t arrayElement = 0);
 
@@ -117,13 +130,47 @@ namespace Firefly
 		 */
 		uint32_t getSetIndex() const { return m_SetIndex; }
 
+	private:
+		/**
+		 * Initialize the package.
+		 *
+		 * @param bindings The bindings of the shader which the set layout was made from.
+		 */
+		void initialize(const std::unordered_map<std::string, ShaderBinding>& bindings);
+
+		/**
+		 * Write a descriptor to the shadow.
+		 *
+		 * @param binding The binding of the descriptor.
+		 * @param vDescriptorType The type of the descriptor.
+		 * @param arrayElement The array element of the descriptor.
+		 * @param info The descriptor info.
+		 */
+		void writeDescriptor(const uint32_t binding, const VkDescriptorType vDescriptorType, const uint32_t arrayElement, const DescriptorInfo& info);
+
+		/**
+		 * Write the changed descriptors to the descriptor set.
+		 * If every descriptor of the set is bound, the whole shadow is written using the descriptor update template. Otherwise only the changed
+		 * descriptors are written. Nothing is done if nothing changed since the last update.
+		 */
+		void update();
+
 	private:
 		std::unordered_map<uint32_t, ResourceBinding> m_BindingMap;
 
+		std::vector<VkDescriptorUpdateTemplateEntry> m_vTemplateEntries;	// Sorted by the binding.
+		std::vector<DescriptorInfo> m_DescriptorInfos;
+		std::vector<bool> m_WrittenDescriptors;
+		std::vector<bool> m_DirtyDescriptors;
+
+		VkDescriptorUpdateTemplate m_vDescriptorUpdateTemplate = VK_NULL_HANDLE;
+
 		const VkDescriptorSetLayout m_vDescriptorSetLayout;
 		VkDescriptorPool m_vDescriptorPool = VK_NULL_HANDLE;
 		VkDescriptorSet m_vDescriptorSet = VK_NULL_HANDLE;
 
 		const uint32_t m_SetIndex = 0;
+		uint32_t m_WrittenCount = 0;
+		bool m_bIsDirty = false;
 	};
 }
\ No newline at end of file
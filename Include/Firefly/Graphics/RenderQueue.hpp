@@ -0,0 +1,201 @@
+#pragma once
+
+#include "GraphicsPipeline.hpp"
+#include "Firefly/CommandBuffer.hpp"
+
+#include <unordered_map>
+
+namespace Firefly
+{
+	/**
+	 * Draw range structure.
+	 * This specifies which part of the geometry and which instances are drawn by a single draw packet.
+	 */
+	struct DrawRange
+	{
+		uint32_t m_Count = 0;			// The index count if an index buffer is used, else the vertex count.
+		uint32_t m_FirstIndex = 0;		// The first index if an index buffer is used, else the first vertex.
+		uint32_t m_VertexOffset = 0;
+		uint32_t m_InstanceCount = 1;
+		uint32_t m_FirstInstance = 0;
+
+		// The per instance data, read by the pipelines with per instance inputs (see GraphicsPipelineSpecification::firstInstanceLocation).
+		// This is also bound for the depth pre-pass draw. Default is none.
+		const Buffer* m_pInstanceBuffer = nullptr;
+	};
+
+	/**
+	 * Depth pre-pass draw structure.
+	 * This specifies how a packet is drawn in the depth pre-pass, and how it is drawn in the main pass while the pre-pass is enabled.
+	 */
+	struct DepthPrepassDraw
+	{
+		const GraphicsPipeline* m_pPipeline = nullptr;			// The depth only pipeline. If this is nullptr, the packet is not drawn in the pre-pass.
+		const Buffer* m_pPositionBuffer = nullptr;				// The position only vertex stream, indexed the same way as the packet vertex buffer. Required with a pipeline.
+		std::vector<Package*> m_pPackages;						// The resource packages to bind with the depth only pipeline.
+
+		// The main pass pipeline which tests with VK_COMPARE_OP_EQUAL and does not write depth. This is not needed if the packet pipeline uses
+		// extended dynamic state, as the depth states are then set by the queue.
+		const GraphicsPipeline* m_pEqualPipeline = nullptr;
+	};
+
+	/**
+	 * Render queue object.
+	 * The render queue collects draw packets, sorts them using 64-bit sort keys and emits the minimal command stream to a command buffer.
+	 *
+	 * Opaque packets are ordered by pipeline, then by material (the packages) and then front-to-back by depth.
+	 * Transparent packets are always drawn after the opaque ones, back-to-front by depth.
+	 *
+	 * When the depth pre-pass is enabled, the opaque packets with a depth pre-pass draw are first drawn depth only, and then shaded with an
+	 * equal depth test so that each pixel is only shaded once. Both passes are emitted to the same render pass, so the depth attachment does not
+	 * need to be stored.
+	 *
+	 * Note: Make sure that the pipelines, packages and buffers submitted live until the queue is flushed.
+	 */
+	class RenderQueue final
+	{
+	public:
+		/**
+		 * Default constructor.
+		 */
+		RenderQueue() = default;
+
+		/**
+		 * Submit a draw packet to the queue.
+		 *
+		 * @param pPipeline The pipeline used to draw.
+		 * @param pPackages The resource packages to bind with the pipeline.
+		 * @param pVertexBuffer The vertex buffer to draw.
+		 * @param pIndexBuffer The index buffer to draw. If this is nullptr, a non-indexed draw is issued.
+		 * @param range The geometry range to draw.
+		 * @param depth The view space depth of the packet. This is used to order the packets.
+		 * @param bIsTransparent Whether or not the packet is transparent. Default is false.
+		 * @param prepass The depth pre-pass draw of the packet. This is ignored for transparent packets. Default is none.
+		 * @throws BackendError if the pre-pass draw has a pipeline but no position buffer, or if it has no equal pipeline while the packet pipeline
+		 * does not use extended dynamic state.
+		 */
+		void submit(const GraphicsPipeline* pPipeline, const std::vector<Package*>& pPackages, const Buffer* pVertexBuffer, const Buffer* pIndexBuffer,
+			const DrawRange& range, const float depth, const bool bIsTransparent = false, const DepthPrepassDraw& prepass = DepthPrepassDraw());
+
+		/**
+		 * Sort the submitted packets.
+		 * This is called automatically by flush() if the queue was not sorted since the last submission.
+		 */
+		void sort();
+
+		/**
+		 * Emit the sorted commands to a command buffer and clear the queue.
+		 * Redundant pipeline, package and buffer binds are skipped.
+		 * Make sure that the command buffer is recording and a render target is bound.
+		 *
+		 * @param pCommandBuffer The command buffer to record the commands to.
+		 */
+		void flush(const CommandBuffer* pCommandBuffer);
+
+		/**
+		 * Clear all the submitted packets and the pipeline and material sort IDs.
+		 * The allocated memory is kept to be reused by the next frame.
+		 */
+		void clear();
+
+		/**
+		 * Get the number of submitted packets.
+		 *
+		 * @return The packet count.
+		 */
+		uint64_t size() const { return m_Keys.size(); }
+
+		/**
+		 * Enable or disable the depth pre-pass.
+		 * This can be toggled at any time, and takes effect on the next flush.
+		 *
+		 * @param bEnable Whether or not to enable the depth pre-pass.
+		 */
+		void setDepthPrepass(const bool bEnable) { m_bIsDepthPrepassEnabled = bEnable; }
+
+		/**
+		 * Check if the depth pre-pass is enabled.
+		 *
+		 * @return Boolean stating if it's enabled or not.
+		 */
+		bool isDepthPrepassEnabled() const { return m_bIsDepthPrepassEnabled; }
+
+	private:
+		/**
+		 * Emit the depth pre-pass of the sorted opaque packets.
+		 *
+		 * @param pCommandBuffer The command buffer to record the commands to.
+		 */
+		void flushDepthPrepass(const CommandBuffer* pCommandBuffer);
+
+		/**
+		 * Bind a pipeline and set its depth states if they are dynamic.
+		 *
+		 * @param pCommandBuffer The command buffer to record the commands to.
+		 * @param pPipeline The pipeline to bind.
+		 * @param bTestEqual Whether or not to test depth for equality without writing it, as the depth was already written by the pre-pass.
+		 */
+		void bindPipeline(const CommandBuffer* pCommandBuffer, const GraphicsPipeline* pPipeline, const bool bTestEqual) const;
+
+		/**
+		 * Get the sort ID of a pipeline.
+		 *
+		 * @param pPipeline The pipeline pointer.
+		 * @return The pipeline ID.
+		 */
+		uint16_t getPipelineID(const GraphicsPipeline* pPipeline);
+
+		/**
+		 * Get the sort ID of a set of packages.
+		 *
+		 * @param pPackages The packages.
+		 * @return The material ID.
+		 */
+		uint16_t getMaterialID(const std::vector<Package*>& pPackages);
+
+		/**
+		 * Check if two package ranges are the same.
+		 *
+		 * @param lhsOffset The offset of the first range.
+		 * @param lhsCount The package count of the first range.
+		 * @param rhsOffset The offset of the second range.
+		 * @param rhsCount The package count of the second range.
+		 * @return Boolean stating if the packages are the same.
+		 */
+		bool hasSamePackages(const uint32_t lhsOffset, const uint32_t lhsCount, const uint32_t rhsOffset, const uint32_t rhsCount) const;
+
+	private:
+		// Packet data, stored as structure of arrays.
+		std::vector<uint64_t> m_Keys;
+		std::vector<const GraphicsPipeline*> m_pPipelines;
+		std::vector<const Buffer*> m_pVertexBuffers;
+		std::vector<const Buffer*> m_pIndexBuffers;
+		std::vector<DrawRange> m_Ranges;
+		std::vector<uint32_t> m_PackageOffsets;
+		std::vector<uint32_t> m_PackageCounts;
+		std::vector<Package*> m_pPackages;
+
+		// Depth pre-pass data of the packets. The packages are stored in the same package list.
+		std::vector<const GraphicsPipeline*> m_pPrepassPipelines;
+		std::vector<const GraphicsPipeline*> m_pEqualPipelines;
+		std::vector<const Buffer*> m_pPositionBuffers;
+		std::vector<uint32_t> m_PrepassPackageOffsets;
+		std::vector<uint32_t> m_PrepassPackageCounts;
+
+		// Sorting data.
+		std::vector<uint32_t> m_SortedIndices;
+		std::vector<uint64_t> m_SortKeys;
+		std::vector<uint64_t> m_ScratchKeys;
+		std::vector<uint32_t> m_ScratchIndices;
+
+		// Sort IDs. These only live until the queue is cleared, so freed pipelines and packages never hand their IDs to new objects at the same address.
+		std::unordered_map<const GraphicsPipeline*, uint16_t> m_PipelineIDs;
+		std::unordered_map<uint64_t, uint16_t> m_MaterialIDs;
+
+		// Scratch package list used when binding.
+		std::vector<Package*> m_pBindPackages;
+
+		bool m_bIsSorted = true;
+		bool m_bIsDepthPrepassEnabled = false;
+	};
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "GraphicsEngine.hpp"
 #include "Firefly/Image.hpp"
+#include "Firefly/DescriptorAllocator.hpp"
 
 namespace Firefly
 {
@@ -26,6 +27,32 @@ namespace Firefly
 	 */
 	std::vector<VkClearValue> CreateClearValues(const float r = 0.0f, const float g = 0.0f, const float b = 0.0f, const float a = 1.0f, const float depth = 1.0f, const uint32_t stencil = 0);
 
+	/**
+	 * Attachment specification structure.
+	 * This describes a single color attachment of a render target.
+	 */
+	struct AttachmentSpecification
+	{
+		VkFormat vFormat = VkFormat::VK_FORMAT_UNDEFINED;
+		VkAttachmentLoadOp vLoadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR;
+
+		// Attachments which are not stored only live within the render pass, so they are created as transient attachments.
+		VkAttachmentStoreOp vStoreOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_STORE;
+	};
+
+	/**
+	 * Subpass specification structure.
+	 * Attachments are referred to by their index in the attachment list of the render target.
+	 */
+	struct SubpassSpecification
+	{
+		std::vector<uint32_t> colorAttachments;
+		std::vector<uint32_t> inputAttachments;
+
+		// If enabled, the depth attachment is bound as the last input attachment and is only used read-only for depth testing in this subpass.
+		bool bReadDepth = false;
+	};
+
 	/**
 	 * Render target object.
 	 * Render targets contain the rendering pipelines and the processing pipelines.
@@ -40,8 +67,11 @@ namespace Firefly
 		 * @param extent The frame buffer extent.
 		 * 
 		 * @param frameCount The number of frame buffers to use. Default is 2.
+		 * @param bUseDynamicRendering Whether or not to render without a render pass and frame buffers. Default is false.
+		 * @param vSampleCount The number of samples to render with. Default is 1.
 		 */
-		explicit RenderTarget(const std::shared_ptr<GraphicsEngine>& pEngine, const VkExtent3D extent, const uint8_t frameCount = 2);
+		explicit RenderTarget(const std::shared_ptr<GraphicsEngine>& pEngine, const VkExtent3D extent, const uint8_t frameCount = 2, const bool bUseDynamicRendering = false,
+			const VkSampleCountFlagBits vSampleCount = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT);
 
 		/**
 		 * Destructor.
@@ -55,13 +85,36 @@ namespace Firefly
 		 * @param extent The frame buffer extent.
 		 * @param vColorFormat The color format to use.
 		 * @param frameCount The number of frame buffers to use. Default is 2.
+		 * @param bUseDynamicRendering Whether or not to use dynamic rendering. In this mode no render pass and frame buffers are created, and the
+		 *		attachments are rendered to directly. Pipelines are created against the attachment formats. Default is false.
+		 * @param vSampleCount The number of samples to render with. If this is more than 1, rendering is done to transient multisampled color and
+		 *		depth attachments, which are resolved to the color attachment at the end of the pass. Default is 1.
+		 * @return The render target pointer.
+		 * @throws BackendError if dynamic rendering is requested but the engine does not support it, or if the sample count is not supported.
+		 */
+		static std::shared_ptr<RenderTarget> create(const std::shared_ptr<GraphicsEngine>& pEngine, const VkExtent3D extent, const VkFormat vColorFormat, const uint8_t frameCount = 2,
+			const bool bUseDynamicRendering = false, const VkSampleCountFlagBits vSampleCount = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT);
+
+		/**
+		 * Create a new render target object with multiple attachments and subpasses.
+		 * Subpasses are executed in order, and can read the attachments written by the previous subpasses as input attachments, which lets
+		 * tile based GPUs keep them in on-chip memory. The first attachment is the one returned by getColorAttachment().
+		 *
+		 * @param pEngine The engine pointer.
+		 * @param extent The frame buffer extent.
+		 * @param attachments The color attachments.
+		 * @param subpasses The subpasses.
+		 * @param frameCount The number of frame buffers to use. Default is 2.
 		 * @return The render target pointer.
+		 * @throws BackendError if there are no attachments or subpasses, or if a subpass refers to an attachment which does not exist.
 		 */
-		static std::shared_ptr<RenderTarget> create(const std::shared_ptr<GraphicsEngine>& pEngine, const VkExtent3D extent, const VkFormat vColorFormat, const uint8_t frameCount = 2);
+		static std::shared_ptr<RenderTarget> create(const std::shared_ptr<GraphicsEngine>& pEngine, const VkExtent3D extent, const std::vector<AttachmentSpecification>& attachments,
+			const std::vector<SubpassSpecification>& subpasses, const uint8_t frameCount = 2);
 
 		/**
 		 * Setup the new frame.
-		 * This will submit a new frame to the GPU.
+		 * This waits till the previous submission of the current frame index finishes, and releases the transient descriptor sets of that frame.
+		 * In baked mode, this does not need to be called if isFrameRecorded() returns true. Calling it anyway will re-record the frame.
 		 *
 		 * @return The command buffer pointer.
 		 */
@@ -69,11 +122,59 @@ namespace Firefly
 
 		/**
 		 * Submit the frame to the GPU.
+		 * In baked mode, if the frame was not setup this will resubmit the previously recorded commands of the current frame index.
 		 *
 		 * @param shouldWait Whether or not if we should wait till execution ends. Default is true.
+		 * @throws BackendError if the frame was neither setup nor holds previously recorded commands (for example after invalidateFrames()).
 		 */
 		void submitFrame(const bool shouldWait = true);
 
+		/**
+		 * Allocate a transient descriptor set for the current frame.
+		 * Transient sets are never freed individually. All the sets of a frame are released at once when the frame is setup again, after its
+		 * previous submission has finished. This means that they are only valid for the frame they were allocated in, so allocate them after
+		 * setting up the frame.
+		 *
+		 * The transient pools have room for uniform and storage buffers (including dynamic ones), combined image samplers, sampled and storage
+		 * images, samplers and input attachments. Their blocks grow when a layout needs more descriptors of these types than a block holds.
+		 *
+		 * @param vDescriptorSetLayout The layout of the set.
+		 * @return The descriptor pool which the set was allocated from and the descriptor set.
+		 * @throws BackendError if the layout uses any other descriptor type.
+		 */
+		std::pair<VkDescriptorPool, VkDescriptorSet> allocateTransientDescriptorSet(const VkDescriptorSetLayout vDescriptorSetLayout);
+
+		/**
+		 * Enable or disable the baked mode.
+		 * In baked mode, the command buffers recorded for each frame index are kept and resubmitted as they are until the frames are invalidated.
+		 * This is useful for static scenes where only the uniform data changes between frames.
+		 *
+		 * @param bEnable Whether or not to enable the baked mode.
+		 */
+		void setBakedMode(const bool bEnable);
+
+		/**
+		 * Check if the render target is in the baked mode.
+		 *
+		 * @return Boolean value stating if its baked or not.
+		 */
+		bool isBaked() const { return m_bIsBaked; }
+
+		/**
+		 * Invalidate all the recorded frames.
+		 * This needs to be called in baked mode whenever the recorded commands are to be changed.
+		 */
+		void invalidateFrames();
+
+		/**
+		 * Check if the current frame holds recorded commands which can be resubmitted.
+		 * This will always return false if the render target is not in the baked mode, or if a pipeline used by the recorded commands has been
+		 * swapped since (for example once its optimized or asynchronously compiled pipeline is ready).
+		 *
+		 * @return Boolean value stating if the current frame needs to be recorded or not.
+		 */
+		bool isFrameRecorded() const;
+
 		/**
 		 * Terminate the render target.
 		 */
@@ -87,11 +188,49 @@ namespace Firefly
 		VkExtent3D getExtent() const { return m_Extent; }
 
 		/**
-		 * Get the color attachment.
+		 * Get a color attachment.
+		 * When multisampling, this is the single sampled image which the rendered image is resolved to.
 		 *
+		 * @param index The attachment index. Default is 0.
 		 * @return The color attachment pointer.
 		 */
-		std::shared_ptr<Image> getColorAttachment() const { return m_pColorAttachment; }
+		std::shared_ptr<Image> getColorAttachment(const uint32_t index = 0) const { return m_pColorAttachments[index]; }
+
+		/**
+		 * Get the number of color attachments.
+		 *
+		 * @return The color attachment count.
+		 */
+		uint32_t getColorAttachmentCount() const { return static_cast<uint32_t>(m_pColorAttachments.size()); }
+
+		/**
+		 * Get the subpasses.
+		 *
+		 * @return The subpass specifications.
+		 */
+		const std::vector<SubpassSpecification>& getSubpasses() const { return m_Subpasses; }
+
+		/**
+		 * Get the multisampled color attachment.
+		 * This is the image which is rendered to when multisampling. Its contents are not kept after the pass.
+		 *
+		 * @return The multisampled color attachment pointer. This is nullptr if the render target is not multisampled.
+		 */
+		std::shared_ptr<Image> getMultisampleColorAttachment() const { return m_pMultisampleColorAttachment; }
+
+		/**
+		 * Get the sample count.
+		 *
+		 * @return The number of samples which are rendered with.
+		 */
+		VkSampleCountFlagBits getSampleCount() const { return m_SampleCount; }
+
+		/**
+		 * Check if the render target is multisampled.
+		 *
+		 * @return Boolean stating if it's multisampled or not.
+		 */
+		bool isMultisampled() const { return m_SampleCount != VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT; }
 
 		/**
 		 * Get the depth attachment.
@@ -100,8 +239,16 @@ namespace Firefly
 		 */
 		std::shared_ptr<Image> getDepthAttachment() const { return m_pDepthAttachment; }
 
+		/**
+		 * Check if the render target uses dynamic rendering.
+		 *
+		 * @return Boolean stating if it uses dynamic rendering or not.
+		 */
+		bool isDynamicRendering() const { return m_bUseDynamicRendering; }
+
 		/**
 		 * Get the frame buffers.
+		 * This is empty when using dynamic rendering.
 		 *
 		 * @return The frame buffers.
 		 */
@@ -109,6 +256,7 @@ namespace Firefly
 
 		/**
 		 * Get the current frame buffer.
+		 * This must not be called when using dynamic rendering.
 		 *
 		 * @return The frame buffer in the current frame index.
 		 */
@@ -116,6 +264,7 @@ namespace Firefly
 
 		/**
 		 * Get the render pass.
+		 * This is VK_NULL_HANDLE when using dynamic rendering.
 		 *
 		 * @return The render pass.
 		 */
@@ -164,22 +313,33 @@ namespace Firefly
 		/**
 		 * Initialize the render target.
 		 * 
-		 * @param vColorFormat The color format to use.
+		 * @param attachments The color attachments.
+		 * @param subpasses The subpasses.
 		 */
-		void initialize(const VkFormat vColorFormat);
+		void initialize(const std::vector<AttachmentSpecification>& attachments, const std::vector<SubpassSpecification>& subpasses);
 
 	private:
 		const VkExtent3D m_Extent;
 
-		std::shared_ptr<Image> m_pColorAttachment = nullptr;
+		std::vector<AttachmentSpecification> m_Attachments;
+		std::vector<SubpassSpecification> m_Subpasses;
+
+		std::vector<std::shared_ptr<Image>> m_pColorAttachments;
+		std::shared_ptr<Image> m_pMultisampleColorAttachment = nullptr;
 		std::shared_ptr<Image> m_pDepthAttachment = nullptr;
 		std::vector<VkFramebuffer> m_vFrameBuffers;
 		std::vector<std::shared_ptr<CommandBuffer>> m_pCommandBuffers;
+		std::vector<std::shared_ptr<DescriptorAllocator>> m_pTransientAllocators;
+		std::vector<bool> m_FrameRecordedStates;
 
 		VkRenderPass m_vRenderPass = VK_NULL_HANDLE;
 		VkCommandPool m_vCommandPool = VK_NULL_HANDLE;
 
+		const VkSampleCountFlagBits m_SampleCount = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT;
 		const uint8_t m_FrameCount = 0;
 		uint8_t m_FrameIndex = 0;
+
+		bool m_bIsBaked = false;
+		const bool m_bUseDynamicRendering = false;
 	};
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "Buffer.hpp"
 
+#include <optional>
+
 namespace Firefly
 {
 	/**
@@ -29,9 +31,13 @@ namespace Firefly
 		 * @param type The image type.
 		 * @param layers The image layers. Default is 1.
 		 * @param usageFlags The image usage flags. Default is sampled | transfer source | transfer destination.
+		 * @param mipLevels The number of mip levels. Default is 1.
+		 * @param samplerSpecification The sampler specification. Default is the default specification, clamped to the edges for cube maps.
+		 * @param vSampleCount The number of samples per texel. Default is 1.
 		 */
 		explicit Image(const std::shared_ptr<Engine>& pEngine, const VkExtent3D extent, const VkFormat format, const ImageType type, const uint32_t layers = 1,
-			const VkImageUsageFlags usageFlags = VkImageUsageFlagBits::VK_IMAGE_USAGE_SAMPLED_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+			const VkImageUsageFlags usageFlags = VkImageUsageFlagBits::VK_IMAGE_USAGE_SAMPLED_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_DST_BIT, const uint32_t mipLevels = 1,
+			const std::optional<SamplerSpecification>& samplerSpecification = std::nullopt, const VkSampleCountFlagBits vSampleCount = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT);
 
 		/**
 		 * Destructor.
@@ -40,13 +46,55 @@ namespace Firefly
 
 		/**
 		 * Copy data from a stagging buffer.
+		 * The data is copied to the base mip level. If the image has more than one mip level, the rest are generated from it.
 		 *
 		 * @param pBuffer The buffer pointer to copy data from.
 		 */
 		void fromBuffer(const Buffer* pBuffer);
 
 		/**
-		 * Copy the whole image to a buffer.
+		 * Copy data to the mip levels from a stagging buffer.
+		 * The data of each mip level must be tightly packed, starting at its offset. Use this to upload mip levels which are already available, for
+		 * example block compressed ones which cannot be generated.
+		 *
+		 * @param pBuffer The buffer pointer to copy data from.
+		 * @param mipLevelOffsets The offset of each mip level in the buffer, starting from the base level.
+		 */
+		void fromBuffer(const Buffer* pBuffer, const std::vector<uint64_t>& mipLevelOffsets);
+
+		/**
+		 * Copy data from host memory.
+		 * The data is copied to the engine's staging memory, so a staging buffer is not needed. The upload is not submitted right away. It's
+		 * recorded to the engine's command buffer and is executed along with the next submission, so multiple uploads share a single submission.
+		 * If the image has more than one mip level, the rest are generated from the base level.
+		 *
+		 * @param pData The texel data of the base mip level.
+		 * @param size The size of the data.
+		 */
+		void fromMemory(const void* pData, const uint64_t size);
+
+		/**
+		 * Copy data to the mip levels from host memory.
+		 * The data of each mip level must be tightly packed, starting at its offset. Offsets must be aligned to the texel block size.
+		 *
+		 * @param pData The texel data.
+		 * @param size The size of the data.
+		 * @param mipLevelOffsets The offset of each mip level in the data, starting from the base level.
+		 */
+		void fromMemory(const void* pData, const uint64_t size, const std::vector<uint64_t>& mipLevelOffsets);
+
+		/**
+		 * Generate the mip levels from the base mip level.
+		 * Each level is blitted from the previous one. After this, all the mip levels are in the final layout.
+		 *
+		 * @param finalLayout The layout to put the mip levels in.
+		 * @param vCommandBuffer The command buffer used to send the commands to the GPU. Default is NULL.
+		 * @throws BackendError if the image format does not support blitting.
+		 */
+		void generateMipMaps(const VkImageLayout finalLayout, const VkCommandBuffer vCommandBuffer = VK_NULL_HANDLE);
+
+		/**
+		 * Copy the base mip level of the image to a buffer.
 		 *
 		 * @return The copied buffer.
 		 */
@@ -54,12 +102,24 @@ namespace Firefly
 
 		/**
 		 * Change the image layout to another one.
+		 * This changes the layout of all the mip levels. If a command buffer is not given, the transition is queued in the engine and is executed
+		 * before the next submission.
 		 *
 		 * @param newLayout The new layout to set.
 		 * @param vCommandBuffer The command buffer used to send the commands to the GPU. Default is NULL.
 		 */
 		void changeImageLayout(const VkImageLayout newLayout, const VkCommandBuffer vCommandBuffer = VK_NULL_HANDLE);
 
+		/**
+		 * Change the layout of a range of mip levels.
+		 *
+		 * @param newLayout The new layout to set.
+		 * @param baseMipLevel The first mip level to change.
+		 * @param levelCount The number of mip levels to change.
+		 * @param vCommandBuffer The command buffer used to send the commands to the GPU. Default is NULL.
+		 */
+		void changeMipLevelLayout(const VkImageLayout newLayout, const uint32_t baseMipLevel, const uint32_t levelCount, const VkCommandBuffer vCommandBuffer = VK_NULL_HANDLE);
+
 		/**
 		 * Terminate the image.
 		 */
@@ -74,10 +134,33 @@ namespace Firefly
 		 * @param type The image type.
 		 * @param layers The image layers. Default is 1.
 		 * @param usageFlags The image usage flags. Default is sampled | transfer source | transfer destination.
+		 * @param mipLevels The number of mip levels. Use GetMipLevelCount() to get the full mip chain. Default is 1.
+		 * @param samplerSpecification The sampler specification. The sampler is taken from the engine's sampler cache, and is only used if the
+		 *		image is sampled. Default is the default specification, clamped to the edges for cube maps.
+		 * @param vSampleCount The number of samples per texel. Multisampled images can only have one mip level. Images with the transient
+		 *		attachment usage are backed by lazily allocated memory when the device has it. Default is 1.
 		 * @return The image pointer.
+		 * @throws BackendError if the mip level count is 0 or greater than the full mip chain, or if a multisampled image has more than one mip level.
 		 */
 		static std::shared_ptr<Image> create(const std::shared_ptr<Engine>& pEngine, const VkExtent3D extent, const VkFormat format, const ImageType type, const uint32_t layers = 1,
-			const VkImageUsageFlags usageFlags = VkImageUsageFlagBits::VK_IMAGE_USAGE_SAMPLED_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+			const VkImageUsageFlags usageFlags = VkImageUsageFlagBits::VK_IMAGE_USAGE_SAMPLED_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_DST_BIT, const uint32_t mipLevels = 1,
+			const std::optional<SamplerSpecification>& samplerSpecification = std::nullopt, const VkSampleCountFlagBits vSampleCount = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT);
+
+		/**
+		 * Get the number of mip levels in the full mip chain of an extent.
+		 *
+		 * @param extent The image extent.
+		 * @return The mip level count.
+		 */
+		static uint32_t GetMipLevelCount(const VkExtent3D extent);
+
+		/**
+		 * Get the byte depth of a format.
+		 *
+		 * @param format The format.
+		 * @return The pixel size in bytes. This is 0 for block compressed and multi-planar formats.
+		 */
+		static uint8_t GetPixelSize(const VkFormat format);
 
 		/**
 		 * Get the image extent.
@@ -102,11 +185,19 @@ namespace Firefly
 
 		/**
 		 * Get the image sampler.
+		 * The sampler is owned by the engine and may be shared with other images.
 		 *
 		 * @return The sampler.
 		 */
 		VkSampler getSampler() const { return m_vSampler; }
 
+		/**
+		 * Get the sampler specification.
+		 *
+		 * @return The specification.
+		 */
+		SamplerSpecification getSamplerSpecification() const { return m_SamplerSpecification; }
+
 		/**
 		 * Get the image format.
 		 *
@@ -114,6 +205,13 @@ namespace Firefly
 		 */
 		VkFormat getFormat() const { return m_Format; }
 
+		/**
+		 * Get the image usage flags.
+		 *
+		 * @return The usage flags.
+		 */
+		VkImageUsageFlags getUsageFlags() const { return m_UsageFlags; }
+
 		/**
 		 * Get the image type.
 		 *
@@ -128,21 +226,57 @@ namespace Firefly
 		 */
 		uint32_t getLayers() const { return m_Layers; }
 
+		/**
+		 * Get the mip level count.
+		 *
+		 * @return The number of mip levels.
+		 */
+		uint32_t getMipLevels() const { return m_MipLevels; }
+
+		/**
+		 * Get the sample count.
+		 *
+		 * @return The number of samples per texel.
+		 */
+		VkSampleCountFlagBits getSampleCount() const { return m_SampleCount; }
+
 		/**
 		 * Get the image layout.
+		 * This is the layout of the base mip level.
 		 *
 		 * @return The image layout.
 		 */
-		VkImageLayout getImageLayout() const { return m_CurrentLayout; }
+		VkImageLayout getImageLayout() const { return m_MipStates.front().vLayout; }
+
+		/**
+		 * Get the layout of a mip level.
+		 *
+		 * @param mipLevel The mip level.
+		 * @return The image layout.
+		 */
+		VkImageLayout getMipLevelLayout(const uint32_t mipLevel) const { return m_MipStates[mipLevel].vLayout; }
 
 		/**
 		 * Get the byte depth of the current format.
 		 *
 		 * @return The pixel size in bytes.
 		 */
-		uint8_t getPixelSize() const;
+		uint8_t getPixelSize() const { return GetPixelSize(m_Format); }
 
 	private:
+		/**
+		 * Subresource state structure.
+		 * This is the layout of a mip level along with the access and stages which last used it, so the next transition knows what to wait for.
+		 */
+		struct SubresourceState final
+		{
+			VkImageLayout vLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED;
+			VkAccessFlags2 vAccessMask = VK_ACCESS_2_NONE;
+			VkPipelineStageFlags2 vStageMask = VK_PIPELINE_STAGE_2_NONE;
+
+			bool operator==(const SubresourceState& other) const { return vLayout == other.vLayout && vAccessMask == other.vAccessMask && vStageMask == other.vStageMask; }
+		};
+
 		/**
 		 * Create the image.
 		 */
@@ -154,7 +288,7 @@ namespace Firefly
 		void createImageView();
 
 		/**
-		 * Create the image sampler.
+		 * Get the image sampler from the engine.
 		 */
 		void createImageSampler();
 
@@ -177,8 +311,31 @@ namespace Firefly
 		 */
 		VkImageAspectFlags getImageAspectFlags() const;
 
+		/**
+		 * Record the commands to copy the mip levels from a buffer.
+		 * After copying, the image is put back in its old layout, generating the mip levels if only the base level was copied.
+		 *
+		 * @param vCommandBuffer The command buffer to record to.
+		 * @param vBuffer The buffer to copy from.
+		 * @param bufferOffset The offset of the data in the buffer.
+		 * @param mipLevelOffsets The offset of each mip level, relative to the buffer offset.
+		 */
+		void recordCopyFromBuffer(const VkCommandBuffer vCommandBuffer, const VkBuffer vBuffer, const uint64_t bufferOffset, const std::vector<uint64_t>& mipLevelOffsets);
+
+		/**
+		 * Create a layout transition barrier for a range of mip levels which are in the same state.
+		 *
+		 * @param oldState The current state of the mip levels.
+		 * @param newLayout The new layout.
+		 * @param baseMipLevel The first mip level.
+		 * @param levelCount The number of mip levels.
+		 * @return The memory barrier.
+		 */
+		VkImageMemoryBarrier2 createLayoutBarrier(const SubresourceState& oldState, const VkImageLayout newLayout, const uint32_t baseMipLevel, const uint32_t levelCount) const;
+
 	private:
 		VkExtent3D m_Extent;
+		SamplerSpecification m_SamplerSpecification;
 
 		VkImage m_vImage = VK_NULL_HANDLE;
 		VkImageView m_vImageView = VK_NULL_HANDLE;
@@ -186,10 +343,12 @@ namespace Firefly
 
 		VmaAllocation m_Allocation = nullptr;
 
-		VkImageLayout m_CurrentLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED;
+		std::vector<SubresourceState> m_MipStates;
 		const VkFormat m_Format = VkFormat::VK_FORMAT_UNDEFINED;
 		const ImageType m_Type = ImageType::TwoDimension;
 		const uint32_t m_Layers = 0;
+		const uint32_t m_MipLevels = 0;
 		const VkImageUsageFlags m_UsageFlags = 0;
+		const VkSampleCountFlagBits m_SampleCount = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT;
 	};
 }
\ No newline at end of file
@@ -6,15 +6,18 @@
  */
 
 #include "Source/AssetLoaders/ImageLoader.cpp"
+#include "Source/AssetLoaders/KTX2Loader.cpp"
 #include "Source/AssetLoaders/ObjLoader.cpp"
 #include "Source/AssetLoaders/Types.cpp"
 
 #include "Source/Decoder/Decoder.cpp"
 #include "Source/Encoder/Encoder.cpp"
 
+#include "Source/Graphics/BindlessTable.cpp"
 #include "Source/Graphics/GraphicsEngine.cpp"
 #include "Source/Graphics/GraphicsPipeline.cpp"
 #include "Source/Graphics/Package.cpp"
+#include "Source/Graphics/RenderQueue.cpp"
 #include "Source/Graphics/RenderTarget.cpp"
 
 #ifndef __ANDROID__
@@ -28,15 +31,19 @@
 #include "Source/Maths/StereoCamera.cpp"
 
 #include "Source/Tools/Renderdoc.cpp"
+#include "Source/Tools/WorkerPool.cpp"
 
 #include "Source/Buffer.cpp"
 #include "Source/CommandBuffer.cpp"
+#include "Source/DescriptorAllocator.cpp"
 #include "Source/Engine.cpp"
 #include "Source/EngineBoundObject.cpp"
 #include "Source/Image.cpp"
 #include "Source/Instance.cpp"
 #include "Source/Queue.cpp"
 #include "Source/Shader.cpp"
+#include "Source/ShaderArchive.cpp"
+#include "Source/ShaderReflectionCache.cpp"
 #include "Source/Utility.cpp"
 
 #define VOLK_IMPLEMENTATION
@@ -4,7 +4,9 @@
 
 #include <SPIRV-Reflect/spirv_reflect.h>
 #include <filesystem>
+#include <map>
 #include <unordered_map>
+#include <type_traits>
 
 namespace Firefly
 {
@@ -31,6 +33,50 @@ namespace Firefly
 		uint32_t m_Size = 0;
 	};
 
+	/**
+	 * Specialization constants structure.
+	 * This contains the specialization constant values of a single shader stage, mapped to their constant IDs.
+	 */
+	struct SpecializationConstants
+	{
+		/**
+		 * Set a specialization constant value.
+		 * Boolean constants should be set using VkBool32.
+		 *
+		 * @tparam Type The value type. This must be trivially copyable.
+		 * @param constantID The constant ID (the SpecId decoration in the shader).
+		 * @param value The value to set.
+		 */
+		template<class Type>
+		void set(const uint32_t constantID, const Type& value)
+		{
+			static_assert(std::is_trivially_copyable_v<Type>, "Specialization constant values must be trivially copyable!");
+
+			const auto pBegin = reinterpret_cast<const uint8_t*>(&value);
+			m_Values[constantID] = std::vector<uint8_t>(pBegin, pBegin + sizeof(Type));
+		}
+
+		/**
+		 * Check if the structure contains any values.
+		 *
+		 * @return Boolean stating if its empty or not.
+		 */
+		bool empty() const { return m_Values.empty(); }
+
+	public:
+		std::map<uint32_t, std::vector<uint8_t>> m_Values;
+	};
+
+	/**
+	 * Shader code view structure.
+	 * This points to SPIR-V code owned by someone else, for example a memory mapped shader archive.
+	 */
+	struct ShaderCodeView
+	{
+		const uint32_t* m_pCode = nullptr;
+		uint64_t m_WordCount = 0;
+	};
+
 	/**
 	 * Shader object.
 	 * Shaders are programs that run in the GPU. This object contains one instance of it.
@@ -78,6 +124,17 @@ namespace Firefly
 		 */
 		static std::shared_ptr<Shader> create(const std::shared_ptr<Engine>& pEngine, const ShaderCode& shaderCode, const VkShaderStageFlags flags);
 
+		/**
+		 * Create a new shader object from code owned by someone else.
+		 * The code is not copied, and it only needs to live until this call returns.
+		 *
+		 * @param pEngine The engine pointer.
+		 * @param shaderCode The shader code view.
+		 * @param flags The shader stage flags.
+		 * @return The shader object.
+		 */
+		static std::shared_ptr<Shader> create(const std::shared_ptr<Engine>& pEngine, const ShaderCodeView& shaderCode, const VkShaderStageFlags flags);
+
 		/**
 		 * Terminate the shader.
 		 */
@@ -148,20 +205,27 @@ namespace Firefly
 		 */
 		std::vector<VkPushConstantRange> getPushConstants() const { return m_PushConstants; }
 
+		/**
+		 * Get the specialization constants declared in the shader.
+		 *
+		 * @return The map of constant IDs to the constant sizes in bytes.
+		 */
+		const std::unordered_map<uint32_t, uint32_t>& getSpecializationConstants() const { return m_SpecializationConstants; }
+
 	private:
 		/**
 		 * Create the shader module.
 		 * 
 		 * @param code The shader code.
 		 */
-		void createShaderModule(const ShaderCode& code);
+		void createShaderModule(const ShaderCodeView& code);
 
 		/**
 		 * Create the descriptor set layout.
 		 * 
 		 * @param code The shader code.
 		 */
-		void createDescriptorSetLayout(const ShaderCode& code);
+		void createDescriptorSetLayout(const ShaderCodeView& code);
 
 		/**
 		 * Initialize the shader.
@@ -175,13 +239,14 @@ namespace Firefly
 		 *
 		 * @param shaderCode The shader source code.
 		 */
-		void initialize(const ShaderCode& shaderCode);
+		void initialize(const ShaderCodeView& shaderCode);
 
 	private:
 		std::unordered_map<std::string, ShaderBinding> m_Bindings;
 		std::vector<ShaderAttribute> m_InputAttributes;
 		std::vector<ShaderAttribute> m_OutputAttributes;
 		std::vector<VkPushConstantRange> m_PushConstants;
+		std::unordered_map<uint32_t, uint32_t> m_SpecializationConstants;
 
 		VkShaderModule m_vShaderModule = VK_NULL_HANDLE;
 		VkDescriptorSetLayout m_vDescriptorSetLayout = VK_NULL_HANDLE;
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "Shader.hpp"
+
+#include <string_view>
+
+namespace Firefly
+{
+	/**
+	 * Shader archive object.
+	 * A shader archive packs many SPIR-V binaries into a single file, which is memory mapped when opened. Shaders created from the archive read the
+	 * code straight from the mapping, so loading them costs page faults instead of file reads, allocations and copies.
+	 *
+	 * File layout (all values are in the byte order of the host that wrote the archive, as the code blobs are handed to Vulkan straight from the
+	 * mapping; an archive written on a host of the other byte order is rejected):
+	 * - Header:		magic ("FFSA"), version, entry count and string table size (4 x uint32_t).
+	 * - Entries:		name offset, name length, stage flags, reserved (4 x uint32_t), code offset and code size in bytes (2 x uint64_t).
+	 * - String table:	the entry names, not null terminated.
+	 * - Code blobs:	the SPIR-V binaries, each aligned to 4 bytes.
+	 *
+	 * Note: Make sure that the archive lives until all the shaders created from it are initialized.
+	 */
+	class ShaderArchive final
+	{
+	public:
+		FIREFLY_NO_COPY(ShaderArchive);
+
+		/**
+		 * Constructor.
+		 *
+		 * @param file The archive file path.
+		 * @throws BackendError if the file could not be mapped or if it is not a valid archive.
+		 */
+		explicit ShaderArchive(const std::filesystem::path& file);
+
+		/**
+		 * Destructor.
+		 */
+		~ShaderArchive();
+
+		/**
+		 * Check if the archive contains a shader.
+		 *
+		 * @param name The shader name.
+		 * @return Boolean stating if its present or not.
+		 */
+		bool contains(const std::string& name) const { return m_Entries.find(name) != m_Entries.end(); }
+
+		/**
+		 * Get the code of a shader.
+		 *
+		 * @param name The shader name.
+		 * @return The view to the mapped code.
+		 * @throws BackendError if the shader is not in the archive.
+		 */
+		ShaderCodeView getCode(const std::string& name) const;
+
+		/**
+		 * Get the stage flags of a shader.
+		 *
+		 * @param name The shader name.
+		 * @return The stage flags stored with the shader.
+		 * @throws BackendError if the shader is not in the archive.
+		 */
+		VkShaderStageFlags getFlags(const std::string& name) const;
+
+		/**
+		 * Get the names of all the shaders in the archive.
+		 *
+		 * @return The shader names.
+		 */
+		std::vector<std::string> getNames() const;
+
+		/**
+		 * Get the number of shaders in the archive.
+		 *
+		 * @return The shader count.
+		 */
+		uint64_t size() const { return m_Entries.size(); }
+
+	private:
+		/**
+		 * Map the archive file to memory.
+		 *
+		 * @param file The archive file path.
+		 */
+		void map(const std::filesystem::path& file);
+
+		/**
+		 * Unmap the archive file.
+		 */
+		void unmap();
+
+		/**
+		 * Parse the table of contents.
+		 */
+		void parse();
+
+	private:
+		struct Entry
+		{
+			ShaderCodeView m_Code = {};
+			VkShaderStageFlags m_Flags = 0;
+		};
+
+		std::unordered_map<std::string_view, Entry> m_Entries;
+
+		const uint8_t* m_pData = nullptr;
+		uint64_t m_Size = 0;
+
+		void* m_FileHandle = nullptr;
+		void* m_MappingHandle = nullptr;
+	};
+
+	/**
+	 * Shader archive writer object.
+	 * This collects shaders and writes them to an archive file. An existing archive can be merged in to grow it.
+	 */
+	class ShaderArchiveWriter final
+	{
+	public:
+		/**
+		 * Default constructor.
+		 */
+		ShaderArchiveWriter() = default;
+
+		/**
+		 * Add a shader to the archive.
+		 * If a shader with the same name exists, it is replaced.
+		 *
+		 * @param name The shader name.
+		 * @param code The shader code.
+		 * @param flags The shader stage flags.
+		 */
+		void add(const std::string& name, const ShaderCodeView& code, const VkShaderStageFlags flags);
+
+		/**
+		 * Add a shader file to the archive.
+		 * If a shader with the same name exists, it is replaced.
+		 *
+		 * @param name The shader name.
+		 * @param file The SPIR-V file path.
+		 * @param flags The shader stage flags.
+		 */
+		void add(const std::string& name, const std::filesystem::path& file, const VkShaderStageFlags flags);
+
+		/**
+		 * Add all the shaders of an existing archive.
+		 * Shaders with the same names are replaced.
+		 *
+		 * @param archive The archive to merge.
+		 */
+		void merge(const ShaderArchive& archive);
+
+		/**
+		 * Write the archive to a file.
+		 * The archive is first written to a temporary file which then replaces the destination, so an archive which is mapped from the same path
+		 * stays valid on POSIX systems. On Windows, make sure to close it before writing.
+		 *
+		 * @param file The archive file path.
+		 */
+		void write(const std::filesystem::path& file) const;
+
+	private:
+		struct Entry
+		{
+			Shader::ShaderCode m_Code;
+			VkShaderStageFlags m_Flags = 0;
+		};
+
+		std::map<std::string, Entry> m_Entries;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Shader.hpp"
+
+#include <mutex>
+
+namespace Firefly
+{
+	/**
+	 * Shader reflection structure.
+	 * This contains the reflection results of a shader which do not depend on the shader stage.
+	 */
+	struct ShaderReflection
+	{
+		std::vector<std::pair<std::string, ShaderBinding>> m_Bindings;	// In the order they were reflected.
+		std::vector<ShaderAttribute> m_InputAttributes;
+		std::vector<ShaderAttribute> m_OutputAttributes;
+		std::vector<VkPushConstantRange> m_PushConstants;				// The stage flags are not set.
+		std::unordered_map<uint32_t, uint32_t> m_SpecializationConstants;
+	};
+
+	/**
+	 * Shader reflection cache object.
+	 * This stores shader reflection results keyed by a hash of the SPIR-V code, so shaders which were seen before skip the reflection. The code is
+	 * stored along with the results and compared on lookup, so a hash collision is a miss and never returns another shader's reflection. The cache can
+	 * be saved to a file (for example next to the pipeline cache) and loaded on the next startup.
+	 *
+	 * The cache is thread safe.
+	 */
+	class ShaderReflectionCache final
+	{
+	public:
+		/**
+		 * Default constructor.
+		 */
+		ShaderReflectionCache() = default;
+
+		/**
+		 * Hash the SPIR-V code using FNV-1a.
+		 *
+		 * @param code The shader code.
+		 * @return The 64-bit hash.
+		 */
+		static uint64_t Hash(const ShaderCodeView& code);
+
+		/**
+		 * Find the reflection of a shader.
+		 *
+		 * @param code The shader code.
+		 * @param reflection The reflection to fill.
+		 * @return Boolean stating if the shader was found or not.
+		 */
+		bool find(const ShaderCodeView& code, ShaderReflection& reflection) const;
+
+		/**
+		 * Store the reflection of a shader.
+		 *
+		 * @param code The shader code.
+		 * @param reflection The reflection to store.
+		 */
+		void store(const ShaderCodeView& code, const ShaderReflection& reflection);
+
+		/**
+		 * Serialize the cache to a binary blob.
+		 *
+		 * @return The serialized cache.
+		 */
+		std::vector<uint8_t> serialize() const;
+
+		/**
+		 * Load entries from a serialized cache.
+		 * Invalid data is ignored, and the entries which were read until then are kept.
+		 *
+		 * @param pData The serialized data.
+		 * @param size The size of the data in bytes.
+		 * @return Boolean stating if the whole blob was valid or not.
+		 */
+		bool deserialize(const uint8_t* pData, const uint64_t size);
+
+		/**
+		 * Save the cache to a file.
+		 *
+		 * @param file The file path.
+		 */
+		void save(const std::filesystem::path& file) const;
+
+		/**
+		 * Load the cache from a file.
+		 * A missing or invalid file is not an error, the shaders will just be reflected again.
+		 *
+		 * @param file The file path.
+		 * @return Boolean stating if the cache was loaded or not.
+		 */
+		bool load(const std::filesystem::path& file);
+
+		/**
+		 * Get the number of cached shaders.
+		 *
+		 * @return The entry count.
+		 */
+		uint64_t size() const;
+
+	private:
+		struct Entry
+		{
+			ShaderReflection m_Reflection;
+			std::vector<uint32_t> m_Code;
+		};
+
+		std::unordered_map<uint64_t, Entry> m_Entries;
+		mutable std::mutex m_Mutex;
+	};
+}
\ No newline at end of file
@@ -1,11 +1,16 @@
 #include "Firefly/AssetsLoaders/ImageLoader.hpp"
+#include "Firefly/AssetsLoaders/KTX2Loader.hpp"
 
 #include <stb/stb_image.h>
 
 namespace Firefly
 {
-	std::shared_ptr<Image> LoadImageFromFile(const std::shared_ptr<Engine>& pEngine, const std::filesystem::path& path)
+	std::shared_ptr<Image> LoadImageFromFile(const std::shared_ptr<Engine>& pEngine, const std::filesystem::path& path, const bool bGenerateMipMaps)
 	{
+		// KTX2 files contain GPU ready data, so they are uploaded as they are.
+		if (path.extension() == ".ktx2")
+			return LoadKTX2ImageFromFile(pEngine, path);
+
 		// Load the pixel data.
 		int width = 0, height = 0, channels = 0;
 		stbi_uc* pixels = stbi_load(path.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
@@ -14,22 +19,24 @@ namespace Firefly
 		if (!pixels)
 			throw BackendError("Could not load the asset image!");
 
-		// Create the copy buffer and copy the content to it.
-		const uint64_t imageSize = static_cast<uint64_t>(width) * height * channels;
-		auto pCopyBuffer = Firefly::Buffer::create(pEngine, imageSize, Firefly::BufferType::Staging);
+		// The pixels are always loaded with 4 channels.
+		const uint64_t imageSize = static_cast<uint64_t>(width) * height * STBI_rgb_alpha;
 
-		std::copy(pixels, pixels + imageSize, reinterpret_cast<stbi_uc*>(pCopyBuffer->mapMemory()));
-		pCopyBuffer->unmapMemory();
+		// Create the image and copy the pixels to it. The mip levels are generated while copying.
+		const VkExtent3D extent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
+		const auto mipLevels = bGenerateMipMaps ? Firefly::Image::GetMipLevelCount(extent) : 1;
+		auto pTexture = Firefly::Image::create(pEngine, extent, VkFormat::VK_FORMAT_R8G8B8A8_SRGB, Firefly::ImageType::TwoDimension, 1,
+			VkImageUsageFlagBits::VK_IMAGE_USAGE_SAMPLED_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_DST_BIT, mipLevels);
+		pTexture->fromMemory(pixels, imageSize);
 
-		// Create the image and copy the buffer to it.
-		auto pTexture = Firefly::Image::create(pEngine, { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 }, VkFormat::VK_FORMAT_R8G8B8A8_SRGB, Firefly::ImageType::TwoDimension);
-		pTexture->fromBuffer(pCopyBuffer.get());
+		// The image is handed out ready to be sampled. The transition follows the upload in the engine's command buffer.
+		pTexture->changeImageLayout(VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, pEngine->beginCommandBufferRecording());
 
 		std::free(pixels);
 		return pTexture;
 	}
 	
-	std::shared_ptr<Image> LoadImageFromMemory(const std::shared_ptr<Engine>& pEngine, const unsigned char* pImageData, const uint64_t size, const ImageDataFormat format)
+	std::shared_ptr<Image> LoadImageFromMemory(const std::shared_ptr<Engine>& pEngine, const unsigned char* pImageData, const uint64_t size, const ImageDataFormat format, const bool bGenerateMipMaps)
 	{
 		// Load the pixel data.
 		int width = 0, height = 0, channels = 0;
@@ -39,16 +46,18 @@ namespace Firefly
 		if (!pixels)
 			throw BackendError("Could not load the asset image!");
 
-		// Create the copy buffer and copy the content to it.
-		const uint64_t imageSize = static_cast<uint64_t>(width) * height * channels;
-		auto pCopyBuffer = Firefly::Buffer::create(pEngine, imageSize, Firefly::BufferType::Staging);
+		// The pixels are always loaded with 4 channels.
+		const uint64_t imageSize = static_cast<uint64_t>(width) * height * STBI_rgb_alpha;
 
-		std::copy(pixels, pixels + imageSize, reinterpret_cast<stbi_uc*>(pCopyBuffer->mapMemory()));
-		pCopyBuffer->unmapMemory();
+		// Create the image and copy the pixels to it. The mip levels are generated while copying.
+		const VkExtent3D extent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 };
+		const auto mipLevels = bGenerateMipMaps ? Firefly::Image::GetMipLevelCount(extent) : 1;
+		auto pTexture = Firefly::Image::create(pEngine, extent, VkFormat::VK_FORMAT_R8G8B8A8_SRGB, Firefly::ImageType::TwoDimension, 1,
+			VkImageUsageFlagBits::VK_IMAGE_USAGE_SAMPLED_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_DST_BIT, mipLevels);
+		pTexture->fromMemory(pixels, imageSize);
 
-		// Create the image and copy the buffer to it.
-		auto pTexture = Firefly::Image::create(pEngine, { static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1 }, VkFormat::VK_FORMAT_R8G8B8A8_SRGB, Firefly::ImageType::TwoDimension);
-		pTexture->fromBuffer(pCopyBuffer.get());
+		// The image is handed out ready to be sampled. The transition follows the upload in the engine's command buffer.
+		pTexture->changeImageLayout(VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, pEngine->beginCommandBufferRecording());
 
 		std::free(pixels);
 		return pTexture;
@@ -0,0 +1,554 @@
+#include "Firefly/AssetsLoaders/KTX2Loader.hpp"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+
+namespace /* anonymous */
+{
+	constexpr std::array<uint8_t, 12> KTX2Identifier = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+	/**
+	 * KTX2 file header structure.
+	 * This contains the header and the index section of the file.
+	 */
+	struct KTX2Header
+	{
+		uint8_t m_Identifier[12];
+		uint32_t m_Format;
+		uint32_t m_TypeSize;
+		uint32_t m_PixelWidth;
+		uint32_t m_PixelHeight;
+		uint32_t m_PixelDepth;
+		uint32_t m_LayerCount;
+		uint32_t m_FaceCount;
+		uint32_t m_LevelCount;
+		uint32_t m_SupercompressionScheme;
+
+		uint32_t m_DFDByteOffset;
+		uint32_t m_DFDByteLength;
+		uint32_t m_KVDByteOffset;
+		uint32_t m_KVDByteLength;
+		uint64_t m_SGDByteOffset;
+		uint64_t m_SGDByteLength;
+	};
+
+	static_assert(sizeof(KTX2Header) == 80, "The KTX2 header must match the file layout!");
+
+	/**
+	 * KTX2 level index structure.
+	 */
+	struct KTX2LevelIndex
+	{
+		uint64_t m_ByteOffset;
+		uint64_t m_ByteLength;
+		uint64_t m_UncompressedByteLength;
+	};
+
+	/**
+	 * Texel block structure.
+	 * Uncompressed formats have a block extent of a single texel.
+	 */
+	struct KTX2TexelBlock
+	{
+		uint32_t m_Width = 1;
+		uint32_t m_Height = 1;
+		uint32_t m_Size = 0;
+	};
+
+	/**
+	 * Get the texel block of a format.
+	 *
+	 * @param format The format.
+	 * @return The texel block. The size is 0 if the format is not supported.
+	 */
+	KTX2TexelBlock GetKTX2TexelBlock(const VkFormat format)
+	{
+		switch (format)
+		{
+		case VkFormat::VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_BC4_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_BC4_SNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_EAC_R11_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_EAC_R11_SNORM_BLOCK:
+			return { 4, 4, 8 };
+
+		case VkFormat::VK_FORMAT_BC2_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_BC2_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_BC3_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_BC3_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_BC5_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_BC5_SNORM_BLOCK:
+		case VkFormat::VK_FORMAT_BC6H_UFLOAT_BLOCK:
+		case VkFormat::VK_FORMAT_BC6H_SFLOAT_BLOCK:
+		case VkFormat::VK_FORMAT_BC7_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_BC7_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_4x4_SFLOAT_BLOCK:
+			return { 4, 4, 16 };
+
+		case VkFormat::VK_FORMAT_ASTC_5x4_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_5x4_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_5x4_SFLOAT_BLOCK:
+			return { 5, 4, 16 };
+
+		case VkFormat::VK_FORMAT_ASTC_5x5_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_5x5_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_5x5_SFLOAT_BLOCK:
+			return { 5, 5, 16 };
+
+		case VkFormat::VK_FORMAT_ASTC_6x5_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_6x5_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_6x5_SFLOAT_BLOCK:
+			return { 6, 5, 16 };
+
+		case VkFormat::VK_FORMAT_ASTC_6x6_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_6x6_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_6x6_SFLOAT_BLOCK:
+			return { 6, 6, 16 };
+
+		case VkFormat::VK_FORMAT_ASTC_8x5_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_8x5_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_8x5_SFLOAT_BLOCK:
+			return { 8, 5, 16 };
+
+		case VkFormat::VK_FORMAT_ASTC_8x6_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_8x6_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_8x6_SFLOAT_BLOCK:
+			return { 8, 6, 16 };
+
+		case VkFormat::VK_FORMAT_ASTC_8x8_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_8x8_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_8x8_SFLOAT_BLOCK:
+			return { 8, 8, 16 };
+
+		case VkFormat::VK_FORMAT_ASTC_10x5_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_10x5_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_10x5_SFLOAT_BLOCK:
+			return { 10, 5, 16 };
+
+		case VkFormat::VK_FORMAT_ASTC_10x6_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_10x6_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_10x6_SFLOAT_BLOCK:
+			return { 10, 6, 16 };
+
+		case VkFormat::VK_FORMAT_ASTC_10x8_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_10x8_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_10x8_SFLOAT_BLOCK:
+			return { 10, 8, 16 };
+
+		case VkFormat::VK_FORMAT_ASTC_10x10_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_10x10_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_10x10_SFLOAT_BLOCK:
+			return { 10, 10, 16 };
+
+		case VkFormat::VK_FORMAT_ASTC_12x10_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_12x10_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_12x10_SFLOAT_BLOCK:
+			return { 12, 10, 16 };
+
+		case VkFormat::VK_FORMAT_ASTC_12x12_UNORM_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_12x12_SRGB_BLOCK:
+		case VkFormat::VK_FORMAT_ASTC_12x12_SFLOAT_BLOCK:
+			return { 12, 12, 16 };
+
+		default:
+			return { 1, 1, Firefly::Image::GetPixelSize(format) };
+		}
+	}
+
+	/**
+	 * Block decoder enum.
+	 * This specifies the CPU decoder to use when the device does not support a block compressed format.
+	 */
+	enum class BlockDecoder : uint8_t
+	{
+		None,
+		BC1,
+		BC1Alpha,
+		BC2,
+		BC3,
+		BC4,
+		BC5
+	};
+
+	/**
+	 * Get the decoder and the uncompressed format to decode to of a block compressed format.
+	 *
+	 * @param format The block compressed format.
+	 * @return The decoder and the format. The decoder is None if the format cannot be decoded.
+	 */
+	std::pair<BlockDecoder, VkFormat> GetKTX2FallbackFormat(const VkFormat format)
+	{
+		switch (format)
+		{
+		case VkFormat::VK_FORMAT_BC1_RGB_UNORM_BLOCK:		return { BlockDecoder::BC1, VkFormat::VK_FORMAT_R8G8B8A8_UNORM };
+		case VkFormat::VK_FORMAT_BC1_RGB_SRGB_BLOCK:		return { BlockDecoder::BC1, VkFormat::VK_FORMAT_R8G8B8A8_SRGB };
+		case VkFormat::VK_FORMAT_BC1_RGBA_UNORM_BLOCK:		return { BlockDecoder::BC1Alpha, VkFormat::VK_FORMAT_R8G8B8A8_UNORM };
+		case VkFormat::VK_FORMAT_BC1_RGBA_SRGB_BLOCK:		return { BlockDecoder::BC1Alpha, VkFormat::VK_FORMAT_R8G8B8A8_SRGB };
+		case VkFormat::VK_FORMAT_BC2_UNORM_BLOCK:			return { BlockDecoder::BC2, VkFormat::VK_FORMAT_R8G8B8A8_UNORM };
+		case VkFormat::VK_FORMAT_BC2_SRGB_BLOCK:			return { BlockDecoder::BC2, VkFormat::VK_FORMAT_R8G8B8A8_SRGB };
+		case VkFormat::VK_FORMAT_BC3_UNORM_BLOCK:			return { BlockDecoder::BC3, VkFormat::VK_FORMAT_R8G8B8A8_UNORM };
+		case VkFormat::VK_FORMAT_BC3_SRGB_BLOCK:			return { BlockDecoder::BC3, VkFormat::VK_FORMAT_R8G8B8A8_SRGB };
+		case VkFormat::VK_FORMAT_BC4_UNORM_BLOCK:			return { BlockDecoder::BC4, VkFormat::VK_FORMAT_R8G8B8A8_UNORM };
+		case VkFormat::VK_FORMAT_BC5_UNORM_BLOCK:			return { BlockDecoder::BC5, VkFormat::VK_FORMAT_R8G8B8A8_UNORM };
+		default:											return { BlockDecoder::None, VkFormat::VK_FORMAT_UNDEFINED };
+		}
+	}
+
+	/**
+	 * Decode a BC1 color block.
+	 *
+	 * @param pBlock The 8 byte block.
+	 * @param texels The 16 decoded RGBA8 texels.
+	 * @param bAllowTransparency Whether or not the 3 color mode has a transparent color. It's opaque black otherwise.
+	 * @param bForceFourColors Whether or not to always use the 4 color mode, like the color blocks of BC2 and BC3.
+	 */
+	void DecodeColorBlock(const uint8_t* pBlock, std::array<uint8_t, 64>& texels, const bool bAllowTransparency, const bool bForceFourColors)
+	{
+		uint16_t color0 = 0, color1 = 0;
+		uint32_t indexes = 0;
+		std::memcpy(&color0, pBlock, sizeof(uint16_t));
+		std::memcpy(&color1, pBlock + 2, sizeof(uint16_t));
+		std::memcpy(&indexes, pBlock + 4, sizeof(uint32_t));
+
+		// Expand the RGB565 end points to 8 bits per channel.
+		const auto expand = [](const uint16_t color) -> std::array<uint32_t, 3>
+		{
+			const uint32_t r = (color >> 11) & 0x1F;
+			const uint32_t g = (color >> 5) & 0x3F;
+			const uint32_t b = color & 0x1F;
+			return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+		};
+
+		const auto endPoint0 = expand(color0);
+		const auto endPoint1 = expand(color1);
+
+		std::array<std::array<uint8_t, 4>, 4> palette = {};
+		for (uint8_t channel = 0; channel < 3; channel++)
+		{
+			palette[0][channel] = static_cast<uint8_t>(endPoint0[channel]);
+			palette[1][channel] = static_cast<uint8_t>(endPoint1[channel]);
+
+			if (color0 > color1 || bForceFourColors)
+			{
+				palette[2][channel] = static_cast<uint8_t>((2 * endPoint0[channel] + endPoint1[channel]) / 3);
+				palette[3][channel] = static_cast<uint8_t>((endPoint0[channel] + 2 * endPoint1[channel]) / 3);
+			}
+			else
+			{
+				palette[2][channel] = static_cast<uint8_t>((endPoint0[channel] + endPoint1[channel]) / 2);
+				palette[3][channel] = 0;
+			}
+		}
+
+		palette[0][3] = palette[1][3] = palette[2][3] = 255;
+		palette[3][3] = (color0 <= color1 && !bForceFourColors && bAllowTransparency) ? 0 : 255;
+
+		for (uint8_t texel = 0; texel < 16; texel++)
+			std::memcpy(texels.data() + texel * 4, palette[(indexes >> (texel * 2)) & 0x3].data(), 4);
+	}
+
+	/**
+	 * Decode a BC4 block. This is also the alpha block of BC3 and each channel block of BC5.
+	 *
+	 * @param pBlock The 8 byte block.
+	 * @param texels The decoded RGBA8 texels.
+	 * @param channel The channel to write the values to.
+	 */
+	void DecodeChannelBlock(const uint8_t* pBlock, std::array<uint8_t, 64>& texels, const uint8_t channel)
+	{
+		const uint32_t value0 = pBlock[0];
+		const uint32_t value1 = pBlock[1];
+
+		std::array<uint8_t, 8> palette = {};
+		palette[0] = static_cast<uint8_t>(value0);
+		palette[1] = static_cast<uint8_t>(value1);
+
+		if (value0 > value1)
+		{
+			for (uint32_t i = 1; i < 7; i++)
+				palette[i + 1] = static_cast<uint8_t>(((7 - i) * value0 + i * value1) / 7);
+		}
+		else
+		{
+			for (uint32_t i = 1; i < 5; i++)
+				palette[i + 1] = static_cast<uint8_t>(((5 - i) * value0 + i * value1) / 5);
+
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		// The indexes are 3 bits each, packed in the remaining 6 bytes.
+		uint64_t indexes = 0;
+		std::memcpy(&indexes, pBlock + 2, 6);
+
+		for (uint8_t texel = 0; texel < 16; texel++)
+			texels[texel * 4 + channel] = palette[(indexes >> (texel * 3)) & 0x7];
+	}
+
+	/**
+	 * Decode a single 4x4 block.
+	 *
+	 * @param decoder The decoder to use.
+	 * @param pBlock The block data.
+	 * @param texels The 16 decoded RGBA8 texels.
+	 */
+	void DecodeBlock(const BlockDecoder decoder, const uint8_t* pBlock, std::array<uint8_t, 64>& texels)
+	{
+		switch (decoder)
+		{
+		case BlockDecoder::BC1:
+			DecodeColorBlock(pBlock, texels, false, false);
+			break;
+
+		case BlockDecoder::BC1Alpha:
+			DecodeColorBlock(pBlock, texels, true, false);
+			break;
+
+		case BlockDecoder::BC2:
+		{
+			DecodeColorBlock(pBlock + 8, texels, false, true);
+
+			// The alpha values are stored explicitly, 4 bits each.
+			uint64_t alphas = 0;
+			std::memcpy(&alphas, pBlock, sizeof(uint64_t));
+
+			for (uint8_t texel = 0; texel < 16; texel++)
+				texels[texel * 4 + 3] = static_cast<uint8_t>(((alphas >> (texel * 4)) & 0xF) * 17);
+
+			break;
+		}
+
+		case BlockDecoder::BC3:
+			DecodeColorBlock(pBlock + 8, texels, false, true);
+			DecodeChannelBlock(pBlock, texels, 3);
+			break;
+
+		case BlockDecoder::BC4:
+			texels.fill(0);
+			DecodeChannelBlock(pBlock, texels, 0);
+			for (uint8_t texel = 0; texel < 16; texel++)
+				texels[texel * 4 + 3] = 255;
+
+			break;
+
+		case BlockDecoder::BC5:
+			texels.fill(0);
+			DecodeChannelBlock(pBlock, texels, 0);
+			DecodeChannelBlock(pBlock + 8, texels, 1);
+			for (uint8_t texel = 0; texel < 16; texel++)
+				texels[texel * 4 + 3] = 255;
+
+			break;
+
+		default:
+			throw Firefly::BackendError("Invalid block decoder!");
+		}
+	}
+
+	/**
+	 * Decode a block compressed mip level to RGBA8.
+	 *
+	 * @param decoder The decoder to use.
+	 * @param pSource The level data. This contains all the layers of the level.
+	 * @param sourceSize The size of the level data.
+	 * @param width The width of the level.
+	 * @param height The height of the level.
+	 * @param layerCount The number of layers in the level.
+	 * @param pDestination The memory to write the texels to.
+	 * @throws BackendError if the level data is too small.
+	 */
+	void DecodeKTX2Level(const BlockDecoder decoder, const uint8_t* pSource, const uint64_t sourceSize, const uint32_t width, const uint32_t height, const uint32_t layerCount, uint8_t* pDestination)
+	{
+		const uint32_t blockSize = decoder == BlockDecoder::BC1 || decoder == BlockDecoder::BC1Alpha || decoder == BlockDecoder::BC4 ? 8 : 16;
+		const uint32_t blocksX = (width + 3) / 4;
+		const uint32_t blocksY = (height + 3) / 4;
+
+		const uint64_t sourceLayerSize = static_cast<uint64_t>(blocksX) * blocksY * blockSize;
+		const uint64_t destinationLayerSize = static_cast<uint64_t>(width) * height * 4;
+
+		if (sourceSize < sourceLayerSize * layerCount)
+			throw Firefly::BackendError("The KTX2 level data is smaller than its extent!");
+
+		std::array<uint8_t, 64> texels = {};
+		for (uint32_t layer = 0; layer < layerCount; layer++)
+		{
+			const auto pSourceLayer = pSource + sourceLayerSize * layer;
+			const auto pDestinationLayer = pDestination + destinationLayerSize * layer;
+
+			for (uint32_t blockY = 0; blockY < blocksY; blockY++)
+			{
+				for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+				{
+					DecodeBlock(decoder, pSourceLayer + (static_cast<uint64_t>(blockY) * blocksX + blockX) * blockSize, texels);
+
+					// Blocks on the edges can go past the extent.
+					for (uint32_t y = 0; y < 4 && blockY * 4 + y < height; y++)
+					{
+						for (uint32_t x = 0; x < 4 && blockX * 4 + x < width; x++)
+							std::memcpy(pDestinationLayer + ((static_cast<uint64_t>(blockY) * 4 + y) * width + blockX * 4 + x) * 4, texels.data() + (y * 4 + x) * 4, 4);
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	 * Align a staging buffer offset so that it suits every texel block size.
+	 *
+	 * @param offset The offset to align.
+	 * @return The aligned offset.
+	 */
+	constexpr uint64_t AlignKTX2Offset(const uint64_t offset) { return (offset + 15) & ~static_cast<uint64_t>(15); }
+}
+
+namespace Firefly
+{
+	std::shared_ptr<Image> LoadKTX2ImageFromFile(const std::shared_ptr<Engine>& pEngine, const std::filesystem::path& path)
+	{
+		std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+
+		// Check if we were able to open the file.
+		if (!file.is_open())
+			throw BackendError("Could not load the asset image!");
+
+		const auto size = static_cast<uint64_t>(file.tellg());
+		std::vector<unsigned char> data(size);
+
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size));
+
+		return LoadKTX2ImageFromMemory(pEngine, data.data(), size);
+	}
+
+	std::shared_ptr<Image> LoadKTX2ImageFromMemory(const std::shared_ptr<Engine>& pEngine, const unsigned char* pImageData, const uint64_t size)
+	{
+		// Read and validate the header.
+		if (size < sizeof(KTX2Header))
+			throw BackendError("The KTX2 data is too small!");
+
+		KTX2Header header = {};
+		std::memcpy(&header, pImageData, sizeof(KTX2Header));
+
+		if (std::memcmp(header.m_Identifier, KTX2Identifier.data(), KTX2Identifier.size()) != 0)
+			throw BackendError("The data is not a KTX2 file!");
+
+		if (header.m_Format == VkFormat::VK_FORMAT_UNDEFINED)
+			throw BackendError("Basis Universal KTX2 files are not supported!");
+
+		if (header.m_SupercompressionScheme != 0)
+			throw BackendError("Supercompressed KTX2 files are not supported!");
+
+		if (header.m_PixelDepth > 1 || header.m_LayerCount > 1)
+			throw BackendError("3D and array KTX2 images are not supported!");
+
+		if (header.m_FaceCount != 1 && header.m_FaceCount != 6)
+			throw BackendError("Invalid KTX2 face count!");
+
+		if (header.m_PixelWidth == 0)
+			throw BackendError("Invalid KTX2 pixel width!");
+
+		const VkExtent3D extent = { header.m_PixelWidth, std::max(header.m_PixelHeight, 1u), 1 };
+		const auto layerCount = header.m_FaceCount;
+
+		if (header.m_LevelCount > Image::GetMipLevelCount(extent))
+			throw BackendError("Invalid KTX2 level count!");
+
+		const auto vFileFormat = static_cast<VkFormat>(header.m_Format);
+		const auto texelBlock = GetKTX2TexelBlock(vFileFormat);
+		if (texelBlock.m_Size == 0)
+			throw BackendError("The KTX2 format is not supported!");
+
+		// Read the level index. A level count of 0 means that the mip levels are to be generated.
+		const auto fileLevelCount = std::max(header.m_LevelCount, 1u);
+		if (size < sizeof(KTX2Header) + sizeof(KTX2LevelIndex) * fileLevelCount)
+			throw BackendError("The KTX2 data is too small!");
+
+		std::vector<KTX2LevelIndex> levels(fileLevelCount);
+		std::memcpy(levels.data(), pImageData + sizeof(KTX2Header), sizeof(KTX2LevelIndex) * fileLevelCount);
+
+		for (uint32_t level = 0; level < fileLevelCount; level++)
+		{
+			if (levels[level].m_ByteOffset > size || levels[level].m_ByteLength > size - levels[level].m_ByteOffset)
+				throw BackendError("The KTX2 level data is out of bounds!");
+
+			// Levels are tightly packed, with all the faces of a level next to each other.
+			const uint64_t blocksX = (std::max(extent.width >> level, 1u) + texelBlock.m_Width - 1) / texelBlock.m_Width;
+			const uint64_t blocksY = (std::max(extent.height >> level, 1u) + texelBlock.m_Height - 1) / texelBlock.m_Height;
+			if (levels[level].m_ByteLength != blocksX * blocksY * texelBlock.m_Size * layerCount)
+				throw BackendError("The KTX2 level data size does not match its extent and format!");
+		}
+
+		// Use the format of the file if the device supports it. Else fall back to an uncompressed format which we can decode to.
+		const auto [decoder, vFallbackFormat] = GetKTX2FallbackFormat(vFileFormat);
+
+		std::vector<VkFormat> candidates = { vFileFormat };
+		if (decoder != BlockDecoder::None)
+			candidates.emplace_back(vFallbackFormat);
+
+		const auto vFormat = pEngine->findSupportedFormat(candidates, VkImageTiling::VK_IMAGE_TILING_OPTIMAL, VkFormatFeatureFlagBits::VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+		const auto bShouldDecode = vFormat != vFileFormat;
+
+		// Mip levels are generated by blitting, which block compressed formats do not support.
+		if (header.m_LevelCount == 0 && texelBlock.m_Width > 1 && !bShouldDecode)
+			throw BackendError("The KTX2 file uses a block compressed format but does not contain its mip levels, which cannot be generated!");
+
+		// Pack all the levels into the copy data.
+		std::vector<uint64_t> mipLevelOffsets(fileLevelCount);
+		uint64_t copySize = 0;
+		for (uint32_t level = 0; level < fileLevelCount; level++)
+		{
+			mipLevelOffsets[level] = copySize;
+
+			if (bShouldDecode)
+				copySize += AlignKTX2Offset(static_cast<uint64_t>(std::max(extent.width >> level, 1u)) * std::max(extent.height >> level, 1u) * 4 * layerCount);
+			else
+				copySize += AlignKTX2Offset(levels[level].m_ByteLength);
+		}
+
+		std::vector<uint8_t> copyData(copySize);
+		const auto pCopyData = copyData.data();
+
+		for (uint32_t level = 0; level < fileLevelCount; level++)
+		{
+			const auto pLevelData = pImageData + levels[level].m_ByteOffset;
+
+			if (bShouldDecode)
+				DecodeKTX2Level(decoder, pLevelData, levels[level].m_ByteLength, std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u), layerCount, pCopyData + mipLevelOffsets[level]);
+			else
+				std::copy(pLevelData, pLevelData + levels[level].m_ByteLength, pCopyData + mipLevelOffsets[level]);
+		}
+
+		// Create the image and copy the data to it.
+		const auto bShouldGenerateMipMaps = header.m_LevelCount == 0;
+		const auto mipLevels = bShouldGenerateMipMaps ? Image::GetMipLevelCount(extent) : fileLevelCount;
+		const auto type = layerCount == 6 ? ImageType::CubeMap : ImageType::TwoDimension;
+
+		auto pTexture = Image::create(pEngine, extent, vFormat, type, layerCount,
+			VkImageUsageFlagBits::VK_IMAGE_USAGE_SAMPLED_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_DST_BIT, mipLevels);
+
+		// Copying the base level generates the rest of the levels.
+		if (bShouldGenerateMipMaps)
+			pTexture->fromMemory(copyData.data(), copySize);
+		else
+			pTexture->fromMemory(copyData.data(), copySize, mipLevelOffsets);
+
+		// The image is handed out ready to be sampled. The transition follows the upload in the engine's command buffer.
+		pTexture->changeImageLayout(VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, pEngine->beginCommandBufferRecording());
+
+		return pTexture;
+	}
+}
\ No newline at end of file
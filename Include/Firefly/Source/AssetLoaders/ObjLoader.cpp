@@ -2,6 +2,7 @@
 
 #include <tinyobjloader/tiny_obj_loader.h>
 #include <unordered_map>
+#include <algorithm>
 
 namespace Firefly
 {
@@ -67,6 +68,19 @@ namespace Firefly
 			model.m_VertexCount = vertices.size();
 			model.m_VertexBuffer = Buffer::create(pEngine, size, BufferType::Vertex);
 			model.m_VertexBuffer->fromBuffer(pStagingBuffer.get());
+		}
+
+		// Copy the position data.
+		{
+			// Create the staging buffer and copy the positions to it.
+			const auto size = vertices.size() * sizeof(glm::vec3);
+			auto pStagingBuffer = Buffer::create(pEngine, size, BufferType::Staging);
+			std::transform(vertices.begin(), vertices.end(), reinterpret_cast<glm::vec3*>(pStagingBuffer->mapMemory()), [](const ObjVertex& vertex) { return vertex.m_Position; });
+			pStagingBuffer->unmapMemory();
+
+			// Create the position buffer and copy the content to it.
+			model.m_PositionBuffer = Buffer::create(pEngine, size, BufferType::Vertex);
+			model.m_PositionBuffer->fromBuffer(pStagingBuffer.get());
 			vertices.clear();
 		}
 
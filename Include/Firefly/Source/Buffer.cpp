@@ -89,6 +89,7 @@ namespace Firefly
 		{
 		case Firefly::BufferType::Vertex:
 		case Firefly::BufferType::Index:
+		case Firefly::BufferType::Storage:
 			m_MemoryUsage = VmaMemoryUsage::VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
 			break;
 
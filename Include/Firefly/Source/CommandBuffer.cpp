@@ -1,14 +1,108 @@
 #include "Firefly/CommandBuffer.hpp"
 #include "Firefly/Graphics/RenderTarget.hpp"
 #include "Firefly/Graphics/GraphicsPipeline.hpp"
+#include "Firefly/Graphics/BindlessTable.hpp"
 
 #include <array>
+#include <algorithm>
 
 #ifdef max
 #undef max
 
 #endif
 
+namespace /* anonymous */
+{
+	/**
+	 * Create an image memory barrier which transitions an attachment from an undefined layout.
+	 * The previous contents are discarded as the attachments are cleared when rendering begins. The transition still has to wait for the
+	 * previous frame's accesses to the same image, as frames can be submitted without waiting.
+	 *
+	 * @param pImage The attachment image.
+	 * @param vNewLayout The layout to transition to.
+	 * @param vAspectFlags The image aspect flags.
+	 * @param vSrcAccessMask The source access mask.
+	 * @param vSrcStageMask The source stage mask.
+	 * @param vDstAccessMask The destination access mask.
+	 * @param vDstStageMask The destination stage mask.
+	 * @return The image memory barrier.
+	 */
+	VkImageMemoryBarrier2 CreateAttachmentBarrier(const Firefly::Image* pImage, const VkImageLayout vNewLayout, const VkImageAspectFlags vAspectFlags, const VkAccessFlags2 vSrcAccessMask,
+		const VkPipelineStageFlags2 vSrcStageMask, const VkAccessFlags2 vDstAccessMask, const VkPipelineStageFlags2 vDstStageMask)
+	{
+		VkImageMemoryBarrier2 vBarrier = {};
+		vBarrier.sType = VkStructureType::VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+		vBarrier.pNext = VK_NULL_HANDLE;
+		vBarrier.srcStageMask = vSrcStageMask;
+		vBarrier.srcAccessMask = vSrcAccessMask;
+		vBarrier.dstStageMask = vDstStageMask;
+		vBarrier.dstAccessMask = vDstAccessMask;
+		vBarrier.oldLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED;
+		vBarrier.newLayout = vNewLayout;
+		vBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		vBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		vBarrier.image = pImage->getImage();
+		vBarrier.subresourceRange.aspectMask = vAspectFlags;
+		vBarrier.subresourceRange.baseMipLevel = 0;
+		vBarrier.subresourceRange.levelCount = 1;
+		vBarrier.subresourceRange.baseArrayLayer = 0;
+		vBarrier.subresourceRange.layerCount = 1;
+
+		return vBarrier;
+	}
+
+	/**
+	 * Count the number of descriptor sets which stay bound when switching from one pipeline layout to another.
+	 * Two layouts are compatible for a set if their push constant ranges and all the set layouts up to and including it are identical. Set
+	 * layouts and pipeline layouts are cached by the engine, so identical layouts have identical handles.
+	 *
+	 * @param vOldSetLayouts The set layouts of the bound pipeline layout.
+	 * @param vOldRanges The push constant ranges of the bound pipeline layout.
+	 * @param vNewSetLayouts The set layouts of the new pipeline layout.
+	 * @param vNewRanges The push constant ranges of the new pipeline layout.
+	 * @return The number of compatible sets.
+	 */
+	uint64_t CountCompatibleSets(const std::vector<VkDescriptorSetLayout>& vOldSetLayouts, const std::vector<VkPushConstantRange>& vOldRanges,
+		const std::vector<VkDescriptorSetLayout>& vNewSetLayouts, const std::vector<VkPushConstantRange>& vNewRanges)
+	{
+		const auto isSameRange = [](const VkPushConstantRange& lhs, const VkPushConstantRange& rhs)
+		{
+			return lhs.stageFlags == rhs.stageFlags && lhs.offset == rhs.offset && lhs.size == rhs.size;
+		};
+
+		if (!std::equal(vOldRanges.begin(), vOldRanges.end(), vNewRanges.begin(), vNewRanges.end(), isSameRange))
+			return 0;
+
+		const auto count = std::min(vOldSetLayouts.size(), vNewSetLayouts.size());
+		uint64_t compatibleCount = 0;
+		while (compatibleCount < count && vOldSetLayouts[compatibleCount] == vNewSetLayouts[compatibleCount])
+			compatibleCount++;
+
+		return compatibleCount;
+	}
+
+	/**
+	 * The name of the pipelines created for shader combinations.
+	 */
+	constexpr auto ShaderPipelineName = "ShaderPipeline";
+
+	/**
+	 * Create the specification of a shader combination pipeline.
+	 * The states are made dynamic if we can, so that the shaders map to a single pipeline.
+	 *
+	 * @param pEngine The engine pointer.
+	 * @param specification The requested specification.
+	 * @return The pipeline specification.
+	 */
+	Firefly::GraphicsPipelineSpecification CreateShaderPipelineSpecification(const Firefly::GraphicsEngine* pEngine, const Firefly::GraphicsPipelineSpecification& specification)
+	{
+		auto pipelineSpecification = specification;
+		pipelineSpecification.bUseExtendedDynamicState = pEngine->isExtendedDynamicStateSupported();
+
+		return pipelineSpecification;
+	}
+}
+
 namespace Firefly
 {
 	CommandBuffer::CommandBuffer(const std::shared_ptr<Engine>& pEngine, const VkCommandPool vCommandPool, const VkCommandBuffer vCommandBuffer)
@@ -25,32 +119,62 @@ namespace Firefly
 		return pointer;
 	}
 
-	void CommandBuffer::begin()
+	void CommandBuffer::begin(const VkCommandBufferUsageFlags vUsageFlags)
 	{
 		// If its in the recording state before this call, lets end it.
 		if (isRecording())
 			end();
 
+		// The command buffer cannot be recorded while its pending.
+		wait();
+
 		// Create the begin info structure.
 		VkCommandBufferBeginInfo vBeginInfo = {};
 		vBeginInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		vBeginInfo.pNext = nullptr;
-		vBeginInfo.flags = VkCommandBufferUsageFlagBits::VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vBeginInfo.flags = vUsageFlags;
 
 		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkBeginCommandBuffer(m_vCommandBuffer, &vBeginInfo), "Failed to begin command buffer recording!");
+
+		// The previous submission has finished, so the pipelines it used no longer need to be kept alive.
+		m_pShaderPipelines.clear();
+		m_RecordedPipelines.clear();
+		m_pBoundPipeline = nullptr;
+		m_pBoundRenderTarget = nullptr;
+		m_vBoundDescriptorSets.clear();
+		m_vBoundDescriptorSetLayouts.clear();
+		m_BoundPushConstantRanges.clear();
+		m_vBoundPipelineLayout = VK_NULL_HANDLE;
 		m_bIsRecording = true;
 	}
 
 	void CommandBuffer::bindRenderTarget(const RenderTarget* pRenderTarget, const std::vector<VkClearValue>& vClearColors) const
 	{
+		m_pBoundRenderTarget = pRenderTarget;
+
+		if (pRenderTarget->isDynamicRendering())
+		{
+			beginRendering(pRenderTarget, vClearColors);
+			return;
+		}
+
+		// The clear values follow the render pass attachment order. If a single color value is given, it's used for all the color attachments.
+		auto vClearValues = vClearColors;
+		const auto colorAttachmentCount = pRenderTarget->getColorAttachmentCount();
+		if (colorAttachmentCount > 1 && vClearColors.size() == 2)
+		{
+			vClearValues.assign(colorAttachmentCount, vClearColors.front());
+			vClearValues.emplace_back(vClearColors.back());
+		}
+
 		// Create the begin info structure.
 		VkRenderPassBeginInfo vBeginInfo = {};
 		vBeginInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 		vBeginInfo.pNext = VK_NULL_HANDLE;
 		vBeginInfo.renderPass = pRenderTarget->getRenderPass();
 		vBeginInfo.framebuffer = pRenderTarget->getCurrentFrameBuffer();
-		vBeginInfo.clearValueCount = static_cast<uint32_t>(vClearColors.size());
-		vBeginInfo.pClearValues = vClearColors.data();
+		vBeginInfo.clearValueCount = static_cast<uint32_t>(vClearValues.size());
+		vBeginInfo.pClearValues = vClearValues.data();
 		vBeginInfo.renderArea.extent.width = pRenderTarget->getExtent().width;
 		vBeginInfo.renderArea.extent.height = pRenderTarget->getExtent().height;
 
@@ -59,54 +183,109 @@ namespace Firefly
 
 	void CommandBuffer::unbindRenderTarget() const
 	{
-		getEngine()->getDeviceTable().vkCmdEndRenderPass(m_vCommandBuffer);
+		if (m_pBoundRenderTarget && m_pBoundRenderTarget->isDynamicRendering())
+			getEngine()->getDeviceTable().vkCmdEndRendering(m_vCommandBuffer);
+		else
+			getEngine()->getDeviceTable().vkCmdEndRenderPass(m_vCommandBuffer);
+
+		m_pBoundRenderTarget = nullptr;
+	}
+
+	void CommandBuffer::nextSubpass() const
+	{
+		getEngine()->getDeviceTable().vkCmdNextSubpass(m_vCommandBuffer, VkSubpassContents::VK_SUBPASS_CONTENTS_INLINE);
 	}
 
 	void CommandBuffer::bindGraphicsPipeline(const GraphicsPipeline* pPipeline) const
 	{
-		getEngine()->getDeviceTable().vkCmdBindPipeline(m_vCommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, pPipeline->getPipeline());
+		const auto vPipeline = pPipeline->getPipeline();
+		getEngine()->getDeviceTable().vkCmdBindPipeline(m_vCommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, vPipeline);
+		m_pBoundPipeline = pPipeline;
+
+		// Remember which Vulkan pipeline was recorded, so that we can tell when the pipeline swaps it.
+		if (std::find(m_RecordedPipelines.begin(), m_RecordedPipelines.end(), std::make_pair(pPipeline, vPipeline)) == m_RecordedPipelines.end())
+			m_RecordedPipelines.emplace_back(pPipeline, vPipeline);
 	}
 
 	void CommandBuffer::bindGraphicsPipeline(const GraphicsPipeline* pPipeline, const Package* pPackage) const
 	{
 		// First, bind the packages.
 		if (pPackage)
-		{
-			const auto vDescriptorSet = pPackage->getDescriptorSet();
-			getEngine()->getDeviceTable().vkCmdBindDescriptorSets(m_vCommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, pPipeline->getPipelineLayout(), pPackage->getSetIndex(), 1, &vDescriptorSet, 0, nullptr);
-		}
+			bindDescriptorSets(pPipeline, { { pPackage->getSetIndex(), pPackage->getDescriptorSet() } });
 
 		// Now we can bind the pipeline.
-		getEngine()->getDeviceTable().vkCmdBindPipeline(m_vCommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, pPipeline->getPipeline());
+		bindGraphicsPipeline(pPipeline);
 	}
 
 	void CommandBuffer::bindGraphicsPipeline(const GraphicsPipeline* pPipeline, const std::vector<Package*>& pPackages) const
 	{
-		int32_t firstSetIndex = -1;
-
 		// First, bind the packages.
-		std::vector<VkDescriptorSet> vDescriptorSets;
+		bindPackages(pPipeline, pPackages);
+
+		// Now we can bind the pipeline.
+		bindGraphicsPipeline(pPipeline);
+	}
+
+	void CommandBuffer::bindPackages(const GraphicsPipeline* pPipeline, const std::vector<Package*>& pPackages) const
+	{
+		std::vector<std::pair<uint32_t, VkDescriptorSet>> vDescriptorSets;
+		vDescriptorSets.reserve(pPackages.size());
+
+		// We only need to include the non-nullptr packages.
 		for (const auto pPackage : pPackages)
 		{
-			// We only need to include the non-nullptr packages.
 			if (pPackage)
-			{
-				vDescriptorSets.emplace_back(pPackage->getDescriptorSet());
-
-				if (firstSetIndex == -1)
-					firstSetIndex = pPackage->getSetIndex();
-			}
+				vDescriptorSets.emplace_back(pPackage->getSetIndex(), pPackage->getDescriptorSet());
 		}
 
-		// Bind the descriptor sets if available.
-		if (vDescriptorSets.size())
-		{
-			getEngine()->getDeviceTable().vkCmdBindDescriptorSets(m_vCommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS,
-				pPipeline->getPipelineLayout(), firstSetIndex, static_cast<uint32_t>(vDescriptorSets.size()), vDescriptorSets.data(), 0, nullptr);
-		}
+		bindDescriptorSets(pPipeline, vDescriptorSets);
+	}
 
-		// Now we can bind the pipeline.
-		getEngine()->getDeviceTable().vkCmdBindPipeline(m_vCommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS, pPipeline->getPipeline());
+	void CommandBuffer::bindBindlessTable(const GraphicsPipeline* pPipeline, const BindlessTable* pBindlessTable) const
+	{
+		if (pPipeline->getBindlessSetLayout() != pBindlessTable->getDescriptorSetLayout())
+			throw BackendError("The pipeline was not created with the bindless table's set layout!");
+
+		bindDescriptorSets(pPipeline, { { pPipeline->getBindlessSetIndex(), pBindlessTable->getDescriptorSet() } });
+	}
+
+	std::shared_ptr<GraphicsPipeline> CommandBuffer::prepareShaders(const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget) const
+	{
+		return prepareShaders(pShaders, pRenderTarget, GraphicsPipelineSpecification());
+	}
+
+	std::shared_ptr<GraphicsPipeline> CommandBuffer::prepareShaders(const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification) const
+	{
+		if (isRecording())
+			throw BackendError("Shaders must be prepared before the command buffer starts recording!");
+
+		const auto pEngine = std::static_pointer_cast<GraphicsEngine>(getEngine());
+		return GraphicsPipeline::createFastLinked(pEngine, ShaderPipelineName, pShaders, pRenderTarget, CreateShaderPipelineSpecification(pEngine.get(), specification));
+	}
+
+	std::shared_ptr<GraphicsPipeline> CommandBuffer::bindShaders(const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget) const
+	{
+		return bindShaders(pShaders, pRenderTarget, GraphicsPipelineSpecification());
+	}
+
+	std::shared_ptr<GraphicsPipeline> CommandBuffer::bindShaders(const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification) const
+	{
+		const auto pEngine = std::static_pointer_cast<GraphicsEngine>(getEngine());
+		const auto pipelineSpecification = CreateShaderPipelineSpecification(pEngine.get(), specification);
+
+		// Only prepared pipelines are used, so that nothing is compiled while recording.
+		const auto pPipeline = GraphicsPipeline::find(pEngine, ShaderPipelineName, pShaders, pRenderTarget, pipelineSpecification);
+		if (!pPipeline)
+			throw BackendError("The shaders were not prepared! Call prepareShaders() with the same shaders, render target and specification before recording.");
+
+		m_pShaderPipelines.insert(pPipeline);
+
+		bindGraphicsPipeline(pPipeline.get());
+
+		if (pipelineSpecification.bUseExtendedDynamicState)
+			setDynamicState(pipelineSpecification);
+
+		return pPipeline;
 	}
 
 	void CommandBuffer::bindVertexBuffer(const Buffer* pVertexBuffer) const
@@ -122,6 +301,19 @@ namespace Firefly
 		getEngine()->getDeviceTable().vkCmdBindVertexBuffers(m_vCommandBuffer, 0, 1, &vBuffer, offset.data());
 	}
 
+	void CommandBuffer::bindInstanceBuffer(const Buffer* pInstanceBuffer) const
+	{
+		// Validate the buffer type.
+		if (pInstanceBuffer->getType() != BufferType::Vertex)
+			throw BackendError("Cannot bind the buffer as an Instance buffer! The type must be Vertex.");
+
+		// The per instance inputs are read from the second binding.
+		constexpr std::array<VkDeviceSize, 1> offset = { 0 };
+		const auto vBuffer = pInstanceBuffer->getBuffer();
+
+		getEngine()->getDeviceTable().vkCmdBindVertexBuffers(m_vCommandBuffer, 1, 1, &vBuffer, offset.data());
+	}
+
 	void CommandBuffer::bindIndexBuffer(const Buffer* pIndexBuffer, const VkIndexType indexType) const
 	{
 		// Validate the buffer type.
@@ -142,14 +334,108 @@ namespace Firefly
 		getEngine()->getDeviceTable().vkCmdSetScissor(m_vCommandBuffer, 0, 1, &scissor);
 	}
 
-	void CommandBuffer::drawVertices(const uint32_t vertexCount) const
+	void CommandBuffer::setDynamicState(const GraphicsPipelineSpecification& specification) const
+	{
+		setCullMode(specification.vCullMode);
+		setFrontFace(specification.vFrontFace);
+		setPrimitiveTopology(specification.vPrimitiveTopology);
+		setDepthTestEnable(specification.bEnableDepthTest);
+		setDepthWriteEnable(specification.bEnableDepthWrite);
+		setDepthCompareOp(specification.vDepthCompareOp);
+		setDepthBiasEnable(false);
+		setPrimitiveRestartEnable(false);
+		setRasterizerDiscardEnable(false);
+	}
+
+	void CommandBuffer::setCullMode(const VkCullModeFlags vCullMode) const
+	{
+		getEngine()->getDeviceTable().vkCmdSetCullMode(m_vCommandBuffer, vCullMode);
+	}
+
+	void CommandBuffer::setFrontFace(const VkFrontFace vFrontFace) const
+	{
+		getEngine()->getDeviceTable().vkCmdSetFrontFace(m_vCommandBuffer, vFrontFace);
+	}
+
+	void CommandBuffer::setPrimitiveTopology(const VkPrimitiveTopology vPrimitiveTopology) const
+	{
+		getEngine()->getDeviceTable().vkCmdSetPrimitiveTopology(m_vCommandBuffer, vPrimitiveTopology);
+	}
+
+	void CommandBuffer::setDepthTestEnable(const bool bEnable) const
+	{
+		getEngine()->getDeviceTable().vkCmdSetDepthTestEnable(m_vCommandBuffer, bEnable ? VK_TRUE : VK_FALSE);
+	}
+
+	void CommandBuffer::setDepthWriteEnable(const bool bEnable) const
+	{
+		getEngine()->getDeviceTable().vkCmdSetDepthWriteEnable(m_vCommandBuffer, bEnable ? VK_TRUE : VK_FALSE);
+	}
+
+	void CommandBuffer::setDepthCompareOp(const VkCompareOp vCompareOp) const
+	{
+		getEngine()->getDeviceTable().vkCmdSetDepthCompareOp(m_vCommandBuffer, vCompareOp);
+	}
+
+	void CommandBuffer::setDepthBiasEnable(const bool bEnable) const
+	{
+		getEngine()->getDeviceTable().vkCmdSetDepthBiasEnable(m_vCommandBuffer, bEnable ? VK_TRUE : VK_FALSE);
+	}
+
+	void CommandBuffer::setPrimitiveRestartEnable(const bool bEnable) const
+	{
+		getEngine()->getDeviceTable().vkCmdSetPrimitiveRestartEnable(m_vCommandBuffer, bEnable ? VK_TRUE : VK_FALSE);
+	}
+
+	void CommandBuffer::setRasterizerDiscardEnable(const bool bEnable) const
+	{
+		getEngine()->getDeviceTable().vkCmdSetRasterizerDiscardEnable(m_vCommandBuffer, bEnable ? VK_TRUE : VK_FALSE);
+	}
+
+	void CommandBuffer::pushConstants(const VkShaderStageFlags vStageFlags, const uint32_t offset, const uint32_t size, const void* pData) const
+	{
+		if (!m_pBoundPipeline)
+			throw BackendError("Cannot update push constants without a bound graphics pipeline!");
+
+		// Every range overlapping the updated bytes must have all of its stages specified.
+		VkShaderStageFlags vRequiredStageFlags = 0;
+		for (const auto& vRange : m_pBoundPipeline->getPushConstantRanges())
+		{
+			if (offset < vRange.offset + vRange.size && vRange.offset < offset + size)
+				vRequiredStageFlags |= vRange.stageFlags;
+		}
+
+		if (vRequiredStageFlags == 0 || (vStageFlags & ~vRequiredStageFlags) != 0)
+			throw BackendError("The push constant update does not match the push constant ranges of the bound pipeline!");
+
+		if (size == 0 || offset % 4 != 0 || size % 4 != 0)
+			throw BackendError("The push constant offset and size must be non-zero multiples of 4!");
+
+		// Every updated word must be covered by a range of each of the stages. Else the update would write bytes which a stage does not declare.
+		for (uint32_t word = offset; word < offset + size; word += 4)
+		{
+			VkShaderStageFlags vCoveredStageFlags = 0;
+			for (const auto& vRange : m_pBoundPipeline->getPushConstantRanges())
+			{
+				if (vRange.offset <= word && word < vRange.offset + vRange.size)
+					vCoveredStageFlags |= vRange.stageFlags;
+			}
+
+			if (vCoveredStageFlags != vRequiredStageFlags)
+				throw BackendError("The push constant update is not covered by the push constant ranges of the bound pipeline!");
+		}
+
+		getEngine()->getDeviceTable().vkCmdPushConstants(m_vCommandBuffer, m_pBoundPipeline->getPipelineLayout(), vRequiredStageFlags, offset, size, pData);
+	}
+
+	void CommandBuffer::drawVertices(const uint32_t vertexCount, const uint32_t instanceCount, const uint32_t firstVertex, const uint32_t firstInstance) const
 	{
-		getEngine()->getDeviceTable().vkCmdDraw(m_vCommandBuffer, vertexCount, 1, 0, 0);
+		getEngine()->getDeviceTable().vkCmdDraw(m_vCommandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
 	}
 
-	void CommandBuffer::drawIndices(const uint32_t indexCount, const uint32_t vertexOffset) const
+	void CommandBuffer::drawIndices(const uint32_t indexCount, const uint32_t vertexOffset, const uint32_t instanceCount, const uint32_t firstIndex, const uint32_t firstInstance) const
 	{
-		getEngine()->getDeviceTable().vkCmdDrawIndexed(m_vCommandBuffer, indexCount, 1, 0, vertexOffset, 0);
+		getEngine()->getDeviceTable().vkCmdDrawIndexed(m_vCommandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
 	}
 
 	void CommandBuffer::end()
@@ -182,35 +468,47 @@ namespace Firefly
 		//vSubmitInfo.waitSemaphoreCount = 1;
 		//vSubmitInfo.pWaitSemaphores = &m_vInFlightSemaphore;
 
-		VkFence vFence = VK_NULL_HANDLE;
-
-		// Create the fence if we need to wait.
-		if (shouldWait)
-		{
-			VkFenceCreateInfo vFenceCreateInfo = {};
-			vFenceCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-			vFenceCreateInfo.pNext = VK_NULL_HANDLE;
-			vFenceCreateInfo.flags = 0;
+		// Transitions and uploads which were deferred by the engine are executed first.
+		getEngine()->submitPendingCommands();
 
-			FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkCreateFence(getEngine()->getLogicalDevice(), &vFenceCreateInfo, nullptr, &vFence), "Failed to create the synchronization fence!");
-		}
+		// The previous submission must have finished before the fence can be reused.
+		wait();
+		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkResetFences(getEngine()->getLogicalDevice(), 1, &m_vFence), "Failed to reset the synchronization fence!");
 
 		// Submit the queue.
-		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkQueueSubmit(queue.getQueue(), 1, &vSubmitInfo, vFence), "Failed to submit the queue!");
+		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkQueueSubmit(queue.getQueue(), 1, &vSubmitInfo, m_vFence), "Failed to submit the queue!");
 
-		// Destroy the fence if we created it.
 		if (shouldWait)
-		{
-			FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkWaitForFences(getEngine()->getLogicalDevice(), 1, &vFence, VK_TRUE, std::numeric_limits<uint64_t>::max()), "Failed to wait for the fence!");
-			getEngine()->getDeviceTable().vkDestroyFence(getEngine()->getLogicalDevice(), vFence, nullptr);
-		}
+			wait();
+	}
+
+	void CommandBuffer::wait() const
+	{
+		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkWaitForFences(getEngine()->getLogicalDevice(), 1, &m_vFence, VK_TRUE, std::numeric_limits<uint64_t>::max()), "Failed to wait for the fence!");
+	}
+
+	bool CommandBuffer::isExecuted() const
+	{
+		const auto vResult = getEngine()->getDeviceTable().vkGetFenceStatus(getEngine()->getLogicalDevice(), m_vFence);
+		if (vResult == VkResult::VK_NOT_READY)
+			return false;
+
+		FIREFLY_VALIDATE(vResult, "Failed to query the fence status!");
+		return true;
+	}
+
+	bool CommandBuffer::hasOutdatedPipelines() const
+	{
+		return std::any_of(m_RecordedPipelines.begin(), m_RecordedPipelines.end(), [](const auto& recorded) { return recorded.first->getPipeline() != recorded.second; });
 	}
 
 	void CommandBuffer::terminate()
 	{
+		m_pShaderPipelines.clear();
 		getEngine()->getDeviceTable().vkFreeCommandBuffers(getEngine()->getLogicalDevice(), m_vCommandPool, 1, &m_vCommandBuffer);
 		getEngine()->getDeviceTable().vkDestroySemaphore(getEngine()->getLogicalDevice(), m_vInFlightSemaphore, nullptr);
 		getEngine()->getDeviceTable().vkDestroySemaphore(getEngine()->getLogicalDevice(), m_vRenderFinishedSemaphore, nullptr);
+		getEngine()->getDeviceTable().vkDestroyFence(getEngine()->getLogicalDevice(), m_vFence, nullptr);
 		toggleTerminated();
 	}
 	
@@ -218,6 +516,9 @@ namespace Firefly
 	{
 		// Create the semaphores.
 		createSemaphores();
+
+		// Create the fence.
+		createFence();
 	}
 
 	void CommandBuffer::createSemaphores()
@@ -231,4 +532,150 @@ namespace Firefly
 		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkCreateSemaphore(getEngine()->getLogicalDevice(), &vCreateInfo, nullptr, &m_vInFlightSemaphore), "Failed to create the in flight semaphore!");
 		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkCreateSemaphore(getEngine()->getLogicalDevice(), &vCreateInfo, nullptr, &m_vRenderFinishedSemaphore), "Failed to create the render finished semaphore!");
 	}
+
+	void CommandBuffer::createFence()
+	{
+		// The fence starts signaled as there is no pending submission to wait for.
+		VkFenceCreateInfo vCreateInfo = {};
+		vCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		vCreateInfo.pNext = nullptr;
+		vCreateInfo.flags = VkFenceCreateFlagBits::VK_FENCE_CREATE_SIGNALED_BIT;
+
+		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkCreateFence(getEngine()->getLogicalDevice(), &vCreateInfo, nullptr, &m_vFence), "Failed to create the synchronization fence!");
+	}
+
+	void CommandBuffer::beginRendering(const RenderTarget* pRenderTarget, const std::vector<VkClearValue>& vClearColors) const
+	{
+		const auto pColorAttachment = pRenderTarget->getColorAttachment();
+		const auto pDepthAttachment = pRenderTarget->getDepthAttachment();
+
+		const auto vDepthFormat = pDepthAttachment->getFormat();
+		const auto bHasStencil = vDepthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || vDepthFormat == VK_FORMAT_D24_UNORM_S8_UINT;
+
+		// Transition the attachments to their attachment layouts. There's no render pass to do this for us.
+		// The color attachment could have been written or resolved to, or copied out of by the previous frame. The depth attachment could
+		// have been written by the previous frame. All of them are recorded as a single pipeline barrier.
+		std::vector<VkImageMemoryBarrier2> vBarriers(2);
+		vBarriers[0] = CreateAttachmentBarrier(pColorAttachment.get(), VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+			VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+		vBarriers[1] = CreateAttachmentBarrier(pDepthAttachment.get(), VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			VkImageAspectFlagBits::VK_IMAGE_ASPECT_DEPTH_BIT | (bHasStencil ? VkImageAspectFlagBits::VK_IMAGE_ASPECT_STENCIL_BIT : 0),
+			VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT);
+
+		const auto pMultisampleColorAttachment = pRenderTarget->getMultisampleColorAttachment();
+		if (pMultisampleColorAttachment)
+		{
+			vBarriers.emplace_back(CreateAttachmentBarrier(pMultisampleColorAttachment.get(), VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT,
+				VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+				VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT));
+		}
+
+		getEngine()->recordImageBarriers(m_vCommandBuffer, vBarriers);
+
+		// Setup the attachments. The clear values follow the render pass order: color first and then depth.
+		VkRenderingAttachmentInfo vColorAttachmentInfo = {};
+		vColorAttachmentInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+		vColorAttachmentInfo.pNext = VK_NULL_HANDLE;
+		vColorAttachmentInfo.imageView = pColorAttachment->getImageView();
+		vColorAttachmentInfo.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		vColorAttachmentInfo.resolveMode = VkResolveModeFlagBits::VK_RESOLVE_MODE_NONE;
+		vColorAttachmentInfo.loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR;
+		vColorAttachmentInfo.storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_STORE;
+
+		if (vClearColors.size() > 0)
+			vColorAttachmentInfo.clearValue = vClearColors[0];
+
+		// When multisampling, the samples are resolved to the color attachment at the end of rendering and are not stored themselves.
+		if (pMultisampleColorAttachment)
+		{
+			vColorAttachmentInfo.imageView = pMultisampleColorAttachment->getImageView();
+			vColorAttachmentInfo.resolveMode = VkResolveModeFlagBits::VK_RESOLVE_MODE_AVERAGE_BIT;
+			vColorAttachmentInfo.resolveImageView = pColorAttachment->getImageView();
+			vColorAttachmentInfo.resolveImageLayout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			vColorAttachmentInfo.storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		}
+
+		VkRenderingAttachmentInfo vDepthAttachmentInfo = {};
+		vDepthAttachmentInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+		vDepthAttachmentInfo.pNext = VK_NULL_HANDLE;
+		vDepthAttachmentInfo.imageView = pDepthAttachment->getImageView();
+		vDepthAttachmentInfo.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		vDepthAttachmentInfo.resolveMode = VkResolveModeFlagBits::VK_RESOLVE_MODE_NONE;
+		vDepthAttachmentInfo.loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR;
+		vDepthAttachmentInfo.storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+		if (vClearColors.size() > 1)
+			vDepthAttachmentInfo.clearValue = vClearColors[1];
+
+		// Create the rendering info structure.
+		VkRenderingInfo vRenderingInfo = {};
+		vRenderingInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_RENDERING_INFO;
+		vRenderingInfo.pNext = VK_NULL_HANDLE;
+		vRenderingInfo.flags = 0;
+		vRenderingInfo.renderArea.extent.width = pRenderTarget->getExtent().width;
+		vRenderingInfo.renderArea.extent.height = pRenderTarget->getExtent().height;
+		vRenderingInfo.layerCount = 1;
+		vRenderingInfo.viewMask = 0;
+		vRenderingInfo.colorAttachmentCount = 1;
+		vRenderingInfo.pColorAttachments = &vColorAttachmentInfo;
+		vRenderingInfo.pDepthAttachment = &vDepthAttachmentInfo;
+		vRenderingInfo.pStencilAttachment = bHasStencil ? &vDepthAttachmentInfo : nullptr;
+
+		getEngine()->getDeviceTable().vkCmdBeginRendering(m_vCommandBuffer, &vRenderingInfo);
+	}
+
+	void CommandBuffer::bindDescriptorSets(const GraphicsPipeline* pPipeline, const std::vector<std::pair<uint32_t, VkDescriptorSet>>& vDescriptorSets) const
+	{
+		const auto vPipelineLayout = pPipeline->getPipelineLayout();
+		const auto& vSetLayouts = pPipeline->getDescriptorSetLayouts();
+
+		// If the layout changed, only the sets which are compatible with the new layout stay bound.
+		if (vPipelineLayout != m_vBoundPipelineLayout)
+		{
+			const auto compatibleCount = CountCompatibleSets(m_vBoundDescriptorSetLayouts, m_BoundPushConstantRanges, vSetLayouts, pPipeline->getPushConstantRanges());
+
+			m_vBoundDescriptorSets.resize(std::min(compatibleCount, m_vBoundDescriptorSets.size()));
+			m_vBoundDescriptorSets.resize(vSetLayouts.size(), VK_NULL_HANDLE);
+			m_vBoundDescriptorSetLayouts = vSetLayouts;
+			m_BoundPushConstantRanges = pPipeline->getPushConstantRanges();
+			m_vBoundPipelineLayout = vPipelineLayout;
+		}
+
+		// Bind the sets which changed, batching consecutive set indexes into a single call.
+		std::vector<VkDescriptorSet> vPendingSets;
+		uint32_t firstSetIndex = 0;
+
+		const auto flush = [this, vPipelineLayout, &vPendingSets, &firstSetIndex]
+		{
+			if (vPendingSets.empty())
+				return;
+
+			getEngine()->getDeviceTable().vkCmdBindDescriptorSets(m_vCommandBuffer, VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS,
+				vPipelineLayout, firstSetIndex, static_cast<uint32_t>(vPendingSets.size()), vPendingSets.data(), 0, nullptr);
+
+			vPendingSets.clear();
+		};
+
+		for (const auto& [setIndex, vDescriptorSet] : vDescriptorSets)
+		{
+			if (setIndex >= m_vBoundDescriptorSets.size())
+				throw BackendError("The package set index is out of the pipeline layout's range!");
+
+			if (m_vBoundDescriptorSets[setIndex] == vDescriptorSet)
+				continue;
+
+			if (vPendingSets.empty() || setIndex != firstSetIndex + vPendingSets.size())
+			{
+				flush();
+				firstSetIndex = setIndex;
+			}
+
+			vPendingSets.emplace_back(vDescriptorSet);
+			m_vBoundDescriptorSets[setIndex] = vDescriptorSet;
+		}
+
+		flush();
+	}
 }
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "Firefly/DescriptorAllocator.hpp"
+
+#include <map>
+
+namespace /* anonymous */
+{
+	constexpr uint32_t MaxBlockGrowthCount = 16;
+}
+
+namespace Firefly
+{
+	DescriptorAllocator::DescriptorAllocator(const std::shared_ptr<Engine>& pEngine, const std::vector<VkDescriptorPoolSize>& vPoolSizes, const uint32_t setsPerBlock)
+		: EngineBoundObject(pEngine), m_SetsPerBlock(setsPerBlock)
+	{
+		// Merge the counts of the same type and scale them to the block size.
+		std::map<VkDescriptorType, uint32_t> descriptorCounts;
+		for (const auto& vPoolSize : vPoolSizes)
+			descriptorCounts[vPoolSize.type] += vPoolSize.descriptorCount;
+
+		m_vPoolSizes.reserve(descriptorCounts.size());
+		for (const auto& [vType, count] : descriptorCounts)
+		{
+			if (count > 0)
+				m_vPoolSizes.emplace_back(VkDescriptorPoolSize{ vType, count * setsPerBlock });
+		}
+	}
+
+	DescriptorAllocator::~DescriptorAllocator()
+	{
+		if (!isTerminated())
+			terminate();
+	}
+
+	std::shared_ptr<DescriptorAllocator> DescriptorAllocator::create(const std::shared_ptr<Engine>& pEngine, const std::vector<VkDescriptorPoolSize>& vPoolSizes, const uint32_t setsPerBlock)
+	{
+		if (setsPerBlock == 0)
+			throw BackendError("The number of sets per block must not be 0!");
+
+		const auto pointer = std::make_shared<DescriptorAllocator>(pEngine, vPoolSizes, setsPerBlock);
+		FIREFLY_VALIDATE_OBJECT(pointer);
+
+		return pointer;
+	}
+
+	std::pair<VkDescriptorPool, VkDescriptorSet> DescriptorAllocator::allocate(const VkDescriptorSetLayout vDescriptorSetLayout)
+	{
+		VkDescriptorSetAllocateInfo vAllocateInfo = {};
+		vAllocateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		vAllocateInfo.pNext = nullptr;
+		vAllocateInfo.descriptorSetCount = 1;
+		vAllocateInfo.pSetLayouts = &vDescriptorSetLayout;
+
+		// Try the current block first, and move on to the next one when it runs out.
+		uint32_t growthCount = 0;
+		while (true)
+		{
+			bool bIsNewBlock = false;
+			if (m_CurrentBlock == m_vBlocks.size())
+			{
+				m_vBlocks.emplace_back(createBlock());
+				bIsNewBlock = true;
+			}
+
+			vAllocateInfo.descriptorPool = m_vBlocks[m_CurrentBlock];
+
+			VkDescriptorSet vDescriptorSet = VK_NULL_HANDLE;
+			const auto result = getEngine()->getDeviceTable().vkAllocateDescriptorSets(getEngine()->getLogicalDevice(), &vAllocateInfo, &vDescriptorSet);
+
+			if (result == VkResult::VK_SUCCESS)
+				return { vAllocateInfo.descriptorPool, vDescriptorSet };
+
+			if (result != VkResult::VK_ERROR_OUT_OF_POOL_MEMORY && result != VkResult::VK_ERROR_FRAGMENTED_POOL)
+				FIREFLY_VALIDATE(result, "Failed to allocate descriptor set!");
+
+			// If the set does not fit in an empty block, the blocks are too small for its layout. Double the descriptor counts of the blocks
+			// created from now on and replace the empty block. If that does not help, the layout uses a type which the blocks don't have.
+			if (bIsNewBlock)
+			{
+				if (++growthCount > MaxBlockGrowthCount)
+					throw BackendError("The descriptor set does not fit in a descriptor allocator block! Its layout uses descriptor types which the allocator was not created with.");
+
+				for (auto& vPoolSize : m_vPoolSizes)
+					vPoolSize.descriptorCount *= 2;
+
+				getEngine()->getDeviceTable().vkDestroyDescriptorPool(getEngine()->getLogicalDevice(), m_vBlocks.back(), nullptr);
+				m_vBlocks.pop_back();
+				continue;
+			}
+
+			m_CurrentBlock++;
+		}
+	}
+
+	void DescriptorAllocator::reset()
+	{
+		for (const auto vBlock : m_vBlocks)
+			getEngine()->getDeviceTable().vkResetDescriptorPool(getEngine()->getLogicalDevice(), vBlock, 0);
+
+		m_CurrentBlock = 0;
+	}
+
+	void DescriptorAllocator::terminate()
+	{
+		// Destroying the pools frees all the sets allocated from them.
+		for (const auto vBlock : m_vBlocks)
+			getEngine()->getDeviceTable().vkDestroyDescriptorPool(getEngine()->getLogicalDevice(), vBlock, nullptr);
+
+		m_vBlocks.clear();
+		m_CurrentBlock = 0;
+
+		toggleTerminated();
+	}
+
+	VkDescriptorPool DescriptorAllocator::createBlock() const
+	{
+		VkDescriptorPoolCreateInfo vCreateInfo = {};
+		vCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		vCreateInfo.flags = 0;
+		vCreateInfo.pNext = nullptr;
+		vCreateInfo.maxSets = m_SetsPerBlock;
+		vCreateInfo.poolSizeCount = static_cast<uint32_t>(m_vPoolSizes.size());
+		vCreateInfo.pPoolSizes = m_vPoolSizes.data();
+
+		VkDescriptorPool vDescriptorPool = VK_NULL_HANDLE;
+		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkCreateDescriptorPool(getEngine()->getLogicalDevice(), &vCreateInfo, nullptr, &vDescriptorPool), "Failed to create the descriptor pool!");
+
+		return vDescriptorPool;
+	}
+}
\ No newline at end of file
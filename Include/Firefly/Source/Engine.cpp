@@ -1,8 +1,11 @@
 #include "Firefly/Engine.hpp"
+#include "Firefly/ShaderReflectionCache.hpp"
 
 #include <set>
 #include <map>
 #include <array>
+#include <cstddef>
+#include <algorithm>
 
 #ifdef max
 #undef max
@@ -11,6 +14,8 @@
 
 namespace /* anonymous */
 {
+	constexpr uint64_t DefaultStagingBufferSize = 16 * 1024 * 1024;
+
 	VkPhysicalDeviceFeatures ResolvePhysicalDeviceFeatures(const VkPhysicalDevice vPhysicalDevice, const VkPhysicalDeviceFeatures& features)
 	{
 		VkPhysicalDeviceFeatures vAvailableFeatures = {};
@@ -75,6 +80,74 @@ namespace /* anonymous */
 		return vAvailableFeatures;
 	}
 
+	template<class Type>
+	void ResolveFeatureStructure(Type& features, const Type& availableFeatures)
+	{
+		// All the members after the structure header are VkBool32s.
+		constexpr auto offset = offsetof(Type, pNext) + sizeof(void*);
+		constexpr auto count = (sizeof(Type) - offset) / sizeof(VkBool32);
+
+		auto pFeatures = reinterpret_cast<VkBool32*>(reinterpret_cast<uint8_t*>(&features) + offset);
+		const auto pAvailableFeatures = reinterpret_cast<const VkBool32*>(reinterpret_cast<const uint8_t*>(&availableFeatures) + offset);
+
+		for (uint64_t i = 0; i < count; i++)
+			pFeatures[i] &= pAvailableFeatures[i];
+	}
+
+	template<class Type>
+	void AppendToLayoutKey(std::string& key, const Type& value)
+	{
+		key.append(reinterpret_cast<const char*>(&value), sizeof(Type));
+	}
+
+	std::string CreateDescriptorSetLayoutKey(const std::vector<VkDescriptorSetLayoutBinding>& vBindings, const VkDescriptorSetLayoutCreateFlags vFlags, const std::vector<VkDescriptorBindingFlags>& vBindingFlags)
+	{
+		// Sort the bindings so that the same bindings in a different order map to the same layout. The binding flags are sorted with them.
+		std::vector<std::pair<VkDescriptorSetLayoutBinding, VkDescriptorBindingFlags>> vSortedBindings;
+		vSortedBindings.reserve(vBindings.size());
+
+		for (uint64_t i = 0; i < vBindings.size(); i++)
+			vSortedBindings.emplace_back(vBindings[i], i < vBindingFlags.size() ? vBindingFlags[i] : 0);
+
+		std::sort(vSortedBindings.begin(), vSortedBindings.end(), [](const auto& lhs, const auto& rhs) { return lhs.first.binding < rhs.first.binding; });
+
+		std::string key;
+		AppendToLayoutKey(key, vFlags);
+
+		for (const auto& [vBinding, vBindingFlag] : vSortedBindings)
+		{
+			AppendToLayoutKey(key, vBinding.binding);
+			AppendToLayoutKey(key, vBinding.descriptorType);
+			AppendToLayoutKey(key, vBinding.descriptorCount);
+			AppendToLayoutKey(key, vBinding.stageFlags);
+			AppendToLayoutKey(key, vBindingFlag);
+
+			// Immutable samplers are part of the layout, so they are part of the key as well.
+			AppendToLayoutKey(key, vBinding.pImmutableSamplers != nullptr);
+			if (vBinding.pImmutableSamplers)
+				key.append(reinterpret_cast<const char*>(vBinding.pImmutableSamplers), sizeof(VkSampler) * vBinding.descriptorCount);
+		}
+
+		return key;
+	}
+
+	std::string CreatePipelineLayoutKey(const std::vector<VkDescriptorSetLayout>& vDescriptorSetLayouts, const std::vector<VkPushConstantRange>& vPushConstantRanges)
+	{
+		std::string key;
+		AppendToLayoutKey(key, static_cast<uint32_t>(vDescriptorSetLayouts.size()));
+		for (const auto vDescriptorSetLayout : vDescriptorSetLayouts)
+			AppendToLayoutKey(key, vDescriptorSetLayout);
+
+		for (const auto& vRange : vPushConstantRanges)
+		{
+			AppendToLayoutKey(key, vRange.stageFlags);
+			AppendToLayoutKey(key, vRange.offset);
+			AppendToLayoutKey(key, vRange.size);
+		}
+
+		return key;
+	}
+
 	bool CheckDeviceExtensionSupport(VkPhysicalDevice vPhysicalDevice, const std::vector<const char*>& deviceExtensions)
 	{
 		// Get the extension count.
@@ -121,12 +194,21 @@ namespace /* anonymous */
 namespace Firefly
 {
 	Engine::Engine(const std::shared_ptr<Instance>& pInstance)
-		: m_pInstance(pInstance)
+		: m_pInstance(pInstance), m_pShaderReflectionCache(std::make_shared<ShaderReflectionCache>())
 	{
+		m_Vulkan12Features.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		m_Vulkan13Features.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
 	}
 
 	Engine::~Engine()
 	{
+		// Destroy the cached layouts and samplers.
+		destroyLayouts();
+		destroySamplers();
+
+		// Destroy the staging memory.
+		destroyStagingBuffers();
+
 		// Destroy the memory manager.
 		destroyAllocator();
 
@@ -140,6 +222,137 @@ namespace Firefly
 		vkDestroyDevice(m_vLogicalDevice, nullptr);
 	}
 
+	VkDescriptorSetLayout Engine::getDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& vBindings, const VkDescriptorSetLayoutCreateFlags vFlags, const std::vector<VkDescriptorBindingFlags>& vBindingFlags)
+	{
+		if (!vBindingFlags.empty() && vBindingFlags.size() != vBindings.size())
+			throw BackendError("The binding flag count must match the binding count!");
+
+		const auto key = CreateDescriptorSetLayoutKey(vBindings, vFlags, vBindingFlags);
+		const auto lock = std::scoped_lock(m_LayoutMutex);
+
+		if (const auto itr = m_vDescriptorSetLayouts.find(key); itr != m_vDescriptorSetLayouts.end())
+			return itr->second;
+
+		// The binding flags are only chained if there are any.
+		VkDescriptorSetLayoutBindingFlagsCreateInfo vBindingFlagsCreateInfo = {};
+		vBindingFlagsCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		vBindingFlagsCreateInfo.pNext = nullptr;
+		vBindingFlagsCreateInfo.bindingCount = static_cast<uint32_t>(vBindingFlags.size());
+		vBindingFlagsCreateInfo.pBindingFlags = vBindingFlags.data();
+
+		VkDescriptorSetLayoutCreateInfo vCreateInfo = {};
+		vCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		vCreateInfo.pNext = vBindingFlags.empty() ? nullptr : &vBindingFlagsCreateInfo;
+		vCreateInfo.flags = vFlags;
+		vCreateInfo.bindingCount = static_cast<uint32_t>(vBindings.size());
+		vCreateInfo.pBindings = vBindings.data();
+
+		VkDescriptorSetLayout vDescriptorSetLayout = VK_NULL_HANDLE;
+		FIREFLY_VALIDATE(m_DeviceTable.vkCreateDescriptorSetLayout(m_vLogicalDevice, &vCreateInfo, nullptr, &vDescriptorSetLayout), "Failed to create descriptor set layout!");
+
+		m_vDescriptorSetLayouts[key] = vDescriptorSetLayout;
+		return vDescriptorSetLayout;
+	}
+
+	VkPipelineLayout Engine::getPipelineLayout(const std::vector<VkDescriptorSetLayout>& vDescriptorSetLayouts, const std::vector<VkPushConstantRange>& vPushConstantRanges)
+	{
+		const auto key = CreatePipelineLayoutKey(vDescriptorSetLayouts, vPushConstantRanges);
+		const auto lock = std::scoped_lock(m_LayoutMutex);
+
+		if (const auto itr = m_vPipelineLayouts.find(key); itr != m_vPipelineLayouts.end())
+			return itr->second;
+
+		VkPipelineLayoutCreateInfo vCreateInfo = {};
+		vCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		vCreateInfo.flags = 0;
+		vCreateInfo.pNext = nullptr;
+		vCreateInfo.setLayoutCount = static_cast<uint32_t>(vDescriptorSetLayouts.size());
+		vCreateInfo.pSetLayouts = vDescriptorSetLayouts.data();
+		vCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(vPushConstantRanges.size());
+		vCreateInfo.pPushConstantRanges = vPushConstantRanges.data();
+
+		VkPipelineLayout vPipelineLayout = VK_NULL_HANDLE;
+		FIREFLY_VALIDATE(m_DeviceTable.vkCreatePipelineLayout(m_vLogicalDevice, &vCreateInfo, nullptr, &vPipelineLayout), "Failed to create the pipeline layout!");
+
+		m_vPipelineLayouts[key] = vPipelineLayout;
+		return vPipelineLayout;
+	}
+
+	VkDescriptorUpdateTemplate Engine::getDescriptorUpdateTemplate(const VkDescriptorSetLayout vDescriptorSetLayout, const std::vector<VkDescriptorUpdateTemplateEntry>& vEntries)
+	{
+		// Descriptor update templates are core from Vulkan 1.1.
+		if (getAPIVersion() < VK_API_VERSION_1_1 || vEntries.empty())
+			return VK_NULL_HANDLE;
+
+		const auto lock = std::scoped_lock(m_LayoutMutex);
+		if (const auto itr = m_vDescriptorUpdateTemplates.find(vDescriptorSetLayout); itr != m_vDescriptorUpdateTemplates.end())
+			return itr->second;
+
+		VkDescriptorUpdateTemplateCreateInfo vCreateInfo = {};
+		vCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+		vCreateInfo.pNext = nullptr;
+		vCreateInfo.flags = 0;
+		vCreateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(vEntries.size());
+		vCreateInfo.pDescriptorUpdateEntries = vEntries.data();
+		vCreateInfo.templateType = VkDescriptorUpdateTemplateType::VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+		vCreateInfo.descriptorSetLayout = vDescriptorSetLayout;
+
+		VkDescriptorUpdateTemplate vDescriptorUpdateTemplate = VK_NULL_HANDLE;
+		FIREFLY_VALIDATE(m_DeviceTable.vkCreateDescriptorUpdateTemplate(m_vLogicalDevice, &vCreateInfo, nullptr, &vDescriptorUpdateTemplate), "Failed to create the descriptor update template!");
+
+		m_vDescriptorUpdateTemplates[vDescriptorSetLayout] = vDescriptorUpdateTemplate;
+		return vDescriptorUpdateTemplate;
+	}
+
+	VkSampler Engine::getSampler(const SamplerSpecification& specification)
+	{
+		// Clamp the anisotropy first, so that specifications which end up the same share a sampler.
+		const auto maxAnisotropy = std::min(specification.maxAnisotropy, m_Properties.limits.maxSamplerAnisotropy);
+		const auto bEnableAnisotropy = maxAnisotropy > 1.0f;
+
+		std::string key;
+		AppendToLayoutKey(key, specification.vMagFilter);
+		AppendToLayoutKey(key, specification.vMinFilter);
+		AppendToLayoutKey(key, specification.vMipmapMode);
+		AppendToLayoutKey(key, specification.vAddressMode);
+		AppendToLayoutKey(key, specification.vBorderColor);
+		AppendToLayoutKey(key, specification.bEnableCompare ? specification.vCompareOp : VkCompareOp::VK_COMPARE_OP_ALWAYS);
+		AppendToLayoutKey(key, bEnableAnisotropy ? maxAnisotropy : 1.0f);
+		AppendToLayoutKey(key, specification.minLod);
+		AppendToLayoutKey(key, specification.maxLod);
+		AppendToLayoutKey(key, specification.mipLodBias);
+
+		const auto lock = std::scoped_lock(m_SamplerMutex);
+		if (const auto itr = m_vSamplers.find(key); itr != m_vSamplers.end())
+			return itr->second;
+
+		VkSamplerCreateInfo vCreateInfo = {};
+		vCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		vCreateInfo.pNext = nullptr;
+		vCreateInfo.flags = 0;
+		vCreateInfo.magFilter = specification.vMagFilter;
+		vCreateInfo.minFilter = specification.vMinFilter;
+		vCreateInfo.addressModeU = specification.vAddressMode;
+		vCreateInfo.addressModeV = specification.vAddressMode;
+		vCreateInfo.addressModeW = specification.vAddressMode;
+		vCreateInfo.anisotropyEnable = bEnableAnisotropy ? VK_TRUE : VK_FALSE;
+		vCreateInfo.maxAnisotropy = bEnableAnisotropy ? maxAnisotropy : 1.0f;
+		vCreateInfo.borderColor = specification.vBorderColor;
+		vCreateInfo.unnormalizedCoordinates = VK_FALSE;
+		vCreateInfo.compareEnable = specification.bEnableCompare ? VK_TRUE : VK_FALSE;
+		vCreateInfo.compareOp = specification.bEnableCompare ? specification.vCompareOp : VkCompareOp::VK_COMPARE_OP_ALWAYS;
+		vCreateInfo.mipmapMode = specification.vMipmapMode;
+		vCreateInfo.minLod = specification.minLod;
+		vCreateInfo.maxLod = specification.maxLod;
+		vCreateInfo.mipLodBias = specification.mipLodBias;
+
+		VkSampler vSampler = VK_NULL_HANDLE;
+		FIREFLY_VALIDATE(m_DeviceTable.vkCreateSampler(m_vLogicalDevice, &vCreateInfo, nullptr, &vSampler), "Failed to create the sampler!");
+
+		m_vSamplers[key] = vSampler;
+		return vSampler;
+	}
+
 	VkCommandBuffer Engine::beginCommandBufferRecording()
 	{
 		// Skip if we're on the recording state.
@@ -154,6 +367,9 @@ namespace Firefly
 
 		FIREFLY_VALIDATE(m_DeviceTable.vkBeginCommandBuffer(m_vCommandBuffer, &vBeginInfo), "Failed to begin command buffer recording!");
 
+		// The queued transitions were requested before anything that is recorded from here.
+		recordQueuedImageBarriers(m_vCommandBuffer);
+
 		m_bIsCommandBufferRecording = true;
 		return m_vCommandBuffer;
 	}
@@ -171,9 +387,22 @@ namespace Firefly
 
 	void Engine::executeRecordedCommands(bool shouldWait)
 	{
+		// Transitions which were queued while recording are executed after the recorded commands.
+		if (m_bIsCommandBufferRecording)
+			recordQueuedImageBarriers(m_vCommandBuffer);
+
 		// End recording if we haven't.
 		endCommandBufferRecording();
 
+		// The staging memory can only be reused once the commands which read from it are done.
+		bool bReleaseStaging = false;
+		{
+			const auto lock = std::scoped_lock(m_StagingMutex);
+			bReleaseStaging = m_StagingOffset > 0;
+		}
+
+		shouldWait |= bReleaseStaging;
+
 		const auto queue = getQueue(VkQueueFlagBits::VK_QUEUE_TRANSFER_BIT);
 
 		VkSubmitInfo vSubmitInfo = {};
@@ -203,6 +432,128 @@ namespace Firefly
 			FIREFLY_VALIDATE(m_DeviceTable.vkWaitForFences(getLogicalDevice(), 1, &vFence, VK_TRUE, std::numeric_limits<uint64_t>::max()), "Failed to wait for the fence!");
 			m_DeviceTable.vkDestroyFence(getLogicalDevice(), vFence, nullptr);
 		}
+
+		if (bReleaseStaging)
+		{
+			const auto lock = std::scoped_lock(m_StagingMutex);
+
+			// Blocks which were chained are merged into a single one, so the same amount of uploads fits in a single block next time.
+			if (m_StagingBlocks.size() > 1)
+			{
+				uint64_t capacity = 0;
+				for (const auto& block : m_StagingBlocks)
+					capacity += block.m_Capacity;
+
+				destroyStagingBuffers();
+				m_StagingBlocks.emplace_back(createStagingBuffer(capacity));
+			}
+
+			m_StagingOffset = 0;
+		}
+	}
+
+	void Engine::queueImageBarriers(const std::vector<VkImageMemoryBarrier2>& vBarriers)
+	{
+		const auto lock = std::scoped_lock(m_BarrierMutex);
+		m_QueuedImageBarriers.insert(m_QueuedImageBarriers.end(), vBarriers.begin(), vBarriers.end());
+	}
+
+	void Engine::submitPendingCommands()
+	{
+		// Deferred uploads are the only commands which are left in the command buffer after returning to the user.
+		bool bHasStagedData = false;
+		{
+			const auto lock = std::scoped_lock(m_StagingMutex);
+			bHasStagedData = m_StagingOffset > 0;
+		}
+
+		if (!bHasStagedData)
+		{
+			const auto lock = std::scoped_lock(m_BarrierMutex);
+			if (m_QueuedImageBarriers.empty())
+				return;
+		}
+
+		// Recording and executing records the queued barriers.
+		beginCommandBufferRecording();
+		executeRecordedCommands();
+	}
+
+	std::pair<VkBuffer, uint64_t> Engine::stageData(const void* pData, const uint64_t size)
+	{
+		const auto lock = std::scoped_lock(m_StagingMutex);
+
+		// Copy offsets must be aligned to the texel block size, which is at most 16 bytes.
+		const auto alignment = std::max<uint64_t>(16, m_Properties.limits.optimalBufferCopyOffsetAlignment);
+		auto offset = (m_StagingOffset + alignment - 1) / alignment * alignment;
+
+		// If the data does not fit, chain a new block. The pending uploads keep reading from the previous blocks till they are executed.
+		if (m_StagingBlocks.empty() || offset + size > m_StagingBlocks.back().m_Capacity)
+		{
+			const auto previousCapacity = m_StagingBlocks.empty() ? 0 : m_StagingBlocks.back().m_Capacity;
+			m_StagingBlocks.emplace_back(createStagingBuffer(std::max({ size, previousCapacity * 2, DefaultStagingBufferSize })));
+			offset = 0;
+		}
+
+		const auto& block = m_StagingBlocks.back();
+		std::copy_n(static_cast<const std::byte*>(pData), size, block.m_pMemory + offset);
+		FIREFLY_VALIDATE(vmaFlushAllocation(m_vAllocator, block.m_Allocation, offset, size), "Failed to flush the staging memory!");
+
+		m_StagingOffset = offset + size;
+		return { block.m_vBuffer, offset };
+	}
+
+	void Engine::recordImageBarriers(const VkCommandBuffer vCommandBuffer, const std::vector<VkImageMemoryBarrier2>& vBarriers) const
+	{
+		if (vBarriers.empty())
+			return;
+
+		if (isSynchronization2Supported())
+		{
+			VkDependencyInfo vDependencyInfo = {};
+			vDependencyInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+			vDependencyInfo.pNext = nullptr;
+			vDependencyInfo.dependencyFlags = 0;
+			vDependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(vBarriers.size());
+			vDependencyInfo.pImageMemoryBarriers = vBarriers.data();
+
+			m_DeviceTable.vkCmdPipelineBarrier2(vCommandBuffer, &vDependencyInfo);
+			return;
+		}
+
+		// The legacy barrier has a single stage mask for all the barriers, so the stages are merged.
+		std::vector<VkImageMemoryBarrier> vLegacyBarriers;
+		vLegacyBarriers.reserve(vBarriers.size());
+
+		VkPipelineStageFlags vSourceStages = 0;
+		VkPipelineStageFlags vDestinationStages = 0;
+
+		for (const auto& vBarrier : vBarriers)
+		{
+			auto& vLegacyBarrier = vLegacyBarriers.emplace_back();
+			vLegacyBarrier.sType = VkStructureType::VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			vLegacyBarrier.pNext = nullptr;
+			vLegacyBarrier.srcAccessMask = static_cast<VkAccessFlags>(vBarrier.srcAccessMask);
+			vLegacyBarrier.dstAccessMask = static_cast<VkAccessFlags>(vBarrier.dstAccessMask);
+			vLegacyBarrier.oldLayout = vBarrier.oldLayout;
+			vLegacyBarrier.newLayout = vBarrier.newLayout;
+			vLegacyBarrier.srcQueueFamilyIndex = vBarrier.srcQueueFamilyIndex;
+			vLegacyBarrier.dstQueueFamilyIndex = vBarrier.dstQueueFamilyIndex;
+			vLegacyBarrier.image = vBarrier.image;
+			vLegacyBarrier.subresourceRange = vBarrier.subresourceRange;
+
+			vSourceStages |= static_cast<VkPipelineStageFlags>(vBarrier.srcStageMask);
+			vDestinationStages |= static_cast<VkPipelineStageFlags>(vBarrier.dstStageMask);
+		}
+
+		// Legacy barriers cannot have empty stage masks.
+		if (vSourceStages == 0)
+			vSourceStages = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+		if (vDestinationStages == 0)
+			vDestinationStages = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+		m_DeviceTable.vkCmdPipelineBarrier(vCommandBuffer, vSourceStages, vDestinationStages, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(vLegacyBarriers.size()), vLegacyBarriers.data());
 	}
 
 	Queue Engine::getQueue(const VkQueueFlagBits flag) const
@@ -210,6 +561,12 @@ namespace Firefly
 		return FindQueue(m_Queues, flag);
 	}
 
+	uint32_t Engine::getAPIVersion() const
+	{
+		const auto instanceVersion = m_pInstance->getVulkanVersion();
+		return instanceVersion < m_Properties.apiVersion ? instanceVersion : m_Properties.apiVersion;
+	}
+
 	VkFormat Engine::findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) const
 	{
 		for (const auto format : candidates)
@@ -417,14 +774,42 @@ namespace Firefly
 			vQueueCreateInfos.emplace_back(vQueueCreateInfo);
 		}
 
-		const auto vRequiredFeatures = ResolvePhysicalDeviceFeatures(m_vPhysicalDevice, features);
+		m_Features = ResolvePhysicalDeviceFeatures(m_vPhysicalDevice, features);
+
+		// Resolve the Vulkan 1.2 and 1.3 features. These can only be chained if the device supports the version.
+		const auto apiVersion = getAPIVersion();
+		if (apiVersion >= VK_API_VERSION_1_2)
+		{
+			VkPhysicalDeviceVulkan13Features vAvailableFeatures13 = {};
+			vAvailableFeatures13.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+
+			VkPhysicalDeviceVulkan12Features vAvailableFeatures12 = {};
+			vAvailableFeatures12.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+			vAvailableFeatures12.pNext = apiVersion >= VK_API_VERSION_1_3 ? &vAvailableFeatures13 : nullptr;
+
+			VkPhysicalDeviceFeatures2 vAvailableFeatures = {};
+			vAvailableFeatures.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			vAvailableFeatures.pNext = &vAvailableFeatures12;
+
+			vkGetPhysicalDeviceFeatures2(m_vPhysicalDevice, &vAvailableFeatures);
+
+			ResolveFeatureStructure(m_Vulkan12Features, vAvailableFeatures12);
+			ResolveFeatureStructure(m_Vulkan13Features, vAvailableFeatures13);
+			m_Vulkan12Features.pNext = apiVersion >= VK_API_VERSION_1_3 ? &m_Vulkan13Features : nullptr;
+		}
+		else
+		{
+			ResolveFeatureStructure(m_Vulkan12Features, VkPhysicalDeviceVulkan12Features());
+			ResolveFeatureStructure(m_Vulkan13Features, VkPhysicalDeviceVulkan13Features());
+		}
 
 		// Device create info.
 		VkDeviceCreateInfo vDeviceCreateInfo = {};
 		vDeviceCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		vDeviceCreateInfo.pNext = apiVersion >= VK_API_VERSION_1_2 ? &m_Vulkan12Features : nullptr;
 		vDeviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(vQueueCreateInfos.size());
 		vDeviceCreateInfo.pQueueCreateInfos = vQueueCreateInfos.data();
-		vDeviceCreateInfo.pEnabledFeatures = &vRequiredFeatures;
+		vDeviceCreateInfo.pEnabledFeatures = &m_Features;
 		vDeviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
 		vDeviceCreateInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -440,6 +825,7 @@ namespace Firefly
 
 		// Create the device.
 		FIREFLY_VALIDATE(vkCreateDevice(m_vPhysicalDevice, &vDeviceCreateInfo, nullptr, &m_vLogicalDevice), "Failed to create the logical device!");
+		m_Vulkan12Features.pNext = nullptr;
 
 		// Load the device table.
 		volkLoadDeviceTable(&m_DeviceTable, m_vLogicalDevice);
@@ -493,6 +879,40 @@ namespace Firefly
 		vmaDestroyAllocator(m_vAllocator);
 	}
 
+	Engine::StagingBlock Engine::createStagingBuffer(const uint64_t size) const
+	{
+		VkBufferCreateInfo vCreateInfo = {};
+		vCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		vCreateInfo.pNext = nullptr;
+		vCreateInfo.flags = 0;
+		vCreateInfo.size = size;
+		vCreateInfo.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE;
+		vCreateInfo.queueFamilyIndexCount = 0;
+		vCreateInfo.pQueueFamilyIndices = nullptr;
+		vCreateInfo.usage = VkBufferUsageFlagBits::VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+		// The memory stays mapped for the lifetime of the buffer.
+		VmaAllocationCreateInfo vmaAllocationCreateInfo = {};
+		vmaAllocationCreateInfo.usage = VmaMemoryUsage::VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+		vmaAllocationCreateInfo.flags = VmaAllocationCreateFlagBits::VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VmaAllocationCreateFlagBits::VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+		StagingBlock block;
+		VmaAllocationInfo vmaAllocationInfo = {};
+		FIREFLY_VALIDATE(vmaCreateBuffer(m_vAllocator, &vCreateInfo, &vmaAllocationCreateInfo, &block.m_vBuffer, &block.m_Allocation, &vmaAllocationInfo), "Failed to create the staging buffer!");
+
+		block.m_pMemory = static_cast<std::byte*>(vmaAllocationInfo.pMappedData);
+		block.m_Capacity = size;
+		return block;
+	}
+
+	void Engine::destroyStagingBuffers()
+	{
+		for (const auto& block : m_StagingBlocks)
+			vmaDestroyBuffer(m_vAllocator, block.m_vBuffer, block.m_Allocation);
+
+		m_StagingBlocks.clear();
+	}
+
 	void Engine::destroyCommandPool()
 	{
 		m_DeviceTable.vkDestroyCommandPool(getLogicalDevice(), m_vCommandPool, nullptr);
@@ -503,6 +923,53 @@ namespace Firefly
 		m_DeviceTable.vkFreeCommandBuffers(getLogicalDevice(), m_vCommandPool, 1, &m_vCommandBuffer);
 	}
 
+	void Engine::destroyLayouts()
+	{
+		for (const auto& [vDescriptorSetLayout, vDescriptorUpdateTemplate] : m_vDescriptorUpdateTemplates)
+			m_DeviceTable.vkDestroyDescriptorUpdateTemplate(m_vLogicalDevice, vDescriptorUpdateTemplate, nullptr);
+
+		for (const auto& [key, vPipelineLayout] : m_vPipelineLayouts)
+			m_DeviceTable.vkDestroyPipelineLayout(m_vLogicalDevice, vPipelineLayout, nullptr);
+
+		for (const auto& [key, vDescriptorSetLayout] : m_vDescriptorSetLayouts)
+			m_DeviceTable.vkDestroyDescriptorSetLayout(m_vLogicalDevice, vDescriptorSetLayout, nullptr);
+
+		m_vDescriptorUpdateTemplates.clear();
+		m_vPipelineLayouts.clear();
+		m_vDescriptorSetLayouts.clear();
+	}
+
+	void Engine::recordQueuedImageBarriers(const VkCommandBuffer vCommandBuffer)
+	{
+		std::vector<VkImageMemoryBarrier2> vBarriers;
+
+		{
+			const auto lock = std::scoped_lock(m_BarrierMutex);
+			vBarriers.swap(m_QueuedImageBarriers);
+		}
+
+		recordImageBarriers(vCommandBuffer, vBarriers);
+	}
+
+	void Engine::destroySamplers()
+	{
+		for (const auto& [key, vSampler] : m_vSamplers)
+			m_DeviceTable.vkDestroySampler(m_vLogicalDevice, vSampler, nullptr);
+
+		m_vSamplers.clear();
+	}
+
+	void Engine::requestFeatures(const VkPhysicalDeviceVulkan12Features& vFeatures12, const VkPhysicalDeviceVulkan13Features& vFeatures13)
+	{
+		m_Vulkan12Features = vFeatures12;
+		m_Vulkan12Features.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		m_Vulkan12Features.pNext = nullptr;
+
+		m_Vulkan13Features = vFeatures13;
+		m_Vulkan13Features.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+		m_Vulkan13Features.pNext = nullptr;
+	}
+
 	void Engine::initialize(VkQueueFlags flags, const std::vector<const char*>& extensions, const VkPhysicalDeviceFeatures& features)
 	{
 		// Validate the pointer.
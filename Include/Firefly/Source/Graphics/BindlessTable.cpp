@@ -0,0 +1,257 @@
+#include "Firefly/Graphics/BindlessTable.hpp"
+
+#include <array>
+#include <algorithm>
+
+namespace /* anonymous */
+{
+	constexpr uint32_t MaxBindlessImageCount = 1 << 16;
+}
+
+namespace Firefly
+{
+	BindlessTable::BindlessTable(const std::shared_ptr<GraphicsEngine>& pEngine, const uint32_t imageCapacity, const uint32_t bufferCapacity)
+		: EngineBoundObject(pEngine), m_ImageCapacity(imageCapacity), m_BufferCapacity(bufferCapacity)
+	{
+	}
+
+	BindlessTable::~BindlessTable()
+	{
+		if (!isTerminated())
+			terminate();
+	}
+
+	std::shared_ptr<BindlessTable> BindlessTable::create(const std::shared_ptr<GraphicsEngine>& pEngine, const uint32_t imageCapacity, const uint32_t bufferCapacity)
+	{
+		const auto pointer = std::make_shared<BindlessTable>(pEngine, imageCapacity, bufferCapacity);
+		FIREFLY_VALIDATE_OBJECT(pointer);
+
+		pointer->initialize();
+		return pointer;
+	}
+
+	uint32_t BindlessTable::registerImage(const std::shared_ptr<Image>& pImage)
+	{
+		const auto lock = std::scoped_lock(m_Mutex);
+		const auto index = AllocateIndex(m_FreeImageIndexes, m_NextImageIndex, m_ImageCapacity);
+
+		VkDescriptorImageInfo vImageInfo = {};
+		vImageInfo.sampler = pImage->getSampler();
+		vImageInfo.imageView = pImage->getImageView();
+		vImageInfo.imageLayout = pImage->getImageLayout();
+
+		VkWriteDescriptorSet vWrite = {};
+		vWrite.sType = VkStructureType::VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		vWrite.pNext = nullptr;
+		vWrite.pImageInfo = &vImageInfo;
+		vWrite.pBufferInfo = nullptr;
+		vWrite.pTexelBufferView = nullptr;
+		vWrite.dstSet = m_vDescriptorSet;
+		vWrite.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		vWrite.descriptorCount = 1;
+		vWrite.dstArrayElement = index;
+		vWrite.dstBinding = ImageBinding;
+
+		getEngine()->getDeviceTable().vkUpdateDescriptorSets(getEngine()->getLogicalDevice(), 1, &vWrite, 0, nullptr);
+
+		m_pImages[index] = pImage;
+		return index;
+	}
+
+	uint32_t BindlessTable::registerBuffer(const std::shared_ptr<Buffer>& pBuffer)
+	{
+		if (pBuffer->getType() != BufferType::Storage)
+			throw BackendError("Only storage buffers can be registered in the bindless table!");
+
+		const auto lock = std::scoped_lock(m_Mutex);
+		const auto index = AllocateIndex(m_FreeBufferIndexes, m_NextBufferIndex, m_BufferCapacity);
+
+		VkDescriptorBufferInfo vBufferInfo = {};
+		vBufferInfo.buffer = pBuffer->getBuffer();
+		vBufferInfo.offset = 0;
+		vBufferInfo.range = pBuffer->size();
+
+		VkWriteDescriptorSet vWrite = {};
+		vWrite.sType = VkStructureType::VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		vWrite.pNext = nullptr;
+		vWrite.pImageInfo = nullptr;
+		vWrite.pBufferInfo = &vBufferInfo;
+		vWrite.pTexelBufferView = nullptr;
+		vWrite.dstSet = m_vDescriptorSet;
+		vWrite.descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		vWrite.descriptorCount = 1;
+		vWrite.dstArrayElement = index;
+		vWrite.dstBinding = BufferBinding;
+
+		getEngine()->getDeviceTable().vkUpdateDescriptorSets(getEngine()->getLogicalDevice(), 1, &vWrite, 0, nullptr);
+
+		m_pBuffers[index] = pBuffer;
+		return index;
+	}
+
+	void BindlessTable::unregisterImage(const uint32_t index)
+	{
+		const auto lock = std::scoped_lock(m_Mutex);
+		if (index >= m_NextImageIndex || !m_pImages[index])
+			throw BackendError("The image index is not registered in the bindless table!");
+
+		// The descriptor is left as is. It is partially bound, so it does not need to be valid while it's not used.
+		m_CurrentReleases.m_pImages.emplace_back(std::move(m_pImages[index]));
+		m_CurrentReleases.m_ImageIndexes.emplace_back(index);
+	}
+
+	void BindlessTable::unregisterBuffer(const uint32_t index)
+	{
+		const auto lock = std::scoped_lock(m_Mutex);
+		if (index >= m_NextBufferIndex || !m_pBuffers[index])
+			throw BackendError("The buffer index is not registered in the bindless table!");
+
+		m_CurrentReleases.m_pBuffers.emplace_back(std::move(m_pBuffers[index]));
+		m_CurrentReleases.m_BufferIndexes.emplace_back(index);
+	}
+
+	void BindlessTable::endFrame(const std::shared_ptr<CommandBuffer>& pCommandBuffer)
+	{
+		const auto lock = std::scoped_lock(m_Mutex);
+
+		if (!m_CurrentReleases.m_ImageIndexes.empty() || !m_CurrentReleases.m_BufferIndexes.empty())
+		{
+			m_CurrentReleases.m_pCommandBuffer = pCommandBuffer;
+			m_PendingReleases.emplace_back(std::move(m_CurrentReleases));
+			m_CurrentReleases = ReleasedResources();
+		}
+
+		// A frame is done once its command buffer's fence is signaled. If the command buffer was submitted again since, the fence belongs to a
+		// later submission, which only signals after the frame is done as well.
+		const auto itr = std::remove_if(m_PendingReleases.begin(), m_PendingReleases.end(), [this](const ReleasedResources& releases)
+			{
+				if (!releases.m_pCommandBuffer->isExecuted())
+					return false;
+
+				m_FreeImageIndexes.insert(m_FreeImageIndexes.end(), releases.m_ImageIndexes.begin(), releases.m_ImageIndexes.end());
+				m_FreeBufferIndexes.insert(m_FreeBufferIndexes.end(), releases.m_BufferIndexes.begin(), releases.m_BufferIndexes.end());
+				return true;
+			});
+
+		m_PendingReleases.erase(itr, m_PendingReleases.end());
+	}
+
+	void BindlessTable::terminate()
+	{
+		// Destroying the pool frees the descriptor set. The layout is owned by the engine.
+		getEngine()->getDeviceTable().vkDestroyDescriptorPool(getEngine()->getLogicalDevice(), m_vDescriptorPool, nullptr);
+
+		m_pImages.clear();
+		m_pBuffers.clear();
+		m_CurrentReleases = ReleasedResources();
+		m_PendingReleases.clear();
+
+		toggleTerminated();
+	}
+
+	void BindlessTable::initialize()
+	{
+		if (!std::static_pointer_cast<GraphicsEngine>(getEngine())->isBindlessSupported())
+			throw BackendError("Bindless tables require descriptor indexing, which is not supported by the device!");
+
+		if (m_ImageCapacity == 0 || m_BufferCapacity == 0)
+			throw BackendError("The bindless table capacities must not be 0!");
+
+		m_pImages.resize(m_ImageCapacity);
+		m_pBuffers.resize(m_BufferCapacity);
+
+		createDescriptorSetLayout();
+		createDescriptorSet();
+	}
+
+	void BindlessTable::createDescriptorSetLayout()
+	{
+		VkPhysicalDeviceVulkan12Properties vProperties12 = {};
+		vProperties12.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 vProperties = {};
+		vProperties.sType = VkStructureType::VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		vProperties.pNext = &vProperties12;
+
+		vkGetPhysicalDeviceProperties2(getEngine()->getPhysicalDevice(), &vProperties);
+
+		// The image binding has a variable count, so its layout size is an upper bound which does not depend on the capacity. Only half of the
+		// limits are used, so that the other sets of the pipeline layout still have room.
+		const auto maxImageCount = std::min({ MaxBindlessImageCount, vProperties12.maxPerStageDescriptorUpdateAfterBindSampledImages / 2, vProperties12.maxDescriptorSetUpdateAfterBindSampledImages / 2 });
+		const auto maxBufferCount = std::min(vProperties12.maxPerStageDescriptorUpdateAfterBindStorageBuffers / 2, vProperties12.maxDescriptorSetUpdateAfterBindStorageBuffers / 2);
+
+		if (m_ImageCapacity > maxImageCount || m_BufferCapacity > maxBufferCount)
+			throw BackendError("The bindless table capacities exceed the device limits!");
+
+		std::vector<VkDescriptorSetLayoutBinding> vBindings(2);
+		vBindings[0].binding = BufferBinding;
+		vBindings[0].descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		vBindings[0].descriptorCount = m_BufferCapacity;
+		vBindings[0].stageFlags = VkShaderStageFlagBits::VK_SHADER_STAGE_ALL_GRAPHICS;
+		vBindings[0].pImmutableSamplers = nullptr;
+
+		vBindings[1].binding = ImageBinding;
+		vBindings[1].descriptorType = VkDescriptorType::VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		vBindings[1].descriptorCount = maxImageCount;
+		vBindings[1].stageFlags = VkShaderStageFlagBits::VK_SHADER_STAGE_ALL_GRAPHICS;
+		vBindings[1].pImmutableSamplers = nullptr;
+
+		constexpr VkDescriptorBindingFlags vBindingFlags = VkDescriptorBindingFlagBits::VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+			| VkDescriptorBindingFlagBits::VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT
+			| VkDescriptorBindingFlagBits::VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+
+		m_vDescriptorSetLayout = getEngine()->getDescriptorSetLayout(vBindings, VkDescriptorSetLayoutCreateFlagBits::VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+			{ vBindingFlags, vBindingFlags | VkDescriptorBindingFlagBits::VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT });
+	}
+
+	void BindlessTable::createDescriptorSet()
+	{
+		std::array<VkDescriptorPoolSize, 2> vPoolSizes = {};
+		vPoolSizes[0].type = VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		vPoolSizes[0].descriptorCount = m_BufferCapacity;
+		vPoolSizes[1].type = VkDescriptorType::VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		vPoolSizes[1].descriptorCount = m_ImageCapacity;
+
+		VkDescriptorPoolCreateInfo vCreateInfo = {};
+		vCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		vCreateInfo.flags = VkDescriptorPoolCreateFlagBits::VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		vCreateInfo.pNext = nullptr;
+		vCreateInfo.maxSets = 1;
+		vCreateInfo.poolSizeCount = static_cast<uint32_t>(vPoolSizes.size());
+		vCreateInfo.pPoolSizes = vPoolSizes.data();
+
+		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkCreateDescriptorPool(getEngine()->getLogicalDevice(), &vCreateInfo, nullptr, &m_vDescriptorPool), "Failed to create the bindless descriptor pool!");
+
+		// Only allocate the image descriptors we need.
+		VkDescriptorSetVariableDescriptorCountAllocateInfo vVariableCountInfo = {};
+		vVariableCountInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+		vVariableCountInfo.pNext = nullptr;
+		vVariableCountInfo.descriptorSetCount = 1;
+		vVariableCountInfo.pDescriptorCounts = &m_ImageCapacity;
+
+		VkDescriptorSetAllocateInfo vAllocateInfo = {};
+		vAllocateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		vAllocateInfo.pNext = &vVariableCountInfo;
+		vAllocateInfo.descriptorPool = m_vDescriptorPool;
+		vAllocateInfo.descriptorSetCount = 1;
+		vAllocateInfo.pSetLayouts = &m_vDescriptorSetLayout;
+
+		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkAllocateDescriptorSets(getEngine()->getLogicalDevice(), &vAllocateInfo, &m_vDescriptorSet), "Failed to allocate the bindless descriptor set!");
+	}
+
+	uint32_t BindlessTable::AllocateIndex(std::vector<uint32_t>& freeIndexes, uint32_t& nextIndex, const uint32_t capacity)
+	{
+		// Reuse the released indexes first.
+		if (!freeIndexes.empty())
+		{
+			const auto index = freeIndexes.back();
+			freeIndexes.pop_back();
+			return index;
+		}
+
+		if (nextIndex == capacity)
+			throw BackendError("The bindless table is full!");
+
+		return nextIndex++;
+	}
+}
\ No newline at end of file
@@ -11,6 +11,33 @@ namespace /* anonymous */
 
 		return vFeatures;
 	}
+
+	constexpr VkPhysicalDeviceVulkan12Features GetVulkan12Features()
+	{
+		// Descriptor indexing features used by the bindless table.
+		VkPhysicalDeviceVulkan12Features vFeatures = {};
+		vFeatures.descriptorIndexing = VK_TRUE;
+		vFeatures.runtimeDescriptorArray = VK_TRUE;
+		vFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		vFeatures.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+		vFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+		vFeatures.descriptorBindingVariableDescriptorCount = VK_TRUE;
+		vFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		vFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		vFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+
+		return vFeatures;
+	}
+
+	constexpr VkPhysicalDeviceVulkan13Features GetVulkan13Features()
+	{
+		VkPhysicalDeviceVulkan13Features vFeatures = {};
+		vFeatures.dynamicRendering = VK_TRUE;
+		vFeatures.synchronization2 = VK_TRUE;
+		vFeatures.pipelineCreationCacheControl = VK_TRUE;
+
+		return vFeatures;
+	}
 }
 
 namespace Firefly
@@ -20,13 +47,80 @@ namespace Firefly
 	{
 	}
 
+	GraphicsEngine::~GraphicsEngine()
+	{
+		// Wait till all the pending compilations are done before destroying the cache.
+		m_pWorkerPool.reset();
+
+		if (m_vPipelineCache != VK_NULL_HANDLE)
+			getDeviceTable().vkDestroyPipelineCache(getLogicalDevice(), m_vPipelineCache, nullptr);
+	}
+
 	std::shared_ptr<GraphicsEngine> GraphicsEngine::create(const std::shared_ptr<Instance>& pInstance)
 	{
 		const auto pointer = std::make_shared<GraphicsEngine>(pInstance);
 		FIREFLY_VALIDATE_OBJECT(pointer);
 
+		pointer->requestFeatures(GetVulkan12Features(), GetVulkan13Features());
 		pointer->initialize(VkQueueFlagBits::VK_QUEUE_GRAPHICS_BIT, {}, GetFeatures());
+		pointer->createPipelineCache();
 
 		return pointer;
 	}
+
+	std::shared_ptr<GraphicsPipeline> GraphicsEngine::findPipeline(const std::string& key)
+	{
+		const auto lock = std::scoped_lock(m_PipelineMutex);
+
+		const auto itr = m_pPipelines.find(key);
+		if (itr == m_pPipelines.end())
+			return nullptr;
+
+		return itr->second.lock();
+	}
+
+	void GraphicsEngine::registerPipeline(const std::string& key, const std::shared_ptr<GraphicsPipeline>& pPipeline)
+	{
+		const auto lock = std::scoped_lock(m_PipelineMutex);
+
+		// Remove the entries of the pipelines which were destroyed.
+		for (auto itr = m_pPipelines.begin(); itr != m_pPipelines.end();)
+		{
+			if (itr->second.expired())
+				itr = m_pPipelines.erase(itr);
+			else
+				++itr;
+		}
+
+		m_pPipelines[key] = pPipeline;
+	}
+
+	bool GraphicsEngine::isBindlessSupported() const
+	{
+		const auto& vFeatures = getVulkan12Features();
+		return vFeatures.runtimeDescriptorArray && vFeatures.descriptorBindingPartiallyBound && vFeatures.descriptorBindingVariableDescriptorCount
+			&& vFeatures.descriptorBindingUpdateUnusedWhilePending && vFeatures.descriptorBindingSampledImageUpdateAfterBind && vFeatures.descriptorBindingStorageBufferUpdateAfterBind;
+	}
+
+	WorkerPool& GraphicsEngine::getWorkerPool()
+	{
+		const auto lock = std::scoped_lock(m_WorkerPoolMutex);
+
+		if (!m_pWorkerPool)
+			m_pWorkerPool = std::make_unique<WorkerPool>();
+
+		return *m_pWorkerPool;
+	}
+
+	void GraphicsEngine::createPipelineCache()
+	{
+		VkPipelineCacheCreateInfo vCreateInfo = {};
+		vCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		vCreateInfo.pNext = nullptr;
+		vCreateInfo.flags = 0;
+		vCreateInfo.initialDataSize = 0;
+		vCreateInfo.pInitialData = nullptr;
+
+		FIREFLY_VALIDATE(getDeviceTable().vkCreatePipelineCache(getLogicalDevice(), &vCreateInfo, nullptr, &m_vPipelineCache), "Failed to create the pipeline cache!");
+	}
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "Firefly/Graphics/GraphicsPipeline.hpp"
 
+#include <algorithm>
 #include <array>
 
 namespace /* anonymous */
@@ -48,12 +49,115 @@ namespace /* anonymous */
 
 		return VkFormat::VK_FORMAT_UNDEFINED;
 	}
+
+	std::vector<VkPushConstantRange> MergePushConstantRanges(std::vector<VkPushConstantRange> vRanges)
+	{
+		// Sort the ranges by their offsets so that overlapping ranges are next to each other.
+		std::sort(vRanges.begin(), vRanges.end(), [](const VkPushConstantRange& lhs, const VkPushConstantRange& rhs) { return lhs.offset < rhs.offset; });
+
+		// Each stage can only be in one range, so overlapping ranges are merged into a single range used by all of their stages.
+		std::vector<VkPushConstantRange> vMergedRanges;
+		for (const auto& vRange : vRanges)
+		{
+			if (!vMergedRanges.empty() && vRange.offset < vMergedRanges.back().offset + vMergedRanges.back().size)
+			{
+				auto& vMergedRange = vMergedRanges.back();
+				vMergedRange.size = std::max(vMergedRange.offset + vMergedRange.size, vRange.offset + vRange.size) - vMergedRange.offset;
+				vMergedRange.stageFlags |= vRange.stageFlags;
+			}
+			else
+			{
+				vMergedRanges.emplace_back(vRange);
+			}
+		}
+
+		return vMergedRanges;
+	}
+
+	template<class Type>
+	void AppendToKey(std::string& key, const Type& value)
+	{
+		key.append(reinterpret_cast<const char*>(&value), sizeof(Type));
+	}
+
+	std::string CreatePipelineKey(const std::string& pipelineName, const std::vector<std::shared_ptr<Firefly::Shader>>& pShaders, const Firefly::RenderTarget* pRenderTarget,
+		const Firefly::GraphicsPipelineSpecification& specification, const Firefly::StageSpecializationConstants& specializationConstants)
+	{
+		// The name is length prefixed so that it can't run into the binary part of the key.
+		std::string key;
+		AppendToKey(key, static_cast<uint64_t>(pipelineName.size()));
+		key.append(pipelineName);
+
+		for (const auto& pShader : pShaders)
+			AppendToKey(key, pShader->getShaderModule());
+
+		// Dynamic rendering pipelines are only bound to the attachment formats.
+		if (pRenderTarget->isDynamicRendering())
+		{
+			AppendToKey(key, pRenderTarget->getColorAttachment()->getFormat());
+			AppendToKey(key, pRenderTarget->getDepthAttachment()->getFormat());
+			AppendToKey(key, pRenderTarget->getSampleCount());
+		}
+		else
+		{
+			AppendToKey(key, pRenderTarget->getRenderPass());
+		}
+
+		AppendToKey(key, specification.subpass);
+		AppendToKey(key, specification.vPolygonMode);
+		AppendToKey(key, specification.bEnableColorWrite);
+		AppendToKey(key, specification.bUseExtendedDynamicState);
+		AppendToKey(key, specification.vBindlessSetLayout);
+		AppendToKey(key, specification.firstInstanceLocation);
+
+		// The dynamic states are still keyed, as the specification of the pipeline is what gets set when it's bound.
+		AppendToKey(key, specification.vCullMode);
+		AppendToKey(key, specification.vFrontFace);
+		AppendToKey(key, specification.vPrimitiveTopology);
+		AppendToKey(key, specification.vDepthCompareOp);
+		AppendToKey(key, specification.bEnableDepthTest);
+		AppendToKey(key, specification.bEnableDepthWrite);
+
+		for (const auto& [stage, constants] : specializationConstants)
+		{
+			AppendToKey(key, stage);
+			for (const auto& [constantID, value] : constants.m_Values)
+			{
+				AppendToKey(key, constantID);
+				AppendToKey(key, static_cast<uint32_t>(value.size()));
+				key.append(reinterpret_cast<const char*>(value.data()), value.size());
+			}
+		}
+
+		return key;
+	}
+
+	void ValidateSpecializationConstants(const std::vector<std::shared_ptr<Firefly::Shader>>& pShaders, const Firefly::StageSpecializationConstants& specializationConstants)
+	{
+		for (const auto& [stage, constants] : specializationConstants)
+		{
+			const auto itr = std::find_if(pShaders.begin(), pShaders.end(), [stage = stage](const std::shared_ptr<Firefly::Shader>& pShader) { return GetStageFlagBits(pShader.get()) == stage; });
+			if (itr == pShaders.end())
+				throw Firefly::BackendError("Specialization constants were provided for a shader stage which is not in the pipeline!");
+
+			const auto& declaredConstants = (*itr)->getSpecializationConstants();
+			for (const auto& [constantID, value] : constants.m_Values)
+			{
+				const auto declared = declaredConstants.find(constantID);
+				if (declared == declaredConstants.end())
+					throw Firefly::BackendError("The shader does not declare a specialization constant with the provided ID!");
+
+				if (declared->second != value.size())
+					throw Firefly::BackendError("The specialization constant value size does not match the size declared in the shader!");
+			}
+		}
+	}
 }
 
 namespace Firefly
 {
-	GraphicsPipeline::GraphicsPipeline(const std::shared_ptr<GraphicsEngine>& pEngine, const std::string& pipelineName, const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification)
-		: EngineBoundObject(pEngine), m_Name(pipelineName), m_pShaders(pShaders), m_pRenderTarget(pRenderTarget), m_Specification(specification)
+	GraphicsPipeline::GraphicsPipeline(const std::shared_ptr<GraphicsEngine>& pEngine, const std::string& pipelineName, const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification, const StageSpecializationConstants& specializationConstants)
+		: EngineBoundObject(pEngine), m_Name(pipelineName), m_pShaders(pShaders), m_pRenderTarget(pRenderTarget), m_Specification(specification), m_SpecializationConstants(specializationConstants)
 	{
 	}
 
@@ -63,28 +167,89 @@ namespace Firefly
 			terminate();
 	}
 
-	std::shared_ptr<GraphicsPipeline> GraphicsPipeline::create(const std::shared_ptr<GraphicsEngine>& pEngine, const std::string& pipelineName, const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification)
+	std::shared_ptr<GraphicsPipeline> GraphicsPipeline::create(const std::shared_ptr<GraphicsEngine>& pEngine, const std::string& pipelineName, const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification, const StageSpecializationConstants& specializationConstants)
 	{
-		const auto pointer = std::make_shared<GraphicsPipeline>(pEngine, pipelineName, pShaders, pRenderTarget, specification);
+		// Return the existing pipeline if an identical one was already created.
+		const auto key = CreatePipelineKey(pipelineName, pShaders, pRenderTarget.get(), specification, specializationConstants);
+		if (const auto pPipeline = pEngine->findPipeline(key))
+		{
+			// The pipeline could still be compiling if it was created asynchronously.
+			if (!pPipeline->isReady())
+				pPipeline->wait();
+
+			return pPipeline;
+		}
+
+		const auto pointer = std::make_shared<GraphicsPipeline>(pEngine, pipelineName, pShaders, pRenderTarget, specification, specializationConstants);
 		FIREFLY_VALIDATE_OBJECT(pointer);
 
 		pointer->initialize();
+		pEngine->registerPipeline(key, pointer);
 
 		return pointer;
 	}
 
+	std::shared_ptr<GraphicsPipeline> GraphicsPipeline::createAsync(const std::shared_ptr<GraphicsEngine>& pEngine, const std::string& pipelineName, const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification, const StageSpecializationConstants& specializationConstants, const std::shared_ptr<GraphicsPipeline>& pFallbackPipeline)
+	{
+		// Return the existing pipeline if an identical one was already created.
+		const auto key = CreatePipelineKey(pipelineName, pShaders, pRenderTarget.get(), specification, specializationConstants);
+		if (const auto pPipeline = pEngine->findPipeline(key))
+			return pPipeline;
+
+		const auto pointer = std::make_shared<GraphicsPipeline>(pEngine, pipelineName, pShaders, pRenderTarget, specification, specializationConstants);
+		FIREFLY_VALIDATE_OBJECT(pointer);
+
+		pointer->initializeAsync(pFallbackPipeline);
+		pEngine->registerPipeline(key, pointer);
+
+		return pointer;
+	}
+
+	std::shared_ptr<GraphicsPipeline> GraphicsPipeline::createFastLinked(const std::shared_ptr<GraphicsEngine>& pEngine, const std::string& pipelineName, const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification, const StageSpecializationConstants& specializationConstants)
+	{
+		// Return the existing pipeline if an identical one was already created.
+		const auto key = CreatePipelineKey(pipelineName, pShaders, pRenderTarget.get(), specification, specializationConstants);
+		if (const auto pPipeline = pEngine->findPipeline(key))
+		{
+			if (!pPipeline->isReady())
+				pPipeline->wait();
+
+			return pPipeline;
+		}
+
+		const auto pointer = std::make_shared<GraphicsPipeline>(pEngine, pipelineName, pShaders, pRenderTarget, specification, specializationConstants);
+		FIREFLY_VALIDATE_OBJECT(pointer);
+
+		pointer->initializeFastLinked();
+		pEngine->registerPipeline(key, pointer);
+
+		return pointer;
+	}
+
+	std::shared_ptr<GraphicsPipeline> GraphicsPipeline::find(const std::shared_ptr<GraphicsEngine>& pEngine, const std::string& pipelineName, const std::vector<std::shared_ptr<Shader>>& pShaders, const std::shared_ptr<RenderTarget>& pRenderTarget, const GraphicsPipelineSpecification& specification, const StageSpecializationConstants& specializationConstants)
+	{
+		return pEngine->findPipeline(CreatePipelineKey(pipelineName, pShaders, pRenderTarget.get(), specification, specializationConstants));
+	}
+
 	void GraphicsPipeline::terminate()
 	{
-		// Destroy the descriptor pool if available. 
-		if (m_vDescriptorPool != VK_NULL_HANDLE)
+		// Make sure that the pipeline is not being compiled.
+		if (m_CompileFuture.valid())
+			m_CompileFuture.wait();
+
+		// Destroy the descriptor allocator if available. 
+		if (m_pDescriptorAllocator)
 		{
 			// Make sure to kill it's kids before killing him ;)
 			m_pPackages.clear();
-			getEngine()->getDeviceTable().vkDestroyDescriptorPool(getEngine()->getLogicalDevice(), m_vDescriptorPool, nullptr);
+			m_pDescriptorAllocator->terminate();
 		}
 
-		getEngine()->getDeviceTable().vkDestroyPipelineLayout(getEngine()->getLogicalDevice(), m_vPipelineLayout, nullptr);
 		getEngine()->getDeviceTable().vkDestroyPipeline(getEngine()->getLogicalDevice(), m_vPipeline, nullptr);
+
+		if (m_vRetiredPipeline != VK_NULL_HANDLE)
+			getEngine()->getDeviceTable().vkDestroyPipeline(getEngine()->getLogicalDevice(), m_vRetiredPipeline, nullptr);
+
 		toggleTerminated();
 	}
 
@@ -99,90 +264,90 @@ namespace Firefly
 		if (m_DescriptorPoolSizes.empty())
 			return nullptr;
 
-		// Setup pool create info.
-		VkDescriptorPoolCreateInfo vCreateInfo = {};
-		vCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		vCreateInfo.flags = 0;
-		vCreateInfo.pNext = nullptr;
-		vCreateInfo.maxSets = static_cast<uint32_t>(m_pPackages.size()) + 1;
-		vCreateInfo.poolSizeCount = static_cast<uint32_t>(m_DescriptorPoolSizes.size());
-		vCreateInfo.pPoolSizes = m_DescriptorPoolSizes.data();
-
-		const auto vOldDescriptorPool = m_vDescriptorPool;
-		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkCreateDescriptorPool(getEngine()->getLogicalDevice(), &vCreateInfo, nullptr, &m_vDescriptorPool), "Failed to create the descriptor pool!");
-
-		// Allocate the descriptor sets.
-		VkDescriptorSetAllocateInfo vAllocateInfo = {};
-		vAllocateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		vAllocateInfo.pNext = nullptr;
-		vAllocateInfo.descriptorSetCount = 1;
-		vAllocateInfo.descriptorPool = m_vDescriptorPool;
-
-		// Allocate new descriptor sets and swap the old ones with them.
-		for (const auto& pPackage : m_pPackages)
-		{
-			const auto layout = pPackage->getDescriptorSetLayout();
-			vAllocateInfo.pSetLayouts = &layout;
-
-			// Allocate a new descriptor set.
-			VkDescriptorSet vDescriptorSet = VK_NULL_HANDLE;
-			FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkAllocateDescriptorSets(getEngine()->getLogicalDevice(), &vAllocateInfo, &vDescriptorSet), "Failed to allocate descriptor set!");
-
-			// Swap the descriptors.
-			pPackage->swapDescriptors(m_vDescriptorPool, vDescriptorSet);
-		}
+		// The allocator grows by adding blocks, so the sets of the existing packages stay where they are.
+		if (!m_pDescriptorAllocator)
+			m_pDescriptorAllocator = DescriptorAllocator::create(getEngine(), m_DescriptorPoolSizes);
 
 		const auto layout = pShader->getDescriptorSetLayout();
-		vAllocateInfo.pSetLayouts = &layout;
-
-		// Allocate a new descriptor set.
-		VkDescriptorSet vDescriptorSet = VK_NULL_HANDLE;
-		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkAllocateDescriptorSets(getEngine()->getLogicalDevice(), &vAllocateInfo, &vDescriptorSet), "Failed to allocate descriptor set!");
+		const auto [vDescriptorPool, vDescriptorSet] = m_pDescriptorAllocator->allocate(layout);
 
 		// Create the new package.
-		auto pNewPackage = Package::create(std::static_pointer_cast<GraphicsEngine>(getEngine()), layout, m_vDescriptorPool, vDescriptorSet, shaderIndex);
+		auto pNewPackage = Package::create(std::static_pointer_cast<GraphicsEngine>(getEngine()), layout, vDescriptorPool, vDescriptorSet, shaderIndex, pShader->getBindings());
 		m_pPackages.emplace_back(pNewPackage);
 
-		getEngine()->getDeviceTable().vkDestroyDescriptorPool(getEngine()->getLogicalDevice(), vOldDescriptorPool, nullptr);
 		return pNewPackage;
 	}
 
+	std::shared_ptr<Package> GraphicsPipeline::createTransientPackage(const Shader* pShader, RenderTarget* pRenderTarget) const
+	{
+		// Check if the shader is within this pipeline.
+		const int32_t shaderIndex = getShaderIndex(pShader);
+		if (shaderIndex == -1)
+			throw BackendError("The provided shader does not exist within the pipeline!");
+
+		if (m_DescriptorPoolSizes.empty())
+			return nullptr;
+
+		const auto layout = pShader->getDescriptorSetLayout();
+		const auto [vDescriptorPool, vDescriptorSet] = pRenderTarget->allocateTransientDescriptorSet(layout);
+
+		// The render target releases the set, so the package is not tracked by the pipeline.
+		return Package::create(std::static_pointer_cast<GraphicsEngine>(getEngine()), layout, vDescriptorPool, vDescriptorSet, shaderIndex, pShader->getBindings());
+	}
+
 	void GraphicsPipeline::createPipelineLayout()
 	{
 		// Get the descriptor set layouts.
-		std::vector<VkDescriptorSetLayout> vDescriptorSetLayouts;
 		std::vector<VkPushConstantRange> vPushConstants;
-		vDescriptorSetLayouts.reserve(m_pShaders.size());
+		m_vDescriptorSetLayouts.reserve(m_pShaders.size());
 
 		for (const auto& pShader : m_pShaders)
 		{
-			vDescriptorSetLayouts.emplace_back(pShader->getDescriptorSetLayout());
+			m_vDescriptorSetLayouts.emplace_back(pShader->getDescriptorSetLayout());
 
 			const auto& pushConstants = pShader->getPushConstants();
 			vPushConstants.insert(vPushConstants.end(), pushConstants.begin(), pushConstants.end());
+
+			// At the same time, lets also resolve the pool sizes so we don't have to waste a lot of resources later.
+			for (const auto& [name, binding] : pShader->getBindings())
+			{
+				// Runtime sized arrays are provided by the bindless table.
+				if (binding.m_Count == 0)
+					continue;
+
+				VkDescriptorPoolSize vPoolSize = {};
+				vPoolSize.descriptorCount = binding.m_Count;
+				vPoolSize.type = binding.m_Type;
+				m_DescriptorPoolSizes.emplace_back(vPoolSize);
+			}
 		}
 
-		// Create the pipeline layout.
-		VkPipelineLayoutCreateInfo vPipelineLayoutCreateInfo = {};
-		vPipelineLayoutCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		vPipelineLayoutCreateInfo.flags = 0;
-		vPipelineLayoutCreateInfo.pNext = nullptr;
-		vPipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(m_pShaders.size());
-		vPipelineLayoutCreateInfo.pSetLayouts = vDescriptorSetLayouts.data();
-		vPipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(vPushConstants.size());
-		vPipelineLayoutCreateInfo.pPushConstantRanges = vPushConstants.data();
-
-		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkCreatePipelineLayout(getEngine()->getLogicalDevice(), &vPipelineLayoutCreateInfo, nullptr, &m_vPipelineLayout), "Failed to create the pipeline layout!");
+		// Merge the push constant ranges of all the stages and make sure that they fit within the device limits.
+		m_PushConstantRanges = MergePushConstantRanges(std::move(vPushConstants));
+
+		const auto maxPushConstantsSize = getEngine()->getPhysicalDeviceProperties().limits.maxPushConstantsSize;
+		for (const auto& vRange : m_PushConstantRanges)
+		{
+			if (vRange.offset + vRange.size > maxPushConstantsSize)
+				throw BackendError("The push constants of the pipeline exceed the maximum push constant size supported by the device!");
+		}
+
+		// The bindless set comes after the sets of the shaders.
+		if (m_Specification.vBindlessSetLayout != VK_NULL_HANDLE)
+			m_vDescriptorSetLayouts.emplace_back(m_Specification.vBindlessSetLayout);
+
+		// Get the pipeline layout. Pipelines with the same set layouts and push constants share it.
+		m_vPipelineLayout = getEngine()->getPipelineLayout(m_vDescriptorSetLayouts, m_PushConstantRanges);
 	}
 
-	void GraphicsPipeline::createPipeline()
+	bool GraphicsPipeline::createPipeline(const VkPipelineCreateFlags vFlags)
 	{
 		// Resolve shader info.
 		std::vector<VkPipelineShaderStageCreateInfo> vShaderStageCreateInfos;
 		vShaderStageCreateInfos.reserve(m_pShaders.size());
 
 		std::vector<VkVertexInputAttributeDescription> vAttributeDescriptions;
-		VkVertexInputBindingDescription vBindingDescription = {};
+		std::vector<VkVertexInputBindingDescription> vBindingDescriptions;
 
 		VkPipelineShaderStageCreateInfo vShaderStageCreateInfo = {};
 		vShaderStageCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -191,11 +356,47 @@ namespace Firefly
 		vShaderStageCreateInfo.pSpecializationInfo = nullptr;
 		vShaderStageCreateInfo.pName = "main";
 
+		// The specialization data needs to live till the pipeline is created.
+		std::vector<VkSpecializationInfo> vSpecializationInfos;
+		std::vector<std::vector<VkSpecializationMapEntry>> vSpecializationMapEntries;
+		std::vector<std::vector<uint8_t>> specializationData;
+		vSpecializationInfos.reserve(m_pShaders.size());
+		vSpecializationMapEntries.reserve(m_pShaders.size());
+		specializationData.reserve(m_pShaders.size());
+
 		// Iterate over the shaders and resolve information.
 		for (const auto& pShader : m_pShaders)
 		{
 			vShaderStageCreateInfo.module = pShader->getShaderModule();
 			vShaderStageCreateInfo.stage = GetStageFlagBits(pShader.get());
+			vShaderStageCreateInfo.pSpecializationInfo = nullptr;
+
+			// Resolve the specialization constants of the stage if available.
+			const auto specializationConstants = m_SpecializationConstants.find(vShaderStageCreateInfo.stage);
+			if (specializationConstants != m_SpecializationConstants.end() && !specializationConstants->second.empty())
+			{
+				auto& vMapEntries = vSpecializationMapEntries.emplace_back();
+				auto& data = specializationData.emplace_back();
+
+				for (const auto& [constantID, value] : specializationConstants->second.m_Values)
+				{
+					VkSpecializationMapEntry vMapEntry = {};
+					vMapEntry.constantID = constantID;
+					vMapEntry.offset = static_cast<uint32_t>(data.size());
+					vMapEntry.size = value.size();
+
+					vMapEntries.emplace_back(vMapEntry);
+					data.insert(data.end(), value.begin(), value.end());
+				}
+
+				VkSpecializationInfo vSpecializationInfo = {};
+				vSpecializationInfo.mapEntryCount = static_cast<uint32_t>(vMapEntries.size());
+				vSpecializationInfo.pMapEntries = vMapEntries.data();
+				vSpecializationInfo.dataSize = data.size();
+				vSpecializationInfo.pData = data.data();
+
+				vShaderStageCreateInfo.pSpecializationInfo = &vSpecializationInfos.emplace_back(vSpecializationInfo);
+			}
 
 			vShaderStageCreateInfos.emplace_back(vShaderStageCreateInfo);
 
@@ -205,32 +406,37 @@ namespace Firefly
 				const auto& inputs = pShader->getInputAttributes();
 				vAttributeDescriptions.reserve(inputs.size());
 
-				VkVertexInputAttributeDescription vAttributeDescription = {};
-				vAttributeDescription.binding = 0;
-				vAttributeDescription.offset = 0;
+				// The per vertex attributes are read from binding 0, and the per instance attributes from binding 1.
+				std::array<uint32_t, 2> strides = { 0, 0 };
 
-				// Resolve the individual attributes.
+				// Resolve the individual attributes. They are sorted by their location.
 				for (const auto& attribute : inputs)
 				{
+					const uint32_t binding = attribute.m_Location >= m_Specification.firstInstanceLocation ? 1 : 0;
+
+					VkVertexInputAttributeDescription vAttributeDescription = {};
 					vAttributeDescription.location = attribute.m_Location;
+					vAttributeDescription.binding = binding;
 					vAttributeDescription.format = GetFormatFromSize(attribute.m_Size);
+					vAttributeDescription.offset = strides[binding];
 
 					vAttributeDescriptions.emplace_back(vAttributeDescription);
-					vAttributeDescription.offset += attribute.m_Size;
+					strides[binding] += attribute.m_Size;
 				}
 
+				VkVertexInputBindingDescription vBindingDescription = {};
 				vBindingDescription.binding = 0;
 				vBindingDescription.inputRate = VkVertexInputRate::VK_VERTEX_INPUT_RATE_VERTEX;
-				vBindingDescription.stride = vAttributeDescription.offset;
-			}
+				vBindingDescription.stride = strides[0];
+				vBindingDescriptions.emplace_back(vBindingDescription);
 
-			// At the same time, lets also resolve the pool sizes so we don't have to waste a lot of resources later.
-			for (const auto& [name, binding] : pShader->getBindings())
-			{
-				VkDescriptorPoolSize vPoolSize = {};
-				vPoolSize.descriptorCount = binding.m_Count;
-				vPoolSize.type = binding.m_Type;
-				m_DescriptorPoolSizes.emplace_back(vPoolSize);
+				if (strides[1] > 0)
+				{
+					vBindingDescription.binding = 1;
+					vBindingDescription.inputRate = VkVertexInputRate::VK_VERTEX_INPUT_RATE_INSTANCE;
+					vBindingDescription.stride = strides[1];
+					vBindingDescriptions.emplace_back(vBindingDescription);
+				}
 			}
 		}
 
@@ -241,8 +447,8 @@ namespace Firefly
 		vVertexInputStateCreateInfo.flags = 0;
 		vVertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vAttributeDescriptions.size());
 		vVertexInputStateCreateInfo.pVertexAttributeDescriptions = vAttributeDescriptions.data();
-		vVertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
-		vVertexInputStateCreateInfo.pVertexBindingDescriptions = &vBindingDescription;
+		vVertexInputStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(vBindingDescriptions.size());
+		vVertexInputStateCreateInfo.pVertexBindingDescriptions = vBindingDescriptions.data();
 
 		// Setup input assembly state.
 		VkPipelineInputAssemblyStateCreateInfo vInputAssemblyStateCreateInfo = {};
@@ -250,7 +456,7 @@ namespace Firefly
 		vInputAssemblyStateCreateInfo.pNext = nullptr;
 		vInputAssemblyStateCreateInfo.flags = 0;
 		vInputAssemblyStateCreateInfo.primitiveRestartEnable = VK_FALSE;
-		vInputAssemblyStateCreateInfo.topology = VkPrimitiveTopology::VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		vInputAssemblyStateCreateInfo.topology = m_Specification.vPrimitiveTopology;
 
 		// Setup tessellation state.
 		VkPipelineTessellationStateCreateInfo vTessellationStateCreateInfo = {};
@@ -282,16 +488,21 @@ namespace Firefly
 		vViewportStateCreateInfo.viewportCount = 1;
 		vViewportStateCreateInfo.pViewports = &vViewport;
 
-		// Setup color blend state.
+		// Setup color blend state. Every color attachment of the subpass needs its own state.
 		VkPipelineColorBlendAttachmentState vColorBlendAttachmentState = {};
 		vColorBlendAttachmentState.blendEnable = VK_FALSE;
 		vColorBlendAttachmentState.alphaBlendOp = VkBlendOp::VK_BLEND_OP_ADD;
 		vColorBlendAttachmentState.colorBlendOp = VkBlendOp::VK_BLEND_OP_ADD;
-		vColorBlendAttachmentState.colorWriteMask =
-			VkColorComponentFlagBits::VK_COLOR_COMPONENT_R_BIT |
-			VkColorComponentFlagBits::VK_COLOR_COMPONENT_G_BIT |
-			VkColorComponentFlagBits::VK_COLOR_COMPONENT_B_BIT |
-			VkColorComponentFlagBits::VK_COLOR_COMPONENT_A_BIT;
+		vColorBlendAttachmentState.colorWriteMask = 0;
+
+		if (m_Specification.bEnableColorWrite)
+		{
+			vColorBlendAttachmentState.colorWriteMask =
+				VkColorComponentFlagBits::VK_COLOR_COMPONENT_R_BIT |
+				VkColorComponentFlagBits::VK_COLOR_COMPONENT_G_BIT |
+				VkColorComponentFlagBits::VK_COLOR_COMPONENT_B_BIT |
+				VkColorComponentFlagBits::VK_COLOR_COMPONENT_A_BIT;
+		}
 		vColorBlendAttachmentState.srcColorBlendFactor = VkBlendFactor::VK_BLEND_FACTOR_ZERO;
 		vColorBlendAttachmentState.srcAlphaBlendFactor = VkBlendFactor::VK_BLEND_FACTOR_ZERO;
 		vColorBlendAttachmentState.dstAlphaBlendFactor = VkBlendFactor::VK_BLEND_FACTOR_ZERO;
@@ -307,8 +518,9 @@ namespace Firefly
 		vColorBlendStateCreateInfo.blendConstants[1] = 0.0f;
 		vColorBlendStateCreateInfo.blendConstants[2] = 0.0f;
 		vColorBlendStateCreateInfo.blendConstants[3] = 0.0f;
-		vColorBlendStateCreateInfo.attachmentCount = 1;
-		vColorBlendStateCreateInfo.pAttachments = &vColorBlendAttachmentState;
+		const std::vector<VkPipelineColorBlendAttachmentState> vColorBlendAttachmentStates(m_pRenderTarget->getSubpasses()[m_Specification.subpass].colorAttachments.size(), vColorBlendAttachmentState);
+		vColorBlendStateCreateInfo.attachmentCount = static_cast<uint32_t>(vColorBlendAttachmentStates.size());
+		vColorBlendStateCreateInfo.pAttachments = vColorBlendAttachmentStates.data();
 
 		// Setup rasterization state.
 		VkPipelineRasterizationStateCreateInfo vRasterizationStateCreateInfo = {};
@@ -335,8 +547,8 @@ namespace Firefly
 		vMultisampleStateCreateInfo.alphaToOneEnable = VK_FALSE;
 		vMultisampleStateCreateInfo.minSampleShading = 1.0f;
 		//vMultisampleStateCreateInfo.pSampleMask;	// TODO
-		vMultisampleStateCreateInfo.rasterizationSamples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT;
-		vMultisampleStateCreateInfo.sampleShadingEnable = VK_TRUE;
+		vMultisampleStateCreateInfo.rasterizationSamples = m_pRenderTarget->getSampleCount();
+		vMultisampleStateCreateInfo.sampleShadingEnable = VK_FALSE;	// Shading once per pixel is what makes multisampling cheaper than supersampling.
 
 		// Setup depth stencil state.
 		VkPipelineDepthStencilStateCreateInfo vDepthStencilStateCreateInfo = {};
@@ -345,27 +557,53 @@ namespace Firefly
 		vDepthStencilStateCreateInfo.flags = 0;
 		vDepthStencilStateCreateInfo.back.compareOp = VkCompareOp::VK_COMPARE_OP_ALWAYS;
 		vDepthStencilStateCreateInfo.front.compareOp = VkCompareOp::VK_COMPARE_OP_NEVER;
-		vDepthStencilStateCreateInfo.depthTestEnable = VK_TRUE;
-		vDepthStencilStateCreateInfo.depthWriteEnable = VK_TRUE;
-		vDepthStencilStateCreateInfo.depthCompareOp = VkCompareOp::VK_COMPARE_OP_LESS_OR_EQUAL;
+		vDepthStencilStateCreateInfo.depthTestEnable = m_Specification.bEnableDepthTest ? VK_TRUE : VK_FALSE;
+		vDepthStencilStateCreateInfo.depthWriteEnable = m_Specification.bEnableDepthWrite ? VK_TRUE : VK_FALSE;
+		vDepthStencilStateCreateInfo.depthCompareOp = m_Specification.vDepthCompareOp;
 
 		// Setup dynamic state.
-		std::array<VkDynamicState, 2> vDynamicStates;
-		vDynamicStates[0] = VkDynamicState::VK_DYNAMIC_STATE_SCISSOR;
-		vDynamicStates[1] = VkDynamicState::VK_DYNAMIC_STATE_VIEWPORT;
+		std::vector<VkDynamicState> vDynamicStates = { VkDynamicState::VK_DYNAMIC_STATE_SCISSOR, VkDynamicState::VK_DYNAMIC_STATE_VIEWPORT };
+
+		if (m_Specification.bUseExtendedDynamicState)
+		{
+			vDynamicStates.insert(vDynamicStates.end(), {
+				VkDynamicState::VK_DYNAMIC_STATE_CULL_MODE,
+				VkDynamicState::VK_DYNAMIC_STATE_FRONT_FACE,
+				VkDynamicState::VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY,
+				VkDynamicState::VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE,
+				VkDynamicState::VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE,
+				VkDynamicState::VK_DYNAMIC_STATE_DEPTH_COMPARE_OP,
+				VkDynamicState::VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE,
+				VkDynamicState::VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE,
+				VkDynamicState::VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE
+				});
+		}
 
 		VkPipelineDynamicStateCreateInfo vDynamicStateCreateInfo = {};
 		vDynamicStateCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
 		vDynamicStateCreateInfo.pNext = nullptr;
 		vDynamicStateCreateInfo.flags = 0;
-		vDynamicStateCreateInfo.dynamicStateCount = 2;
+		vDynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(vDynamicStates.size());
 		vDynamicStateCreateInfo.pDynamicStates = vDynamicStates.data();
 
+		// Setup the attachment formats used for dynamic rendering.
+		const auto vColorFormat = m_pRenderTarget->getColorAttachment()->getFormat();
+		const auto vDepthFormat = m_pRenderTarget->getDepthAttachment()->getFormat();
+
+		VkPipelineRenderingCreateInfo vRenderingCreateInfo = {};
+		vRenderingCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+		vRenderingCreateInfo.pNext = nullptr;
+		vRenderingCreateInfo.viewMask = 0;
+		vRenderingCreateInfo.colorAttachmentCount = 1;
+		vRenderingCreateInfo.pColorAttachmentFormats = &vColorFormat;
+		vRenderingCreateInfo.depthAttachmentFormat = vDepthFormat;
+		vRenderingCreateInfo.stencilAttachmentFormat = vDepthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || vDepthFormat == VK_FORMAT_D24_UNORM_S8_UINT ? vDepthFormat : VK_FORMAT_UNDEFINED;
+
 		// Setup pipeline create info.
 		VkGraphicsPipelineCreateInfo vCreateInfo = {};
 		vCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		vCreateInfo.pNext = nullptr;
-		vCreateInfo.flags = 0;
+		vCreateInfo.pNext = m_pRenderTarget->isDynamicRendering() ? &vRenderingCreateInfo : nullptr;
+		vCreateInfo.flags = vFlags;
 		vCreateInfo.stageCount = static_cast<uint32_t>(vShaderStageCreateInfos.size());
 		vCreateInfo.pStages = vShaderStageCreateInfos.data();
 		vCreateInfo.pVertexInputState = &vVertexInputStateCreateInfo;
@@ -379,15 +617,34 @@ namespace Firefly
 		vCreateInfo.pDynamicState = &vDynamicStateCreateInfo;
 		vCreateInfo.layout = m_vPipelineLayout;
 		vCreateInfo.renderPass = m_pRenderTarget->getRenderPass();
-		vCreateInfo.subpass = 0;
+		vCreateInfo.subpass = m_Specification.subpass;
 		vCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
 		vCreateInfo.basePipelineIndex = 0;
 
-		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkCreateGraphicsPipelines(getEngine()->getLogicalDevice(), m_vPipelineCache, 1, &vCreateInfo, nullptr, &m_vPipeline), "Failed to create the graphics pipeline!");
+		const auto vPipelineCache = std::static_pointer_cast<GraphicsEngine>(getEngine())->getPipelineCache();
+		VkPipeline vPipeline = VK_NULL_HANDLE;
+		const auto vResult = getEngine()->getDeviceTable().vkCreateGraphicsPipelines(getEngine()->getLogicalDevice(), vPipelineCache, 1, &vCreateInfo, nullptr, &vPipeline);
+
+		// The pipeline is not created if it has to be compiled but compilation was not allowed.
+		if (vResult == VkResult::VK_PIPELINE_COMPILE_REQUIRED)
+			return false;
+
+		FIREFLY_VALIDATE(vResult, "Failed to create the graphics pipeline!");
+
+		// Swap in the new pipeline. A previous (unoptimized) pipeline could still be used by recorded command buffers, so it's destroyed on termination.
+		m_vRetiredPipeline = m_vPipeline.exchange(vPipeline);
+		m_bIsOptimized = (vFlags & VkPipelineCreateFlagBits::VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT) == 0;
+		m_bIsReady = true;
+
+		return true;
 	}
 
 	void GraphicsPipeline::initialize()
 	{
+		// Validate the specification and the specialization constants.
+		validateSpecification();
+		ValidateSpecializationConstants(m_pShaders, m_SpecializationConstants);
+
 		// Create the pipeline layout.
 		createPipelineLayout();
 
@@ -395,6 +652,84 @@ namespace Firefly
 		createPipeline();
 	}
 
+	void GraphicsPipeline::initializeAsync(const std::shared_ptr<GraphicsPipeline>& pFallbackPipeline)
+	{
+		// Validate the specification and the specialization constants.
+		validateSpecification();
+		ValidateSpecializationConstants(m_pShaders, m_SpecializationConstants);
+
+		// Create the pipeline layout. This is cheap, and lets packages be created right away.
+		createPipelineLayout();
+
+		// Compile the pipeline on the worker pool.
+		m_pFallbackPipeline = pFallbackPipeline;
+		m_CompileFuture = std::static_pointer_cast<GraphicsEngine>(getEngine())->getWorkerPool().submit([this] { compileOnWorker(); }).share();
+	}
+
+	void GraphicsPipeline::initializeFastLinked()
+	{
+		// Validate the specification and the specialization constants.
+		validateSpecification();
+		ValidateSpecializationConstants(m_pShaders, m_SpecializationConstants);
+
+		// Create the pipeline layout.
+		createPipelineLayout();
+
+		// If the optimized pipeline is already in the cache, it can be used right away without compiling anything.
+		const auto pEngine = std::static_pointer_cast<GraphicsEngine>(getEngine());
+		if (pEngine->isPipelineCreationCacheControlSupported() && createPipeline(VkPipelineCreateFlagBits::VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT))
+			return;
+
+		// Create a pipeline without optimizations so that it can be used right away.
+		createPipeline(VkPipelineCreateFlagBits::VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT);
+
+		// Compile the optimized pipeline on the worker pool. It's swapped in once done.
+		m_CompileFuture = pEngine->getWorkerPool().submit([this] { compileOnWorker(); }).share();
+	}
+
+	VkPipeline GraphicsPipeline::getPipeline() const
+	{
+		if (m_bIsReady)
+			return m_vPipeline;
+
+		// Use the fallback pipeline while this one is compiling. If the compilation failed, the error is rethrown instead.
+		if (m_pFallbackPipeline && !m_bHasFailed)
+			return m_pFallbackPipeline->getPipeline();
+
+		wait();
+		return m_vPipeline;
+	}
+
+	void GraphicsPipeline::compileOnWorker()
+	{
+		// The exception is kept by the future, and rethrown by wait().
+		try
+		{
+			createPipeline();
+		}
+		catch (...)
+		{
+			m_bHasFailed = true;
+			throw;
+		}
+	}
+
+	void GraphicsPipeline::wait() const
+	{
+		// This rethrows the exception if the compilation failed.
+		if (m_CompileFuture.valid())
+			m_CompileFuture.get();
+	}
+
+	void GraphicsPipeline::validateSpecification() const
+	{
+		if (m_Specification.bUseExtendedDynamicState && !std::static_pointer_cast<GraphicsEngine>(getEngine())->isExtendedDynamicStateSupported())
+			throw BackendError("Extended dynamic state was requested but it requires Vulkan 1.3!");
+
+		if (m_Specification.subpass >= m_pRenderTarget->getSubpasses().size())
+			throw BackendError("The pipeline subpass does not exist in the render target!");
+	}
+
 	int32_t GraphicsPipeline::getShaderIndex(const Shader* pShader) const
 	{
 		// Iterate and see if the shader exists in the pipeline.
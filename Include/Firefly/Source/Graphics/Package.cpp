@@ -1,114 +1,195 @@
 #include "Firefly/Graphics/Package.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 namespace Firefly
 {
-	Package::Package(const std::shared_ptr<GraphicsEngine>& pEngine, const VkDescriptorSetLayout vDescriptorSetLayout, const VkDescriptorPool vDescriptorPool, const VkDescriptorSet vDescriptorSet, const uint32_t setIndex)
+	Package::Package(const std::shared_ptr<GraphicsEngine>& pEngine, const VkDescriptorSetLayout vDescriptorSetLayout, const VkDescriptorPool vDescriptorPool, const VkDescriptorSet vDescriptorSet, const uint32_t setIndex,
+		const std::unordered_map<std::string, ShaderBinding>& bindings)
 		: EngineBoundObject(pEngine), m_vDescriptorSetLayout(vDescriptorSetLayout), m_vDescriptorPool(vDescriptorPool), m_vDescriptorSet(vDescriptorSet), m_SetIndex(setIndex)
 	{
+		initialize(bindings);
 	}
 
-	void Package::swapDescriptors(const VkDescriptorPool vDescriptorPool, const VkDescriptorSet vDescriptorSet)
+	std::shared_ptr<Package> Package::create(const std::shared_ptr<GraphicsEngine>& pEngine, const VkDescriptorSetLayout vDescriptorSetLayout, const VkDescriptorPool vDescriptorPool, const VkDescriptorSet vDescriptorSet, const uint32_t setIndex,
+		const std::unordered_map<std::string, ShaderBinding>& bindings)
 	{
-		std::vector<VkCopyDescriptorSet> vCopies;
-		vCopies.reserve(m_BindingMap.size());
-
-		VkCopyDescriptorSet vCopyInfo = {};
-		vCopyInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
-		vCopyInfo.pNext = nullptr;
-		vCopyInfo.srcSet = m_vDescriptorSet;
-		vCopyInfo.dstSet = vDescriptorSet;
+		return std::make_shared<Package>(pEngine, vDescriptorSetLayout, vDescriptorPool, vDescriptorSet, setIndex, bindings);
+	}
 
-		// Iterate through the bindings and setup the copy info.
-		for (const auto& [binding, resource] : m_BindingMap)
+	void Package::bindResources(const uint32_t binding, const std::vector<std::shared_ptr<Buffer>>& pBuffers, const VkDescriptorType vDescriptorType, const uint32_t arrayElement)
+	{
+		// Iterate over the buffers and write them to the shadow.
+		for (uint32_t i = 0; i < pBuffers.size(); i++)
 		{
-			// If it only contains buffers, we just need to get the buffer count.
-			if (resource.containsBuffers())
-				vCopyInfo.descriptorCount = static_cast<uint32_t>(resource.m_pBuffers.size());
-
-			// Else, we get the image count.
-			else
-				vCopyInfo.descriptorCount = static_cast<uint32_t>(resource.m_pImage.size());
+			const auto& pBuffer = pBuffers[i];
 
-			vCopyInfo.dstBinding = binding;
-			vCopyInfo.srcBinding = binding;
-			vCopyInfo.dstArrayElement = resource.m_DestinationArrayElement;
-			vCopyInfo.srcArrayElement = resource.m_DestinationArrayElement;
+			DescriptorInfo info = {};
+			info.m_BufferInfo.offset = 0;	// TODO
+			info.m_BufferInfo.range = pBuffer->size();
+			info.m_BufferInfo.buffer = pBuffer->getBuffer();
 
-			vCopies.emplace_back(vCopyInfo);
+			writeDescriptor(binding, vDescriptorType, arrayElement + i, info);
 		}
 
-		// Copy everything to the new descriptor set.
-		getEngine()->getDeviceTable().vkUpdateDescriptorSets(getEngine()->getLogicalDevice(), 0, nullptr, static_cast<uint32_t>(vCopies.size()), vCopies.data());
-
-		m_vDescriptorSet = vDescriptorSet;
-		m_vDescriptorPool = vDescriptorPool;
+		m_BindingMap[binding] = ResourceBinding(pBuffers, arrayElement);
+		update();
 	}
 
-	std::shared_ptr<Package> Package::create(const std::shared_ptr<GraphicsEngine>& pEngine, const VkDescriptorSetLayout vDescriptorSetLayout, const VkDescriptorPool vDescriptorPool, const VkDescriptorSet vDescriptorSet, const uint32_t setIndex)
+	void Package::bindResources(const uint32_t binding, const std::vector<std::shared_ptr<Image>>& pImages, const VkDescriptorType vDescriptorType, const uint32_t arrayElement)
 	{
-		return std::make_shared<Package>(pEngine, vDescriptorSetLayout, vDescriptorPool, vDescriptorSet, setIndex);
+		// Iterate over the images and write them to the shadow.
+		for (uint32_t i = 0; i < pImages.size(); i++)
+		{
+			const auto& pImage = pImages[i];
+
+			DescriptorInfo info = {};
+			info.m_ImageInfo.sampler = pImage->getSampler();
+			info.m_ImageInfo.imageView = pImage->getImageView();
+			info.m_ImageInfo.imageLayout = pImage->getImageLayout();
+
+			// Input attachments are read in the layout which the subpass references them in, not the layout they are in outside of the render pass.
+			if (vDescriptorType == VkDescriptorType::VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT)
+			{
+				info.m_ImageInfo.sampler = VK_NULL_HANDLE;
+				info.m_ImageInfo.imageLayout = pImage->getUsageFlags() & VkImageUsageFlagBits::VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT ?
+					VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			}
+
+			writeDescriptor(binding, vDescriptorType, arrayElement + i, info);
+		}
+
+		m_BindingMap[binding] = ResourceBinding(pImages, arrayElement);
+		update();
 	}
 
-	void Package::bindResources(const uint32_t binding, const std::vector<std::shared_ptr<Buffer>>& pBuffers, const VkDescriptorType vDescriptorType, const uint32_t arrayElement)
+	void Package::update()
 	{
-		VkWriteDescriptorSet vWrite = {};
-		vWrite.sType = VkStructureType::VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		vWrite.pNext = nullptr;
-		vWrite.pImageInfo = nullptr;
-		vWrite.pTexelBufferView = nullptr;
-		vWrite.dstSet = m_vDescriptorSet;
-		vWrite.descriptorType = vDescriptorType;
-		vWrite.descriptorCount = static_cast<uint32_t>(pBuffers.size());
-		vWrite.dstArrayElement = arrayElement;
-		vWrite.dstBinding = binding;
-
-		// Iterate over the buffers and setup info.
-		std::vector<VkDescriptorBufferInfo> vBufferInfos(pBuffers.size());
-		for (uint64_t i = 0; i < pBuffers.size(); i++)
+		if (!m_bIsDirty)
+			return;
+
+		// If the whole set is written, we can write the shadow in one go using the template.
+		if (m_vDescriptorUpdateTemplate != VK_NULL_HANDLE && m_WrittenCount == m_DescriptorInfos.size())
 		{
-			const auto& pBuffer = pBuffers[i];
-			vBufferInfos[i].offset = 0;	// TODO
-			vBufferInfos[i].range = pBuffer->size();
-			vBufferInfos[i].buffer = pBuffer->getBuffer();
+			getEngine()->getDeviceTable().vkUpdateDescriptorSetWithTemplate(getEngine()->getLogicalDevice(), m_vDescriptorSet, m_vDescriptorUpdateTemplate, m_DescriptorInfos.data());
 		}
 
-		vWrite.pBufferInfo = vBufferInfos.data();
-		getEngine()->getDeviceTable().vkUpdateDescriptorSets(getEngine()->getLogicalDevice(), 1, &vWrite, 0, nullptr);
+		// Else we write the changed descriptors, merging consecutive array elements of a binding into a single write.
+		else
+		{
+			std::vector<VkWriteDescriptorSet> vWrites;
+			for (const auto& vEntry : m_vTemplateEntries)
+			{
+				const auto firstIndex = vEntry.offset / sizeof(DescriptorInfo);
+				for (uint32_t i = 0; i < vEntry.descriptorCount; i++)
+				{
+					const auto& info = m_DescriptorInfos[firstIndex + i];
+					if (!m_DirtyDescriptors[firstIndex + i])
+						continue;
+
+					if (!vWrites.empty() && vWrites.back().dstBinding == vEntry.dstBinding && vWrites.back().dstArrayElement + vWrites.back().descriptorCount == i)
+					{
+						vWrites.back().descriptorCount++;
+						continue;
+					}
+
+					// Only one of the image and buffer infos is read depending on the descriptor type.
+					VkWriteDescriptorSet vWrite = {};
+					vWrite.sType = VkStructureType::VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+					vWrite.pNext = nullptr;
+					vWrite.pImageInfo = &info.m_ImageInfo;
+					vWrite.pBufferInfo = &info.m_BufferInfo;
+					vWrite.pTexelBufferView = nullptr;
+					vWrite.dstSet = m_vDescriptorSet;
+					vWrite.descriptorType = vEntry.descriptorType;
+					vWrite.descriptorCount = 1;
+					vWrite.dstArrayElement = i;
+					vWrite.dstBinding = vEntry.dstBinding;
+
+					vWrites.emplace_back(vWrite);
+				}
+			}
+
+			getEngine()->getDeviceTable().vkUpdateDescriptorSets(getEngine()->getLogicalDevice(), static_cast<uint32_t>(vWrites.size()), vWrites.data(), 0, nullptr);
+		}
 
-		m_BindingMap[binding] = ResourceBinding(pBuffers, arrayElement);
+		std::fill(m_DirtyDescriptors.begin(), m_DirtyDescriptors.end(), false);
+		m_bIsDirty = false;
+	}
+	
+	void Package::terminate()
+	{
+		toggleTerminated();
 	}
 
-	void Package::bindResources(const uint32_t binding, const std::vector<std::shared_ptr<Image>>& pImages, const VkDescriptorType vDescriptorType, const uint32_t arrayElement)
+	void Package::initialize(const std::unordered_map<std::string, ShaderBinding>& bindings)
 	{
-		VkWriteDescriptorSet vWrite = {};
-		vWrite.sType = VkStructureType::VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		vWrite.pNext = nullptr;
-		vWrite.pBufferInfo = nullptr;
-		vWrite.pTexelBufferView = nullptr;
-		vWrite.dstSet = m_vDescriptorSet;
-		vWrite.descriptorType = vDescriptorType;
-		vWrite.descriptorCount = static_cast<uint32_t>(pImages.size());
-		vWrite.dstArrayElement = arrayElement;
-		vWrite.dstBinding = binding;
-
-		// Iterate over the images and setup info.
-		std::vector<VkDescriptorImageInfo> vImageInfos(pImages.size());
-		for (uint64_t i = 0; i < pImages.size(); i++)
+		// The writes point into the shadow, so the descriptor infos must have the same size as the union.
+		static_assert(sizeof(DescriptorInfo) == sizeof(VkDescriptorBufferInfo) && sizeof(DescriptorInfo) == sizeof(VkDescriptorImageInfo));
+
+		std::vector<ShaderBinding> sortedBindings;
+		sortedBindings.reserve(bindings.size());
+
+		// Runtime sized arrays are not part of the layout.
+		for (const auto& [name, binding] : bindings)
 		{
-			const auto& pImage = pImages[i];
-			vImageInfos[i].sampler = pImage->getSampler();
-			vImageInfos[i].imageView = pImage->getImageView();
-			vImageInfos[i].imageLayout = pImage->getImageLayout();
+			if (binding.m_Count > 0)
+				sortedBindings.emplace_back(binding);
 		}
 
-		vWrite.pImageInfo = vImageInfos.data();
-		getEngine()->getDeviceTable().vkUpdateDescriptorSets(getEngine()->getLogicalDevice(), 1, &vWrite, 0, nullptr);
+		std::sort(sortedBindings.begin(), sortedBindings.end(), [](const ShaderBinding& lhs, const ShaderBinding& rhs) { return lhs.m_Binding < rhs.m_Binding; });
 
-		m_BindingMap[binding] = ResourceBinding(pImages, arrayElement);
+		// Setup the template entries. Each binding gets a consecutive range of descriptors in the shadow.
+		uint64_t descriptorCount = 0;
+		m_vTemplateEntries.reserve(sortedBindings.size());
+
+		for (const auto& binding : sortedBindings)
+		{
+			VkDescriptorUpdateTemplateEntry vEntry = {};
+			vEntry.dstBinding = binding.m_Binding;
+			vEntry.dstArrayElement = 0;
+			vEntry.descriptorCount = binding.m_Count;
+			vEntry.descriptorType = binding.m_Type;
+			vEntry.offset = descriptorCount * sizeof(DescriptorInfo);
+			vEntry.stride = sizeof(DescriptorInfo);
+
+			m_vTemplateEntries.emplace_back(vEntry);
+			descriptorCount += binding.m_Count;
+		}
+
+		m_DescriptorInfos.resize(descriptorCount);
+		m_WrittenDescriptors.resize(descriptorCount, false);
+		m_DirtyDescriptors.resize(descriptorCount, false);
+
+		m_vDescriptorUpdateTemplate = getEngine()->getDescriptorUpdateTemplate(m_vDescriptorSetLayout, m_vTemplateEntries);
 	}
-	
-	void Package::terminate()
+
+	void Package::writeDescriptor(const uint32_t binding, const VkDescriptorType vDescriptorType, const uint32_t arrayElement, const DescriptorInfo& info)
 	{
-		toggleTerminated();
+		const auto itr = std::lower_bound(m_vTemplateEntries.begin(), m_vTemplateEntries.end(), binding, [](const VkDescriptorUpdateTemplateEntry& vEntry, const uint32_t value) { return vEntry.dstBinding < value; });
+		if (itr == m_vTemplateEntries.end() || itr->dstBinding != binding)
+			throw BackendError("The binding does not exist in the package's descriptor set layout!");
+
+		if (itr->descriptorType != vDescriptorType)
+			throw BackendError("The descriptor type does not match the type of the binding!");
+
+		if (arrayElement >= itr->descriptorCount)
+			throw BackendError("The array element is out of the binding's range!");
+
+		// Skip if the same descriptor is already written.
+		const auto index = itr->offset / sizeof(DescriptorInfo) + arrayElement;
+		if (m_WrittenDescriptors[index] && std::memcmp(&m_DescriptorInfos[index], &info, sizeof(DescriptorInfo)) == 0)
+			return;
+
+		if (!m_WrittenDescriptors[index])
+		{
+			m_WrittenDescriptors[index] = true;
+			m_WrittenCount++;
+		}
+
+		m_DescriptorInfos[index] = info;
+		m_DirtyDescriptors[index] = true;
+		m_bIsDirty = true;
 	}
 }
\ No newline at end of file
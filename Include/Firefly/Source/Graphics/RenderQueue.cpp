@@ -0,0 +1,362 @@
+#include "Firefly/Graphics/RenderQueue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace Firefly
+{
+	namespace /* anonymous */
+	{
+		constexpr uint64_t TransparentBit = 1ull << 63;
+
+		/**
+		 * Quantize a depth value to 24 bits.
+		 * Non-negative IEEE floats keep their order when compared as integers, so we only need the upper bits.
+		 *
+		 * @param depth The depth value.
+		 * @return The quantized depth.
+		 */
+		uint64_t QuantizeDepth(const float depth)
+		{
+			// Negative depth (and NaN) is clamped to 0.
+			if (!(depth > 0.0f))
+				return 0;
+
+			uint32_t bits = 0;
+			std::memcpy(&bits, &depth, sizeof(float));
+
+			return bits >> 7;
+		}
+
+		/**
+		 * Create the sort key of a packet.
+		 *
+		 * Opaque:		[0 | pipeline : 16 | material : 16 | depth : 24 | 0 : 7]
+		 * Transparent:	[1 | ~depth : 24 | pipeline : 16 | material : 16 | 0 : 7]
+		 *
+		 * @param pipelineID The pipeline ID.
+		 * @param materialID The material ID.
+		 * @param depth The packet depth.
+		 * @param bIsTransparent Whether or not the packet is transparent.
+		 * @return The sort key.
+		 */
+		uint64_t CreateSortKey(const uint16_t pipelineID, const uint16_t materialID, const float depth, const bool bIsTransparent)
+		{
+			const auto quantizedDepth = QuantizeDepth(depth);
+
+			if (bIsTransparent)
+				return TransparentBit | ((~quantizedDepth & 0xFFFFFF) << 39) | (static_cast<uint64_t>(pipelineID) << 23) | (static_cast<uint64_t>(materialID) << 7);
+
+			return (static_cast<uint64_t>(pipelineID) << 47) | (static_cast<uint64_t>(materialID) << 31) | (quantizedDepth << 7);
+		}
+	}
+
+	void RenderQueue::submit(const GraphicsPipeline* pPipeline, const std::vector<Package*>& pPackages, const Buffer* pVertexBuffer, const Buffer* pIndexBuffer,
+		const DrawRange& range, const float depth, const bool bIsTransparent, const DepthPrepassDraw& prepass)
+	{
+		// Packets drawn in the pre-pass fetch their positions from the position stream, and must be drawn with an equal depth test in the main pass.
+		if (!bIsTransparent && prepass.m_pPipeline)
+		{
+			if (!prepass.m_pPositionBuffer)
+				throw BackendError("The depth pre-pass draw needs a position buffer!");
+
+			if (!prepass.m_pEqualPipeline && !pPipeline->getSpecification().bUseExtendedDynamicState)
+				throw BackendError("The depth pre-pass draw needs an equal pipeline, as the packet pipeline does not use extended dynamic state!");
+		}
+
+		m_Keys.emplace_back(CreateSortKey(getPipelineID(pPipeline), getMaterialID(pPackages), depth, bIsTransparent));
+		m_pPipelines.emplace_back(pPipeline);
+		m_pVertexBuffers.emplace_back(pVertexBuffer);
+		m_pIndexBuffers.emplace_back(pIndexBuffer);
+		m_Ranges.emplace_back(range);
+		m_PackageOffsets.emplace_back(static_cast<uint32_t>(m_pPackages.size()));
+		m_PackageCounts.emplace_back(static_cast<uint32_t>(pPackages.size()));
+		m_pPackages.insert(m_pPackages.end(), pPackages.begin(), pPackages.end());
+
+		// Transparent packets do not write depth, so they can't be drawn in the pre-pass.
+		m_pPrepassPipelines.emplace_back(bIsTransparent ? nullptr : prepass.m_pPipeline);
+		m_pEqualPipelines.emplace_back(prepass.m_pEqualPipeline);
+		m_pPositionBuffers.emplace_back(prepass.m_pPositionBuffer);
+		m_PrepassPackageOffsets.emplace_back(static_cast<uint32_t>(m_pPackages.size()));
+		m_PrepassPackageCounts.emplace_back(static_cast<uint32_t>(prepass.m_pPackages.size()));
+		m_pPackages.insert(m_pPackages.end(), prepass.m_pPackages.begin(), prepass.m_pPackages.end());
+
+		m_bIsSorted = false;
+	}
+
+	void RenderQueue::sort()
+	{
+		const auto count = m_Keys.size();
+
+		m_SortedIndices.resize(count);
+		m_ScratchKeys.resize(count);
+		m_ScratchIndices.resize(count);
+
+		for (uint32_t i = 0; i < count; i++)
+			m_SortedIndices[i] = i;
+
+		// Least significant digit radix sort, 8 bits at a time. All the histograms are built in a single pass.
+		std::array<std::array<uint32_t, 256>, 8> histograms = {};
+		for (const auto key : m_Keys)
+		{
+			for (uint8_t digit = 0; digit < 8; digit++)
+				histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+		}
+
+		auto& keys = m_SortKeys;
+		keys.assign(m_Keys.begin(), m_Keys.end());
+
+		for (uint8_t digit = 0; digit < 8; digit++)
+		{
+			auto& histogram = histograms[digit];
+
+			// If every key has the same value for this digit, the pass would not change anything.
+			if (histogram[(keys.empty() ? 0 : keys.front() >> (digit * 8)) & 0xFF] == count)
+				continue;
+
+			// Compute the offsets.
+			uint32_t offset = 0;
+			for (auto& bucket : histogram)
+			{
+				const auto bucketSize = bucket;
+				bucket = offset;
+				offset += bucketSize;
+			}
+
+			// Scatter the keys and the indices.
+			for (uint64_t i = 0; i < count; i++)
+			{
+				const auto destination = histogram[(keys[i] >> (digit * 8)) & 0xFF]++;
+				m_ScratchKeys[destination] = keys[i];
+				m_ScratchIndices[destination] = m_SortedIndices[i];
+			}
+
+			keys.swap(m_ScratchKeys);
+			m_SortedIndices.swap(m_ScratchIndices);
+		}
+
+		m_bIsSorted = true;
+	}
+
+	void RenderQueue::flush(const CommandBuffer* pCommandBuffer)
+	{
+		if (!m_bIsSorted)
+			sort();
+
+		if (m_bIsDepthPrepassEnabled)
+			flushDepthPrepass(pCommandBuffer);
+
+		const GraphicsPipeline* pBoundPipeline = nullptr;
+		const Buffer* pBoundVertexBuffer = nullptr;
+		const Buffer* pBoundIndexBuffer = nullptr;
+		const Buffer* pBoundInstanceBuffer = nullptr;
+		int64_t boundPackagesIndex = -1;
+		bool bIsTestingEqual = false;
+
+		for (const auto index : m_SortedIndices)
+		{
+			// Packets which were drawn in the pre-pass only need to shade the visible pixels.
+			auto pPipeline = m_pPipelines[index];
+			const auto bTestEqual = m_bIsDepthPrepassEnabled && m_pPrepassPipelines[index];
+			if (bTestEqual && m_pEqualPipelines[index])
+				pPipeline = m_pEqualPipelines[index];
+
+			// Bind the pipeline if it has changed. The packages need to be bound again as the layout may differ.
+			if (pPipeline != pBoundPipeline || bTestEqual != bIsTestingEqual)
+			{
+				bindPipeline(pCommandBuffer, pPipeline, bTestEqual);
+				pBoundPipeline = pPipeline;
+				boundPackagesIndex = -1;
+				bIsTestingEqual = bTestEqual;
+			}
+
+			// Bind the packages if they have changed.
+			if (boundPackagesIndex == -1 || !hasSamePackages(m_PackageOffsets[boundPackagesIndex], m_PackageCounts[boundPackagesIndex], m_PackageOffsets[index], m_PackageCounts[index]))
+			{
+				const auto begin = m_pPackages.begin() + m_PackageOffsets[index];
+				m_pBindPackages.assign(begin, begin + m_PackageCounts[index]);
+
+				pCommandBuffer->bindPackages(pPipeline, m_pBindPackages);
+				boundPackagesIndex = index;
+			}
+
+			// Bind the geometry if it has changed.
+			const auto pVertexBuffer = m_pVertexBuffers[index];
+			if (pVertexBuffer && pVertexBuffer != pBoundVertexBuffer)
+			{
+				pCommandBuffer->bindVertexBuffer(pVertexBuffer);
+				pBoundVertexBuffer = pVertexBuffer;
+			}
+
+			const auto pIndexBuffer = m_pIndexBuffers[index];
+			if (pIndexBuffer && pIndexBuffer != pBoundIndexBuffer)
+			{
+				pCommandBuffer->bindIndexBuffer(pIndexBuffer);
+				pBoundIndexBuffer = pIndexBuffer;
+			}
+
+			const auto pInstanceBuffer = m_Ranges[index].m_pInstanceBuffer;
+			if (pInstanceBuffer && pInstanceBuffer != pBoundInstanceBuffer)
+			{
+				pCommandBuffer->bindInstanceBuffer(pInstanceBuffer);
+				pBoundInstanceBuffer = pInstanceBuffer;
+			}
+
+			// Finally issue the draw call.
+			const auto& range = m_Ranges[index];
+			if (pIndexBuffer)
+				pCommandBuffer->drawIndices(range.m_Count, range.m_VertexOffset, range.m_InstanceCount, range.m_FirstIndex, range.m_FirstInstance);
+			else
+				pCommandBuffer->drawVertices(range.m_Count, range.m_InstanceCount, range.m_FirstIndex, range.m_FirstInstance);
+		}
+
+		clear();
+	}
+
+	void RenderQueue::clear()
+	{
+		m_Keys.clear();
+		m_pPipelines.clear();
+		m_pVertexBuffers.clear();
+		m_pIndexBuffers.clear();
+		m_Ranges.clear();
+		m_PackageOffsets.clear();
+		m_PackageCounts.clear();
+		m_pPackages.clear();
+		m_pPrepassPipelines.clear();
+		m_pEqualPipelines.clear();
+		m_pPositionBuffers.clear();
+		m_PrepassPackageOffsets.clear();
+		m_PrepassPackageCounts.clear();
+		m_SortedIndices.clear();
+		m_PipelineIDs.clear();
+		m_MaterialIDs.clear();
+
+		m_bIsSorted = true;
+	}
+
+	void RenderQueue::flushDepthPrepass(const CommandBuffer* pCommandBuffer)
+	{
+		const GraphicsPipeline* pBoundPipeline = nullptr;
+		const Buffer* pBoundVertexBuffer = nullptr;
+		const Buffer* pBoundIndexBuffer = nullptr;
+		const Buffer* pBoundInstanceBuffer = nullptr;
+		int64_t boundPackagesIndex = -1;
+
+		// The opaque packets are sorted front-to-back within each pipeline and material, which lets the depth test reject most of the hidden geometry.
+		for (const auto index : m_SortedIndices)
+		{
+			const auto pPipeline = m_pPrepassPipelines[index];
+			if (!pPipeline)
+				continue;
+
+			if (pPipeline != pBoundPipeline)
+			{
+				bindPipeline(pCommandBuffer, pPipeline, false);
+				pBoundPipeline = pPipeline;
+				boundPackagesIndex = -1;
+			}
+
+			if (boundPackagesIndex == -1 ||
+				!hasSamePackages(m_PrepassPackageOffsets[boundPackagesIndex], m_PrepassPackageCounts[boundPackagesIndex], m_PrepassPackageOffsets[index], m_PrepassPackageCounts[index]))
+			{
+				const auto begin = m_pPackages.begin() + m_PrepassPackageOffsets[index];
+				m_pBindPackages.assign(begin, begin + m_PrepassPackageCounts[index]);
+
+				pCommandBuffer->bindPackages(pPipeline, m_pBindPackages);
+				boundPackagesIndex = index;
+			}
+
+			// Only the positions are fetched. They share the index buffer of the full vertex stream.
+			const auto pPositionBuffer = m_pPositionBuffers[index];
+			if (pPositionBuffer != pBoundVertexBuffer)
+			{
+				pCommandBuffer->bindVertexBuffer(pPositionBuffer);
+				pBoundVertexBuffer = pPositionBuffer;
+			}
+
+			const auto pIndexBuffer = m_pIndexBuffers[index];
+			if (pIndexBuffer && pIndexBuffer != pBoundIndexBuffer)
+			{
+				pCommandBuffer->bindIndexBuffer(pIndexBuffer);
+				pBoundIndexBuffer = pIndexBuffer;
+			}
+
+			const auto pInstanceBuffer = m_Ranges[index].m_pInstanceBuffer;
+			if (pInstanceBuffer && pInstanceBuffer != pBoundInstanceBuffer)
+			{
+				pCommandBuffer->bindInstanceBuffer(pInstanceBuffer);
+				pBoundInstanceBuffer = pInstanceBuffer;
+			}
+
+			const auto& range = m_Ranges[index];
+			if (pIndexBuffer)
+				pCommandBuffer->drawIndices(range.m_Count, range.m_VertexOffset, range.m_InstanceCount, range.m_FirstIndex, range.m_FirstInstance);
+			else
+				pCommandBuffer->drawVertices(range.m_Count, range.m_InstanceCount, range.m_FirstIndex, range.m_FirstInstance);
+		}
+	}
+
+	void RenderQueue::bindPipeline(const CommandBuffer* pCommandBuffer, const GraphicsPipeline* pPipeline, const bool bTestEqual) const
+	{
+		pCommandBuffer->bindGraphicsPipeline(pPipeline);
+
+		// The dynamic states persist across pipeline binds, so they are set every time.
+		const auto& specification = pPipeline->getSpecification();
+		if (specification.bUseExtendedDynamicState)
+		{
+			pCommandBuffer->setDynamicState(specification);
+
+			// Draws after the depth pre-pass only test against the depth it already wrote.
+			if (bTestEqual)
+			{
+				pCommandBuffer->setDepthTestEnable(true);
+				pCommandBuffer->setDepthWriteEnable(false);
+				pCommandBuffer->setDepthCompareOp(VkCompareOp::VK_COMPARE_OP_EQUAL);
+			}
+		}
+	}
+
+	uint16_t RenderQueue::getPipelineID(const GraphicsPipeline* pPipeline)
+	{
+		// The IDs wrap around after 65536 pipelines in a single frame. This only affects the grouping, not the correctness.
+		const auto itr = m_PipelineIDs.find(pPipeline);
+		if (itr != m_PipelineIDs.end())
+			return itr->second;
+
+		const auto id = static_cast<uint16_t>(m_PipelineIDs.size());
+		m_PipelineIDs[pPipeline] = id;
+
+		return id;
+	}
+
+	uint16_t RenderQueue::getMaterialID(const std::vector<Package*>& pPackages)
+	{
+		// Hash the package pointers using FNV-1a.
+		uint64_t hash = 14695981039346656037ull;
+		for (const auto pPackage : pPackages)
+		{
+			hash ^= reinterpret_cast<uint64_t>(pPackage);
+			hash *= 1099511628211ull;
+		}
+
+		const auto itr = m_MaterialIDs.find(hash);
+		if (itr != m_MaterialIDs.end())
+			return itr->second;
+
+		const auto id = static_cast<uint16_t>(m_MaterialIDs.size());
+		m_MaterialIDs[hash] = id;
+
+		return id;
+	}
+
+	bool RenderQueue::hasSamePackages(const uint32_t lhsOffset, const uint32_t lhsCount, const uint32_t rhsOffset, const uint32_t rhsCount) const
+	{
+		if (lhsCount != rhsCount)
+			return false;
+
+		const auto pBegin = m_pPackages.data();
+		return std::equal(pBegin + lhsOffset, pBegin + lhsOffset + lhsCount, pBegin + rhsOffset);
+	}
+}
\ No newline at end of file
@@ -1,6 +1,29 @@
 #include "Firefly/Graphics/RenderTarget.hpp"
 
 #include <array>
+#include <algorithm>
+
+namespace /* anonymous */
+{
+	/**
+	 * Descriptor counts of a single transient set.
+	 * Transient sets can use any layout, so each block has room for the common descriptor types. The allocator grows the blocks when a layout
+	 * needs more than this.
+	 */
+	const std::vector<VkDescriptorPoolSize> TransientPoolSizes = {
+		{ VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4 },
+		{ VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 },
+		{ VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 },
+		{ VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1 },
+		{ VkDescriptorType::VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 },
+		{ VkDescriptorType::VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 2 },
+		{ VkDescriptorType::VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 },
+		{ VkDescriptorType::VK_DESCRIPTOR_TYPE_SAMPLER, 1 },
+		{ VkDescriptorType::VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1 },
+	};
+
+	constexpr uint32_t TransientSetsPerBlock = 256;
+}
 
 namespace Firefly
 {
@@ -18,8 +41,8 @@ namespace Firefly
 		return vClearColors;
 	}
 
-	RenderTarget::RenderTarget(const std::shared_ptr<GraphicsEngine>& pEngine, const VkExtent3D extent, const uint8_t frameCount)
-		: EngineBoundObject(pEngine), m_Extent(extent), m_FrameCount(frameCount)
+	RenderTarget::RenderTarget(const std::shared_ptr<GraphicsEngine>& pEngine, const VkExtent3D extent, const uint8_t frameCount, const bool bUseDynamicRendering, const VkSampleCountFlagBits vSampleCount)
+		: EngineBoundObject(pEngine), m_Extent(extent), m_SampleCount(vSampleCount), m_FrameCount(frameCount), m_bUseDynamicRendering(bUseDynamicRendering)
 	{
 
 	}
@@ -30,12 +53,54 @@ namespace Firefly
 			terminate();
 	}
 
-	std::shared_ptr<RenderTarget> RenderTarget::create(const std::shared_ptr<GraphicsEngine>& pEngine, const VkExtent3D extent, const VkFormat vColorFormat, const uint8_t frameCount)
+	std::shared_ptr<RenderTarget> RenderTarget::create(const std::shared_ptr<GraphicsEngine>& pEngine, const VkExtent3D extent, const VkFormat vColorFormat, const uint8_t frameCount,
+		const bool bUseDynamicRendering, const VkSampleCountFlagBits vSampleCount)
+	{
+		if (bUseDynamicRendering && !pEngine->isDynamicRenderingSupported())
+			throw BackendError("Dynamic rendering is not supported by the device!");
+
+		const auto& vLimits = pEngine->getPhysicalDeviceProperties().limits;
+		if (!(vLimits.framebufferColorSampleCounts & vLimits.framebufferDepthSampleCounts & vSampleCount))
+			throw BackendError("The sample count is not supported by the device!");
+
+		const auto pointer = std::make_shared<RenderTarget>(pEngine, extent, frameCount, bUseDynamicRendering, vSampleCount);
+		FIREFLY_VALIDATE_OBJECT(pointer);
+
+		AttachmentSpecification attachment;
+		attachment.vFormat = vColorFormat;
+
+		SubpassSpecification subpass;
+		subpass.colorAttachments = { 0 };
+
+		pointer->initialize({ attachment }, { subpass });
+
+		return pointer;
+	}
+
+	std::shared_ptr<RenderTarget> RenderTarget::create(const std::shared_ptr<GraphicsEngine>& pEngine, const VkExtent3D extent, const std::vector<AttachmentSpecification>& attachments,
+		const std::vector<SubpassSpecification>& subpasses, const uint8_t frameCount)
 	{
+		if (attachments.empty())
+			throw BackendError("The render target needs at least one attachment!");
+
+		if (subpasses.empty())
+			throw BackendError("The render target needs at least one subpass!");
+
+		for (const auto& subpass : subpasses)
+		{
+			for (const auto attachment : subpass.colorAttachments)
+				if (attachment >= attachments.size())
+					throw BackendError("The subpass color attachment index is out of range!");
+
+			for (const auto attachment : subpass.inputAttachments)
+				if (attachment >= attachments.size())
+					throw BackendError("The subpass input attachment index is out of range!");
+		}
+
 		const auto pointer = std::make_shared<RenderTarget>(pEngine, extent, frameCount);
 		FIREFLY_VALIDATE_OBJECT(pointer);
 
-		pointer->initialize(vColorFormat);
+		pointer->initialize(attachments, subpasses);
 
 		return pointer;
 	}
@@ -43,8 +108,19 @@ namespace Firefly
 	CommandBuffer* RenderTarget::setupFrame(const std::vector<VkClearValue>& vClearColors)
 	{
 		const auto& pCommandBuffer = m_pCommandBuffers[getFrameIndex()];
-		pCommandBuffer->begin();
+
+		// Once the previous submission of this frame is done, none of its transient sets are in use.
+		pCommandBuffer->wait();
+		m_pTransientAllocators[getFrameIndex()]->reset();
+
+		// Baked frames are submitted more than once, so we can't use the one time submit flag for them.
+		if (m_bIsBaked)
+			pCommandBuffer->begin(0);
+		else
+			pCommandBuffer->begin();
+
 		pCommandBuffer->bindRenderTarget(this, vClearColors);
+		m_FrameRecordedStates[getFrameIndex()] = false;
 
 		return pCommandBuffer.get();
 	}
@@ -52,17 +128,57 @@ namespace Firefly
 	void RenderTarget::submitFrame(const bool shouldWait)
 	{
 		auto pCommandBuffer = m_pCommandBuffers[getFrameIndex()];
-		pCommandBuffer->unbindRenderTarget();
+
+		// Finish the recording if we have setup the frame. Else we just resubmit the baked commands.
+		if (pCommandBuffer->isRecording())
+		{
+			pCommandBuffer->unbindRenderTarget();
+			pCommandBuffer->end();
+
+			m_FrameRecordedStates[getFrameIndex()] = m_bIsBaked;
+		}
+
+		// Without a valid recording the command buffer is either empty or holds stale commands.
+		else if (!isFrameRecorded())
+			throw BackendError("Cannot submit the frame! The frame was not recorded, call setupFrame() to record it first.");
 
 		pCommandBuffer->submit(shouldWait);
 		incrementFrameIndex();
 	}
 
+	std::pair<VkDescriptorPool, VkDescriptorSet> RenderTarget::allocateTransientDescriptorSet(const VkDescriptorSetLayout vDescriptorSetLayout)
+	{
+		return m_pTransientAllocators[getFrameIndex()]->allocate(vDescriptorSetLayout);
+	}
+
+	void RenderTarget::setBakedMode(const bool bEnable)
+	{
+		m_bIsBaked = bEnable;
+		invalidateFrames();
+	}
+
+	void RenderTarget::invalidateFrames()
+	{
+		std::fill(m_FrameRecordedStates.begin(), m_FrameRecordedStates.end(), false);
+	}
+
+	bool RenderTarget::isFrameRecorded() const
+	{
+		if (!m_bIsBaked || !m_FrameRecordedStates[getFrameIndex()])
+			return false;
+
+		// The recorded commands still use the old pipeline if a pipeline was swapped, so the frame needs to be recorded again.
+		return !m_pCommandBuffers[getFrameIndex()]->hasOutdatedPipelines();
+	}
+
 	void RenderTarget::terminate()
 	{
 		for (const auto& pCommandBuffer : m_pCommandBuffers)
 			pCommandBuffer->terminate();
 
+		for (const auto& pAllocator : m_pTransientAllocators)
+			pAllocator->terminate();
+
 		getEngine()->getDeviceTable().vkDestroyCommandPool(getEngine()->getLogicalDevice(), m_vCommandPool, nullptr);
 		getEngine()->getDeviceTable().vkDestroyRenderPass(getEngine()->getLogicalDevice(), m_vRenderPass, nullptr);
 
@@ -71,39 +187,73 @@ namespace Firefly
 
 		m_vFrameBuffers.clear();
 		m_pCommandBuffers.clear();
+		m_pTransientAllocators.clear();
 
-		m_pColorAttachment->terminate();
+		for (const auto& pAttachment : m_pColorAttachments)
+			pAttachment->terminate();
+
+		m_pColorAttachments.clear();
 		m_pDepthAttachment->terminate();
 
+		if (m_pMultisampleColorAttachment)
+			m_pMultisampleColorAttachment->terminate();
+
 		toggleTerminated();
 	}
 	
 	void RenderTarget::createRenderPass()
 	{
-		// Crate attachment descriptions.
-		std::array<VkAttachmentDescription, 2> vAttachmentDescriptions;
-		vAttachmentDescriptions[0].flags = 0;
-		vAttachmentDescriptions[0].format = VkFormat::VK_FORMAT_R8G8B8A8_SRGB;
-		vAttachmentDescriptions[0].initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED;
-		vAttachmentDescriptions[0].finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-		vAttachmentDescriptions[0].loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR;
-		vAttachmentDescriptions[0].storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_STORE;
-		vAttachmentDescriptions[0].stencilLoadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		vAttachmentDescriptions[0].stencilStoreOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		vAttachmentDescriptions[0].samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT;
-
-		vAttachmentDescriptions[1].flags = 0;
-		vAttachmentDescriptions[1].format = m_pDepthAttachment->getFormat();
-		vAttachmentDescriptions[1].initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED;
-		vAttachmentDescriptions[1].finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
-		vAttachmentDescriptions[1].loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR;
-		vAttachmentDescriptions[1].storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		vAttachmentDescriptions[1].stencilLoadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		vAttachmentDescriptions[1].stencilStoreOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		vAttachmentDescriptions[1].samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT;
-
-		// Create the subpass dependencies.
-		std::array<VkSubpassDependency, 2> vSubpassDependencies;
+		const auto colorAttachmentCount = getColorAttachmentCount();
+		const auto depthAttachmentIndex = colorAttachmentCount;
+		const auto resolveAttachmentIndex = colorAttachmentCount + 1;
+
+		// Crate attachment descriptions. The color attachments are followed by the depth attachment. When multisampling, the color attachment is
+		// only the resolve target and is placed after the depth attachment.
+		std::vector<VkAttachmentDescription> vAttachmentDescriptions(isMultisampled() ? colorAttachmentCount + 2 : colorAttachmentCount + 1);
+		for (uint32_t i = 0; i < colorAttachmentCount; i++)
+		{
+			// Loaded attachments are kept in the color attachment layout in between frames.
+			const auto& attachment = m_Attachments[i];
+			vAttachmentDescriptions[i].flags = 0;
+			vAttachmentDescriptions[i].format = m_pColorAttachments[i]->getFormat();
+			vAttachmentDescriptions[i].initialLayout = attachment.vLoadOp == VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_LOAD ? VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED;
+			vAttachmentDescriptions[i].finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			vAttachmentDescriptions[i].loadOp = attachment.vLoadOp;
+			vAttachmentDescriptions[i].storeOp = isMultisampled() ? VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE : attachment.vStoreOp;
+			vAttachmentDescriptions[i].stencilLoadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			vAttachmentDescriptions[i].stencilStoreOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			vAttachmentDescriptions[i].samples = m_SampleCount;
+		}
+
+		vAttachmentDescriptions[depthAttachmentIndex].flags = 0;
+		vAttachmentDescriptions[depthAttachmentIndex].format = m_pDepthAttachment->getFormat();
+		vAttachmentDescriptions[depthAttachmentIndex].initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED;
+		vAttachmentDescriptions[depthAttachmentIndex].finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		vAttachmentDescriptions[depthAttachmentIndex].loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_CLEAR;
+		vAttachmentDescriptions[depthAttachmentIndex].storeOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		vAttachmentDescriptions[depthAttachmentIndex].stencilLoadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		vAttachmentDescriptions[depthAttachmentIndex].stencilStoreOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		vAttachmentDescriptions[depthAttachmentIndex].samples = m_SampleCount;
+
+		// The resolve attachment is fully overwritten, so its previous contents are not loaded.
+		if (isMultisampled())
+		{
+			vAttachmentDescriptions[resolveAttachmentIndex].flags = 0;
+			vAttachmentDescriptions[resolveAttachmentIndex].format = m_pColorAttachments.front()->getFormat();
+			vAttachmentDescriptions[resolveAttachmentIndex].initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED;
+			vAttachmentDescriptions[resolveAttachmentIndex].finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			vAttachmentDescriptions[resolveAttachmentIndex].loadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			vAttachmentDescriptions[resolveAttachmentIndex].storeOp = m_Attachments.front().vStoreOp;
+			vAttachmentDescriptions[resolveAttachmentIndex].stencilLoadOp = VkAttachmentLoadOp::VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			vAttachmentDescriptions[resolveAttachmentIndex].stencilStoreOp = VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			vAttachmentDescriptions[resolveAttachmentIndex].samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT;
+		}
+
+		// Create the subpass dependencies. Each subpass waits on the attachment accesses of the previous one, but only for the same region, so
+		// the attachments can stay in tile memory in between. The previous accesses include the input attachment reads, as the subpass can write
+		// to the attachments which were read before.
+		const auto subpassCount = static_cast<uint32_t>(m_Subpasses.size());
+		std::vector<VkSubpassDependency> vSubpassDependencies(subpassCount + 1);
 		vSubpassDependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
 		vSubpassDependencies[0].dstSubpass = 0;
 		vSubpassDependencies[0].srcStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
@@ -112,52 +262,154 @@ namespace Firefly
 		vSubpassDependencies[0].dstAccessMask = VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 		vSubpassDependencies[0].dependencyFlags = VkDependencyFlagBits::VK_DEPENDENCY_BY_REGION_BIT;
 
-		vSubpassDependencies[1].srcSubpass = 0;
-		vSubpassDependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-		vSubpassDependencies[1].srcStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		vSubpassDependencies[1].dstStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-		vSubpassDependencies[1].srcAccessMask = VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		vSubpassDependencies[1].dstAccessMask = VkAccessFlagBits::VK_ACCESS_MEMORY_READ_BIT;
-		vSubpassDependencies[1].dependencyFlags = VkDependencyFlagBits::VK_DEPENDENCY_BY_REGION_BIT;
-
-		// Create the subpass description.
-		VkAttachmentReference vColorAttachmentReference = {};
-		vColorAttachmentReference.attachment = 0;
-		vColorAttachmentReference.layout = VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentReference vDepthAttachmentReference = {};
-		vDepthAttachmentReference.attachment = 1;
-		vDepthAttachmentReference.layout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		VkSubpassDescription vSubpassDescription = {};
-		vSubpassDescription.flags = 0;
-		vSubpassDescription.colorAttachmentCount = 1;
-		vSubpassDescription.pColorAttachments = &vColorAttachmentReference;
-		vSubpassDescription.pResolveAttachments = nullptr;
-		vSubpassDescription.pDepthStencilAttachment = &vDepthAttachmentReference;
-		vSubpassDescription.inputAttachmentCount = 0;
-		vSubpassDescription.pInputAttachments = nullptr;
-		vSubpassDescription.preserveAttachmentCount = 0;
-		vSubpassDescription.pPreserveAttachments = nullptr;
-		vSubpassDescription.pipelineBindPoint = VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS;
+		for (uint32_t i = 1; i < subpassCount; i++)
+		{
+			vSubpassDependencies[i].srcSubpass = i - 1;
+			vSubpassDependencies[i].dstSubpass = i;
+			vSubpassDependencies[i].srcStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+				VkPipelineStageFlagBits::VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			vSubpassDependencies[i].dstStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+				VkPipelineStageFlagBits::VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			vSubpassDependencies[i].srcAccessMask = VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VkAccessFlagBits::VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			vSubpassDependencies[i].dstAccessMask = VkAccessFlagBits::VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VkAccessFlagBits::VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+				VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VkAccessFlagBits::VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			vSubpassDependencies[i].dependencyFlags = VkDependencyFlagBits::VK_DEPENDENCY_BY_REGION_BIT;
+		}
+
+		// Subpasses which read an attachment as an input attachment also wait on every earlier subpass which wrote to it, not only on the
+		// previous one. The dependencies of the previous subpasses are already added above.
+		for (uint32_t reader = 2; reader < subpassCount; reader++)
+		{
+			const auto& readerSubpass = m_Subpasses[reader];
+			for (uint32_t writer = 0; writer + 1 < reader; writer++)
+			{
+				const auto& writerSubpass = m_Subpasses[writer];
+				const auto bReadsColor = std::any_of(readerSubpass.inputAttachments.begin(), readerSubpass.inputAttachments.end(), [&writerSubpass](const uint32_t attachment)
+					{
+						return std::find(writerSubpass.colorAttachments.begin(), writerSubpass.colorAttachments.end(), attachment) != writerSubpass.colorAttachments.end();
+					});
+
+				const auto bReadsDepth = readerSubpass.bReadDepth && !writerSubpass.bReadDepth;
+				if (!bReadsColor && !bReadsDepth)
+					continue;
+
+				VkSubpassDependency vDependency = {};
+				vDependency.srcSubpass = writer;
+				vDependency.dstSubpass = reader;
+				vDependency.srcStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				vDependency.dstStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+				vDependency.srcAccessMask = VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VkAccessFlagBits::VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+				vDependency.dstAccessMask = VkAccessFlagBits::VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+				vDependency.dependencyFlags = VkDependencyFlagBits::VK_DEPENDENCY_BY_REGION_BIT;
+				vSubpassDependencies.emplace_back(vDependency);
+			}
+		}
+
+		vSubpassDependencies[subpassCount].srcSubpass = subpassCount - 1;
+		vSubpassDependencies[subpassCount].dstSubpass = VK_SUBPASS_EXTERNAL;
+		vSubpassDependencies[subpassCount].srcStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		vSubpassDependencies[subpassCount].dstStageMask = VkPipelineStageFlagBits::VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+		vSubpassDependencies[subpassCount].srcAccessMask = VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		vSubpassDependencies[subpassCount].dstAccessMask = VkAccessFlagBits::VK_ACCESS_MEMORY_READ_BIT;
+		vSubpassDependencies[subpassCount].dependencyFlags = VkDependencyFlagBits::VK_DEPENDENCY_BY_REGION_BIT;
+
+		// Create the attachment references of the subpasses. These have to outlive the subpass descriptions.
+		std::vector<std::vector<VkAttachmentReference>> vColorAttachmentReferences(subpassCount);
+		std::vector<std::vector<VkAttachmentReference>> vInputAttachmentReferences(subpassCount);
+		std::vector<std::vector<VkAttachmentReference>> vResolveAttachmentReferences(subpassCount);
+		std::vector<std::vector<uint32_t>> preserveAttachments(subpassCount);
+		std::vector<VkAttachmentReference> vDepthAttachmentReferences(subpassCount);
+
+		std::vector<VkSubpassDescription> vSubpassDescriptions(subpassCount);
+		for (uint32_t i = 0; i < subpassCount; i++)
+		{
+			const auto& subpass = m_Subpasses[i];
+			for (const auto attachment : subpass.colorAttachments)
+				vColorAttachmentReferences[i].emplace_back(VkAttachmentReference{ attachment, VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+
+			// There needs to be a resolve reference for each color attachment. Only the first attachment is resolved.
+			if (isMultisampled())
+			{
+				for (const auto attachment : subpass.colorAttachments)
+					vResolveAttachmentReferences[i].emplace_back(VkAttachmentReference{ attachment == 0 ? resolveAttachmentIndex : VK_ATTACHMENT_UNUSED, VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+			}
+
+			for (const auto attachment : subpass.inputAttachments)
+				vInputAttachmentReferences[i].emplace_back(VkAttachmentReference{ attachment, VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+
+			// Depth which is read as an input attachment can still be used for depth testing, as long as it is not written.
+			if (subpass.bReadDepth)
+			{
+				vInputAttachmentReferences[i].emplace_back(VkAttachmentReference{ depthAttachmentIndex, VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL });
+				vDepthAttachmentReferences[i] = { depthAttachmentIndex, VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+			}
+			else
+			{
+				vDepthAttachmentReferences[i] = { depthAttachmentIndex, VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+			}
+
+			// Attachments which are not used by this subpass but are used before and after it need to be preserved.
+			for (uint32_t attachment = 0; attachment < colorAttachmentCount; attachment++)
+			{
+				const auto isUsedIn = [this, attachment](const uint32_t first, const uint32_t last)
+				{
+					for (uint32_t j = first; j < last; j++)
+					{
+						const auto& other = m_Subpasses[j];
+						if (std::find(other.colorAttachments.begin(), other.colorAttachments.end(), attachment) != other.colorAttachments.end() ||
+							std::find(other.inputAttachments.begin(), other.inputAttachments.end(), attachment) != other.inputAttachments.end())
+							return true;
+					}
+
+					return false;
+				};
+
+				if (!isUsedIn(i, i + 1) && isUsedIn(0, i) && isUsedIn(i + 1, subpassCount))
+					preserveAttachments[i].emplace_back(attachment);
+			}
+
+			vSubpassDescriptions[i].flags = 0;
+			vSubpassDescriptions[i].colorAttachmentCount = static_cast<uint32_t>(vColorAttachmentReferences[i].size());
+			vSubpassDescriptions[i].pColorAttachments = vColorAttachmentReferences[i].data();
+			vSubpassDescriptions[i].pResolveAttachments = isMultisampled() ? vResolveAttachmentReferences[i].data() : nullptr;
+			vSubpassDescriptions[i].pDepthStencilAttachment = &vDepthAttachmentReferences[i];
+			vSubpassDescriptions[i].inputAttachmentCount = static_cast<uint32_t>(vInputAttachmentReferences[i].size());
+			vSubpassDescriptions[i].pInputAttachments = vInputAttachmentReferences[i].data();
+			vSubpassDescriptions[i].preserveAttachmentCount = static_cast<uint32_t>(preserveAttachments[i].size());
+			vSubpassDescriptions[i].pPreserveAttachments = preserveAttachments[i].data();
+			vSubpassDescriptions[i].pipelineBindPoint = VkPipelineBindPoint::VK_PIPELINE_BIND_POINT_GRAPHICS;
+		}
 
 		// Create the render target.
 		VkRenderPassCreateInfo vRenderPassCreateInfo = {};
 		vRenderPassCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 		vRenderPassCreateInfo.pNext = nullptr;
 		vRenderPassCreateInfo.flags = 0;
-		vRenderPassCreateInfo.attachmentCount = 2;
+		vRenderPassCreateInfo.attachmentCount = static_cast<uint32_t>(vAttachmentDescriptions.size());
 		vRenderPassCreateInfo.pAttachments = vAttachmentDescriptions.data();
-		vRenderPassCreateInfo.dependencyCount = 2;
+		vRenderPassCreateInfo.dependencyCount = static_cast<uint32_t>(vSubpassDependencies.size());
 		vRenderPassCreateInfo.pDependencies = vSubpassDependencies.data();
-		vRenderPassCreateInfo.subpassCount = 1;
-		vRenderPassCreateInfo.pSubpasses = &vSubpassDescription;
+		vRenderPassCreateInfo.subpassCount = subpassCount;
+		vRenderPassCreateInfo.pSubpasses = vSubpassDescriptions.data();
 
 		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkCreateRenderPass(getEngine()->getLogicalDevice(), &vRenderPassCreateInfo, nullptr, &m_vRenderPass), "Failed to create render pass!");
 	}
 	
 	void RenderTarget::createFramebuffer()
 	{
+		// The attachments follow the render pass order. When multisampling, the multisampled image is rendered to and the color attachment is the resolve target.
+		std::vector<VkImageView> vImageViews;
+		for (const auto& pAttachment : m_pColorAttachments)
+			vImageViews.emplace_back(pAttachment->getImageView());
+
+		vImageViews.emplace_back(m_pDepthAttachment->getImageView());
+
+		if (isMultisampled())
+		{
+			vImageViews.emplace_back(vImageViews.front());
+			vImageViews.front() = m_pMultisampleColorAttachment->getImageView();
+		}
+
 		VkFramebufferCreateInfo vFramebufferCreateInfo = {};
 		vFramebufferCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
 		vFramebufferCreateInfo.flags = 0;
@@ -166,18 +418,12 @@ namespace Firefly
 		vFramebufferCreateInfo.renderPass = m_vRenderPass;
 		vFramebufferCreateInfo.width = m_Extent.width;
 		vFramebufferCreateInfo.height = m_Extent.height;
-		vFramebufferCreateInfo.attachmentCount = 2;
+		vFramebufferCreateInfo.attachmentCount = static_cast<uint32_t>(vImageViews.size());
+		vFramebufferCreateInfo.pAttachments = vImageViews.data();
 
 		// Iterate and create the frame buffers.
 		for (uint8_t i = 0; i < m_FrameCount; i++)
-		{
-			std::array<VkImageView, 2> vImageViews;
-			vImageViews[0] = m_pColorAttachment->getImageView();
-			vImageViews[1] = m_pDepthAttachment->getImageView();
-
-			vFramebufferCreateInfo.pAttachments = vImageViews.data();
 			FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkCreateFramebuffer(getEngine()->getLogicalDevice(), &vFramebufferCreateInfo, nullptr, &m_vFrameBuffers[i]), "Failed to create the frame buffer!");
-		}
 	}
 
 	void RenderTarget::createCommandPool()
@@ -211,26 +457,83 @@ namespace Firefly
 			m_pCommandBuffers.emplace_back(CommandBuffer::create(getEngine(), m_vCommandPool, vCommandBuffer));
 	}
 	
-	void RenderTarget::initialize(const VkFormat vColorFormat)
+	void RenderTarget::initialize(const std::vector<AttachmentSpecification>& attachments, const std::vector<SubpassSpecification>& subpasses)
 	{
-		m_vFrameBuffers.resize(m_FrameCount);
+		// Only the first attachment has a multisampled image and a resolve target.
+		if (isMultisampled() && attachments.size() > 1)
+			throw BackendError("Multisampling is only supported with a single color attachment!");
+
+		m_Attachments = attachments;
+		m_Subpasses = subpasses;
+
 		m_pCommandBuffers.reserve(m_FrameCount);
+		m_FrameRecordedStates.resize(m_FrameCount, false);
+
+		// Find the attachments which are read by a subpass.
+		std::vector<bool> inputStates(m_Attachments.size(), false);
+		bool bIsDepthRead = false;
+		for (const auto& subpass : m_Subpasses)
+		{
+			for (const auto attachment : subpass.inputAttachments)
+				inputStates[attachment] = true;
 
-		// Create the attachments.
-		m_pColorAttachment = Image::create(getEngine(), m_Extent, vColorFormat, ImageType::TwoDimension, 1, VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
-		m_pColorAttachment->changeImageLayout(VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-		m_pDepthAttachment = Image::create(getEngine(), m_Extent, getEngine()->findBestDepthFormat(), ImageType::TwoDimension, 1, VkImageUsageFlagBits::VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+			bIsDepthRead |= subpass.bReadDepth;
+		}
 
-		// Create the render pass.
-		createRenderPass();
+		// Create the color attachments. The first one is the main output which can be copied from. The others only live within the render pass
+		// if they are not stored.
+		m_pColorAttachments.reserve(m_Attachments.size());
+		for (uint32_t i = 0; i < m_Attachments.size(); i++)
+		{
+			const auto& attachment = m_Attachments[i];
+			const auto bIsTransient = i > 0 && attachment.vStoreOp != VkAttachmentStoreOp::VK_ATTACHMENT_STORE_OP_STORE;
+
+			VkImageUsageFlags vUsageFlags = VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			if (i == 0)
+				vUsageFlags |= VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+			if (inputStates[i])
+				vUsageFlags |= VkImageUsageFlagBits::VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+			if (bIsTransient)
+				vUsageFlags |= VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+			const auto& pAttachment = m_pColorAttachments.emplace_back(Image::create(getEngine(), m_Extent, attachment.vFormat, ImageType::TwoDimension, 1, vUsageFlags));
+			if (!bIsTransient)
+				pAttachment->changeImageLayout(VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+		}
 
-		// Create the frame buffers.
-		createFramebuffer();
+		// The depth attachment is never stored, and the multisampled color attachment is resolved within the pass, so both of them are transient.
+		VkImageUsageFlags vDepthUsageFlags = VkImageUsageFlagBits::VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		if (bIsDepthRead)
+			vDepthUsageFlags |= VkImageUsageFlagBits::VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+		m_pDepthAttachment = Image::create(getEngine(), m_Extent, getEngine()->findBestDepthFormat(), ImageType::TwoDimension, 1, vDepthUsageFlags, 1, std::nullopt, m_SampleCount);
+
+		if (isMultisampled())
+		{
+			m_pMultisampleColorAttachment = Image::create(getEngine(), m_Extent, m_Attachments.front().vFormat, ImageType::TwoDimension, 1,
+				VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, 1, std::nullopt, m_SampleCount);
+		}
+
+		// Create the render pass and the frame buffers. Dynamic rendering does not need them.
+		if (!m_bUseDynamicRendering)
+		{
+			m_vFrameBuffers.resize(m_FrameCount);
+
+			createRenderPass();
+			createFramebuffer();
+		}
 
 		// Create the command pool.
 		createCommandPool();
 
 		// Allocate command buffers.
 		allocateCommandBuffer();
+
+		// Create the transient descriptor allocators. Their blocks are created on the first allocation.
+		m_pTransientAllocators.reserve(m_FrameCount);
+		for (uint8_t i = 0; i < m_FrameCount; i++)
+			m_pTransientAllocators.emplace_back(DescriptorAllocator::create(getEngine(), TransientPoolSizes, TransientSetsPerBlock));
 	}
 }
\ No newline at end of file
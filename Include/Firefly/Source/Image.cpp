@@ -1,51 +1,75 @@
 #include "Firefly/Image.hpp"
 
+#include <algorithm>
+
 namespace /* anonymous */
 {
-	VkPipelineStageFlags GetPipelineStageFlags(const VkAccessFlags flags)
+	/**
+	 * Get the pipeline stages which perform an access.
+	 * Only the stages of the enabled features are returned, as barriers must not use the stages of features which are not enabled.
+	 *
+	 * @param flags The access flags.
+	 * @param vFeatures The enabled device features.
+	 * @return The pipeline stage flags.
+	 */
+	VkPipelineStageFlags2 GetPipelineStageFlags(const VkAccessFlags2 flags, const VkPhysicalDeviceFeatures& vFeatures)
 	{
+		VkPipelineStageFlags2 vShaderStages = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		if (vFeatures.tessellationShader)
+			vShaderStages |= VK_PIPELINE_STAGE_2_TESSELLATION_CONTROL_SHADER_BIT | VK_PIPELINE_STAGE_2_TESSELLATION_EVALUATION_SHADER_BIT;
+
+		if (vFeatures.geometryShader)
+			vShaderStages |= VK_PIPELINE_STAGE_2_GEOMETRY_SHADER_BIT;
+
 		switch (flags)
 		{
-		case VkAccessFlagBits::VK_ACCESS_INDIRECT_COMMAND_READ_BIT:							return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR;
-		case  VkAccessFlagBits::VK_ACCESS_INDEX_READ_BIT:									return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT:						return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_UNIFORM_READ_BIT:									return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_SHADER_READ_BIT:									return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_SHADER_WRITE_BIT:									return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_INPUT_ATTACHMENT_READ_BIT:						return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_READ_BIT:						return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT:						return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT:				return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT:				return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_TRANSFER_READ_BIT:								return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TRANSFER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR;
-		case  VkAccessFlagBits::VK_ACCESS_TRANSFER_WRITE_BIT:								return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TRANSFER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR;
-		case  VkAccessFlagBits::VK_ACCESS_HOST_READ_BIT:									return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_HOST_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_HOST_WRITE_BIT:									return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_HOST_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_MEMORY_READ_BIT:									return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_MEMORY_WRITE_BIT:									return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_READ_NONCOHERENT_BIT_EXT:		return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_COMMAND_PREPROCESS_READ_BIT_NV:					return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COMMAND_PREPROCESS_BIT_NV;
-		case  VkAccessFlagBits::VK_ACCESS_COMMAND_PREPROCESS_WRITE_BIT_NV:					return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COMMAND_PREPROCESS_BIT_NV;
-		case  VkAccessFlagBits::VK_ACCESS_CONDITIONAL_RENDERING_READ_BIT_EXT:				return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_CONDITIONAL_RENDERING_BIT_EXT;
-		case  VkAccessFlagBits::VK_ACCESS_FRAGMENT_SHADING_RATE_ATTACHMENT_READ_BIT_KHR:	return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR;
-		case  VkAccessFlagBits::VK_ACCESS_TRANSFORM_FEEDBACK_WRITE_BIT_EXT:					return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT;
-		case  VkAccessFlagBits::VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT:			return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT;
-		case  VkAccessFlagBits::VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_READ_BIT_EXT:			return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
-		case  VkAccessFlagBits::VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR:				return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VkPipelineStageFlagBits::VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR;
-		case  VkAccessFlagBits::VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR:				return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR;
-		case  VkAccessFlagBits::VK_ACCESS_FRAGMENT_DENSITY_MAP_READ_BIT_EXT:				return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_FRAGMENT_DENSITY_PROCESS_BIT_EXT;
-		default:																			break;
+		case VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT:				return VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+		case VK_ACCESS_2_INDEX_READ_BIT:						return VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT;
+		case VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT:				return VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT;
+		case VK_ACCESS_2_UNIFORM_READ_BIT:						return vShaderStages;
+		case VK_ACCESS_2_SHADER_READ_BIT:						return vShaderStages;
+		case VK_ACCESS_2_SHADER_WRITE_BIT:						return vShaderStages;
+		case VK_ACCESS_2_INPUT_ATTACHMENT_READ_BIT:				return VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+		case VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT:				return VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+		case VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT:			return VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+		case VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT:		return VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+		case VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT:	return VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+		case VK_ACCESS_2_TRANSFER_READ_BIT:						return VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+		case VK_ACCESS_2_TRANSFER_WRITE_BIT:					return VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+		case VK_ACCESS_2_HOST_READ_BIT:							return VK_PIPELINE_STAGE_2_HOST_BIT;
+		case VK_ACCESS_2_HOST_WRITE_BIT:						return VK_PIPELINE_STAGE_2_HOST_BIT;
+		default:												break;
 		}
 
-		return VkPipelineStageFlagBits::VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		// Anything else, including the accesses of extensions, is covered by all the commands.
+		return VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+	}
+
+	/**
+	 * Check if an access mask contains any write access.
+	 *
+	 * @param flags The access flags.
+	 * @return Boolean stating if it writes or not.
+	 */
+	bool HasWriteAccess(const VkAccessFlags2 flags)
+	{
+		constexpr VkAccessFlags2 WriteAccessFlags = VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+			VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+
+		return flags & WriteAccessFlags;
 	}
 }
 
 namespace Firefly
 {
-	Image::Image(const std::shared_ptr<Engine>& pEngine, const VkExtent3D extent, const VkFormat format, const ImageType type, const uint32_t layers, const VkImageUsageFlags usageFlags)
-		: EngineBoundObject(pEngine), m_Extent(extent), m_Format(format), m_Type(type), m_Layers(layers), m_UsageFlags(usageFlags)
+	Image::Image(const std::shared_ptr<Engine>& pEngine, const VkExtent3D extent, const VkFormat format, const ImageType type, const uint32_t layers, const VkImageUsageFlags usageFlags, const uint32_t mipLevels,
+		const std::optional<SamplerSpecification>& samplerSpecification, const VkSampleCountFlagBits vSampleCount)
+		: EngineBoundObject(pEngine), m_Extent(extent), m_SamplerSpecification(samplerSpecification.value_or(SamplerSpecification())), m_MipStates(mipLevels),
+		m_Format(format), m_Type(type), m_Layers(layers), m_MipLevels(mipLevels), m_UsageFlags(usageFlags), m_SampleCount(vSampleCount)
 	{
+		// Cube maps are clamped to the edges by default, so the faces do not bleed into each other.
+		if (!samplerSpecification && m_Type == ImageType::CubeMap)
+			m_SamplerSpecification.vAddressMode = VkSamplerAddressMode::VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
 	}
 
 	Image::~Image()
@@ -56,34 +80,37 @@ namespace Firefly
 
 	void Image::fromBuffer(const Buffer* pBuffer)
 	{
-		VkBufferImageCopy vImageCopy = {};
-		vImageCopy.imageExtent = m_Extent;
-		vImageCopy.imageOffset = {};
-		vImageCopy.imageSubresource.aspectMask = getImageAspectFlags();
-		vImageCopy.imageSubresource.baseArrayLayer = 0;
-		vImageCopy.imageSubresource.layerCount = m_Layers;
-		vImageCopy.imageSubresource.mipLevel = 0;
-		vImageCopy.bufferOffset = 0;
-		vImageCopy.bufferRowLength = m_Extent.width;
-		vImageCopy.bufferImageHeight = m_Extent.height;
-
-		const auto oldlayout = m_CurrentLayout;
-		const auto vCommandBuffer = getEngine()->beginCommandBufferRecording();
+		fromBuffer(pBuffer, { 0 });
+	}
 
-		// Change the layout to transfer source
-		changeImageLayout(VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, vCommandBuffer);
+	void Image::fromBuffer(const Buffer* pBuffer, const std::vector<uint64_t>& mipLevelOffsets)
+	{
+		if (mipLevelOffsets.empty() || mipLevelOffsets.size() > m_MipLevels)
+			throw BackendError("Invalid mip level offset count!");
 
-		// Copy the image.
-		getEngine()->getDeviceTable().vkCmdCopyBufferToImage(vCommandBuffer, pBuffer->getBuffer(), m_vImage, m_CurrentLayout, 1, &vImageCopy);
-
-		// Get it back to the old layout.
-		if (oldlayout != VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED && oldlayout != VkImageLayout::VK_IMAGE_LAYOUT_PREINITIALIZED)
-			changeImageLayout(oldlayout, vCommandBuffer);
+		recordCopyFromBuffer(getEngine()->beginCommandBufferRecording(), pBuffer->getBuffer(), 0, mipLevelOffsets);
 
 		// Execute the commands.
 		getEngine()->executeRecordedCommands();
 	}
 
+	void Image::fromMemory(const void* pData, const uint64_t size)
+	{
+		fromMemory(pData, size, { 0 });
+	}
+
+	void Image::fromMemory(const void* pData, const uint64_t size, const std::vector<uint64_t>& mipLevelOffsets)
+	{
+		if (mipLevelOffsets.empty() || mipLevelOffsets.size() > m_MipLevels)
+			throw BackendError("Invalid mip level offset count!");
+
+		// The staged data stays valid till the engine's command buffer is executed.
+		const auto [vStagingBuffer, stagingOffset] = getEngine()->stageData(pData, size);
+
+		// The commands are left in the engine's command buffer and are executed along with the next submission.
+		recordCopyFromBuffer(getEngine()->beginCommandBufferRecording(), vStagingBuffer, stagingOffset, mipLevelOffsets);
+	}
+
 	std::shared_ptr<Buffer> Image::toBuffer()
 	{
 		const auto size = static_cast<uint64_t>(m_Extent.width) * m_Extent.height * m_Extent.depth * getPixelSize();
@@ -100,18 +127,18 @@ namespace Firefly
 		vImageCopy.bufferRowLength = m_Extent.width;
 		vImageCopy.bufferImageHeight = m_Extent.height;
 
-		const auto oldlayout = m_CurrentLayout;
+		const auto oldlayout = getImageLayout();
 		const auto vCommandBuffer = getEngine()->beginCommandBufferRecording();
 
 		// Change the layout to transfer source
-		changeImageLayout(VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, vCommandBuffer);
+		changeMipLevelLayout(VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0, 1, vCommandBuffer);
 
 		// Copy the image.
-		getEngine()->getDeviceTable().vkCmdCopyImageToBuffer(vCommandBuffer, m_vImage, m_CurrentLayout, pBuffer->getBuffer(), 1, &vImageCopy);
+		getEngine()->getDeviceTable().vkCmdCopyImageToBuffer(vCommandBuffer, m_vImage, getImageLayout(), pBuffer->getBuffer(), 1, &vImageCopy);
 
 		// Get it back to the old layout.
 		if (oldlayout != VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED && oldlayout != VkImageLayout::VK_IMAGE_LAYOUT_PREINITIALIZED)
-			changeImageLayout(oldlayout, vCommandBuffer);
+			changeMipLevelLayout(oldlayout, 0, 1, vCommandBuffer);
 
 		// Execute the commands.
 		getEngine()->executeRecordedCommands();
@@ -121,145 +148,116 @@ namespace Firefly
 
 	void Image::changeImageLayout(const VkImageLayout newLayout, const VkCommandBuffer vCommandBuffer)
 	{
-		// Create the memory barrier.
-		VkImageMemoryBarrier vMemoryBarrier = {};
-		vMemoryBarrier.sType = VkStructureType::VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		vMemoryBarrier.oldLayout = m_CurrentLayout;
-		vMemoryBarrier.newLayout = newLayout;
-		vMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		vMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		vMemoryBarrier.image = m_vImage;
-
-		if (m_CurrentLayout == VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL ||
-			m_CurrentLayout == VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL ||
-			m_CurrentLayout == VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL ||
-			newLayout == VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL ||
-			newLayout == VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL ||
-			newLayout == VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
-		{
-			vMemoryBarrier.subresourceRange.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_DEPTH_BIT;
-
-			if (hasStencilComponent())
-				vMemoryBarrier.subresourceRange.aspectMask |= VkImageAspectFlagBits::VK_IMAGE_ASPECT_STENCIL_BIT;
-		}
-		else
-			vMemoryBarrier.subresourceRange.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT;
+		changeMipLevelLayout(newLayout, 0, m_MipLevels, vCommandBuffer);
+	}
 
-		vMemoryBarrier.subresourceRange.baseMipLevel = 0;
-		vMemoryBarrier.subresourceRange.levelCount = 1;
-		vMemoryBarrier.subresourceRange.layerCount = m_Layers;
-		vMemoryBarrier.subresourceRange.baseArrayLayer = 0;
-		vMemoryBarrier.srcAccessMask = 0;
-		vMemoryBarrier.dstAccessMask = 0;
+	void Image::changeMipLevelLayout(const VkImageLayout newLayout, const uint32_t baseMipLevel, const uint32_t levelCount, const VkCommandBuffer vCommandBuffer)
+	{
+		// Mip levels which are next to each other and are in the same state are transitioned using a single barrier.
+		std::vector<VkImageMemoryBarrier2> vMemoryBarriers;
 
-		// Resolve the source access masks.
-		switch (m_CurrentLayout)
+		const auto endMipLevel = baseMipLevel + levelCount;
+		for (auto mipLevel = baseMipLevel; mipLevel < endMipLevel;)
 		{
-		case VkImageLayout::VK_IMAGE_LAYOUT_GENERAL:
-		case VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED:
-			vMemoryBarrier.srcAccessMask = 0;
-			break;
-
-		case VkImageLayout::VK_IMAGE_LAYOUT_PREINITIALIZED:
-			vMemoryBarrier.srcAccessMask = VkAccessFlagBits::VK_ACCESS_HOST_WRITE_BIT;
-			break;
-
-		case VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
-			vMemoryBarrier.srcAccessMask = VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			break;
-
-		case VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
-			vMemoryBarrier.srcAccessMask = VkAccessFlagBits::VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-			break;
-
-		case VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
-			vMemoryBarrier.srcAccessMask = VkAccessFlagBits::VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
-			break;
-
-		case VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
-			vMemoryBarrier.srcAccessMask = VkAccessFlagBits::VK_ACCESS_TRANSFER_READ_BIT;
-			break;
+			const auto oldState = m_MipStates[mipLevel];
 
-		case VkImageLayout::VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
-			//vMB.srcAccessMask = VK_ACCESS_;
-			break;
+			auto runEnd = mipLevel + 1;
+			while (runEnd < endMipLevel && m_MipStates[runEnd] == oldState)
+				runEnd++;
 
-		case VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-			vMemoryBarrier.srcAccessMask = VkAccessFlagBits::VK_ACCESS_TRANSFER_WRITE_BIT;
-			break;
+			const auto vMemoryBarrier = createLayoutBarrier(oldState, newLayout, mipLevel, runEnd - mipLevel);
 
-		case VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-			vMemoryBarrier.srcAccessMask = VkAccessFlagBits::VK_ACCESS_SHADER_READ_BIT;
-			break;
+			// Reads which follow reads in the same layout do not need a barrier.
+			if (oldState.vLayout != newLayout || HasWriteAccess(oldState.vAccessMask) || HasWriteAccess(vMemoryBarrier.dstAccessMask))
+				vMemoryBarriers.emplace_back(vMemoryBarrier);
 
-		default:
-			throw BackendError("Unsupported layout transition!");
+			std::fill(m_MipStates.begin() + mipLevel, m_MipStates.begin() + runEnd, SubresourceState{ newLayout, vMemoryBarrier.dstAccessMask, vMemoryBarrier.dstStageMask });
+			mipLevel = runEnd;
 		}
 
-		// Resolve the destination access masks.
-		switch (newLayout)
-		{
-		case VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED:
-		case VkImageLayout::VK_IMAGE_LAYOUT_GENERAL:
-		case VkImageLayout::VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
-			break;
+		// If a command buffer was not given, the barriers are queued and are executed before the next submission.
+		if (vCommandBuffer == VK_NULL_HANDLE)
+			getEngine()->queueImageBarriers(vMemoryBarriers);
 
-		case VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-			vMemoryBarrier.dstAccessMask = VkAccessFlagBits::VK_ACCESS_TRANSFER_WRITE_BIT;
-			break;
+		else
+			getEngine()->recordImageBarriers(vCommandBuffer, vMemoryBarriers);
+	}
 
-		case VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
-			vMemoryBarrier.dstAccessMask = VkAccessFlagBits::VK_ACCESS_TRANSFER_READ_BIT;
-			break;
+	void Image::generateMipMaps(const VkImageLayout finalLayout, const VkCommandBuffer vCommandBuffer)
+	{
+		VkFormatProperties vFormatProperties = {};
+		vkGetPhysicalDeviceFormatProperties(getEngine()->getPhysicalDevice(), m_Format, &vFormatProperties);
 
-		case VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
-			vMemoryBarrier.dstAccessMask = VkAccessFlagBits::VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			break;
+		const auto vFeatures = vFormatProperties.optimalTilingFeatures;
+		if (!(vFeatures & VkFormatFeatureFlagBits::VK_FORMAT_FEATURE_BLIT_SRC_BIT) || !(vFeatures & VkFormatFeatureFlagBits::VK_FORMAT_FEATURE_BLIT_DST_BIT))
+			throw BackendError("The image format does not support blitting, so the mip levels cannot be generated!");
 
-		case VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
-			vMemoryBarrier.dstAccessMask = vMemoryBarrier.dstAccessMask | VkAccessFlagBits::VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-			break;
+		// Formats which cannot be filtered linearly are downsampled by picking the nearest texel.
+		const auto vFilter = vFeatures & VkFormatFeatureFlagBits::VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT ? VkFilter::VK_FILTER_LINEAR : VkFilter::VK_FILTER_NEAREST;
 
-		case VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-			vMemoryBarrier.srcAccessMask |= VkAccessFlagBits::VK_ACCESS_HOST_WRITE_BIT | VkAccessFlagBits::VK_ACCESS_TRANSFER_WRITE_BIT;
-			vMemoryBarrier.dstAccessMask = VkAccessFlagBits::VK_ACCESS_SHADER_READ_BIT;
-			break;
+		// Here we begin the buffer recording if a command buffer was not given.
+		const auto vRecordingCommandBuffer = vCommandBuffer == VK_NULL_HANDLE ? getEngine()->beginCommandBufferRecording() : vCommandBuffer;
 
-		default:
-			throw BackendError("Unsupported layout transition!");
+		auto width = static_cast<int32_t>(m_Extent.width);
+		auto height = static_cast<int32_t>(m_Extent.height);
+
+		for (uint32_t mipLevel = 1; mipLevel < m_MipLevels; mipLevel++)
+		{
+			const auto mipWidth = std::max(width / 2, 1);
+			const auto mipHeight = std::max(height / 2, 1);
+
+			// The previous level is read from while this one is written to.
+			changeMipLevelLayout(VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, mipLevel - 1, 1, vRecordingCommandBuffer);
+			changeMipLevelLayout(VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevel, 1, vRecordingCommandBuffer);
+
+			VkImageBlit vImageBlit = {};
+			vImageBlit.srcOffsets[0] = { 0, 0, 0 };
+			vImageBlit.srcOffsets[1] = { width, height, 1 };
+			vImageBlit.srcSubresource.aspectMask = getImageAspectFlags();
+			vImageBlit.srcSubresource.mipLevel = mipLevel - 1;
+			vImageBlit.srcSubresource.baseArrayLayer = 0;
+			vImageBlit.srcSubresource.layerCount = m_Layers;
+			vImageBlit.dstOffsets[0] = { 0, 0, 0 };
+			vImageBlit.dstOffsets[1] = { mipWidth, mipHeight, 1 };
+			vImageBlit.dstSubresource.aspectMask = getImageAspectFlags();
+			vImageBlit.dstSubresource.mipLevel = mipLevel;
+			vImageBlit.dstSubresource.baseArrayLayer = 0;
+			vImageBlit.dstSubresource.layerCount = m_Layers;
+
+			getEngine()->getDeviceTable().vkCmdBlitImage(vRecordingCommandBuffer, m_vImage, VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_vImage,
+				VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &vImageBlit, vFilter);
+
+			width = mipWidth;
+			height = mipHeight;
 		}
 
-		// Resolve the pipeline stages.
-		const VkPipelineStageFlags sourceStage = GetPipelineStageFlags(vMemoryBarrier.srcAccessMask);
-		const VkPipelineStageFlags destinationStage = GetPipelineStageFlags(vMemoryBarrier.dstAccessMask);
+		// All the levels but the last one are in the transfer source layout, and the last one is in the transfer destination layout.
+		changeImageLayout(finalLayout, vRecordingCommandBuffer);
 
-		// Issue the commands. 
-		// Here we begin the buffer recording if a command buffer was not given.
 		if (vCommandBuffer == VK_NULL_HANDLE)
-		{
-			getEngine()->getDeviceTable().vkCmdPipelineBarrier(getEngine()->beginCommandBufferRecording(), sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &vMemoryBarrier);
 			getEngine()->executeRecordedCommands();
-		}
-		else
-			getEngine()->getDeviceTable().vkCmdPipelineBarrier(vCommandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &vMemoryBarrier);
-
-		m_CurrentLayout = newLayout;
 	}
 
 	void Image::terminate()
 	{
-		// Terminate the sampler if created.
-		if (m_vSampler != VK_NULL_HANDLE)
-			getEngine()->getDeviceTable().vkDestroySampler(getEngine()->getLogicalDevice(), m_vSampler, nullptr);
+		// Pending transitions and uploads of this image must be executed before it's destroyed.
+		getEngine()->submitPendingCommands();
 
 		getEngine()->getDeviceTable().vkDestroyImageView(getEngine()->getLogicalDevice(), m_vImageView, nullptr);
 		vmaDestroyImage(getEngine()->getAllocator(), m_vImage, m_Allocation);
 		toggleTerminated();
 	}
 
-	std::shared_ptr<Firefly::Image> Image::create(const std::shared_ptr<Engine>& pEngine, const VkExtent3D extent, const VkFormat format, const ImageType type, const uint32_t layers /*= 1*/, const VkImageUsageFlags usageFlags /*= VkImageUsageFlagBits::VK_IMAGE_USAGE_SAMPLED_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_DST_BIT*/)
+	std::shared_ptr<Firefly::Image> Image::create(const std::shared_ptr<Engine>& pEngine, const VkExtent3D extent, const VkFormat format, const ImageType type, const uint32_t layers /*= 1*/, const VkImageUsageFlags usageFlags /*= VkImageUsageFlagBits::VK_IMAGE_USAGE_SAMPLED_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSFER_DST_BIT*/, const uint32_t mipLevels /*= 1*/,
+		const std::optional<SamplerSpecification>& samplerSpecification /*= std::nullopt*/, const VkSampleCountFlagBits vSampleCount /*= VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT*/)
 	{
-		const auto pointer = std::make_shared<Image>(pEngine, extent, format, type, layers, usageFlags);
+		if (mipLevels == 0 || mipLevels > GetMipLevelCount(extent))
+			throw BackendError("Invalid mip level count!");
+
+		if (vSampleCount != VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT && mipLevels != 1)
+			throw BackendError("Multisampled images cannot have more than one mip level!");
+
+		const auto pointer = std::make_shared<Image>(pEngine, extent, format, type, layers, usageFlags, mipLevels, samplerSpecification, vSampleCount);
 		FIREFLY_VALIDATE_OBJECT(pointer);
 
 		pointer->initialize();
@@ -267,9 +265,23 @@ namespace Firefly
 		return pointer;
 	}
 
-	uint8_t Image::getPixelSize() const
+	uint32_t Image::GetMipLevelCount(const VkExtent3D extent)
+	{
+		// Each level halves the largest dimension till it reaches 1.
+		auto largest = std::max(extent.width, extent.height);
+		uint32_t mipLevels = 1;
+		while (largest > 1)
+		{
+			largest /= 2;
+			mipLevels++;
+		}
+
+		return mipLevels;
+	}
+
+	uint8_t Image::GetPixelSize(const VkFormat format)
 	{
-		switch (m_Format)
+		switch (format)
 		{
 		case VkFormat::VK_FORMAT_R8_UNORM:
 		case VkFormat::VK_FORMAT_R8_SNORM:
@@ -554,7 +566,7 @@ namespace Firefly
 		else if (m_UsageFlags & VkImageUsageFlagBits::VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)
 		{
 			//changeImageLayout(VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);	// TODO
-			m_CurrentLayout = VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+			std::fill(m_MipStates.begin(), m_MipStates.end(), SubresourceState{ VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE });
 		}
 	}
 
@@ -566,14 +578,14 @@ namespace Firefly
 		vImageCreateInfo.extent = m_Extent;
 		vImageCreateInfo.format = m_Format;
 		vImageCreateInfo.arrayLayers = m_Layers;
-		vImageCreateInfo.initialLayout = m_CurrentLayout;
+		vImageCreateInfo.initialLayout = VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED;
 		vImageCreateInfo.imageType = VkImageType::VK_IMAGE_TYPE_2D;
 		vImageCreateInfo.queueFamilyIndexCount = 0;
 		vImageCreateInfo.pQueueFamilyIndices = nullptr;
-		vImageCreateInfo.samples = VkSampleCountFlagBits::VK_SAMPLE_COUNT_1_BIT;
+		vImageCreateInfo.samples = m_SampleCount;
 		vImageCreateInfo.tiling = VkImageTiling::VK_IMAGE_TILING_OPTIMAL;
 		vImageCreateInfo.usage = m_UsageFlags;
-		vImageCreateInfo.mipLevels = 1;
+		vImageCreateInfo.mipLevels = m_MipLevels;
 
 		if (m_Type == ImageType::CubeMap)
 			vImageCreateInfo.flags = VkImageCreateFlagBits::VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
@@ -581,6 +593,17 @@ namespace Firefly
 		VmaAllocationCreateInfo vAllocationCreateInfo = {};
 		vAllocationCreateInfo.usage = VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY;
 
+		// Transient attachments never leave the tile memory on tiled GPUs, so they don't need to be backed by real memory.
+		if (m_UsageFlags & VkImageUsageFlagBits::VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+		{
+			vAllocationCreateInfo.usage = VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED;
+			if (vmaCreateImage(getEngine()->getAllocator(), &vImageCreateInfo, &vAllocationCreateInfo, &m_vImage, &m_Allocation, nullptr) == VkResult::VK_SUCCESS)
+				return;
+
+			// The device does not have lazily allocated memory, so we fall back to regular device memory.
+			vAllocationCreateInfo.usage = VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY;
+		}
+
 		FIREFLY_VALIDATE(vmaCreateImage(getEngine()->getAllocator(), &vImageCreateInfo, &vAllocationCreateInfo, &m_vImage, &m_Allocation, nullptr), "Failed to create the image!");
 	}
 
@@ -595,7 +618,7 @@ namespace Firefly
 		vImageViewCreateInfo.viewType = VkImageViewType::VK_IMAGE_VIEW_TYPE_2D;
 		vImageViewCreateInfo.subresourceRange.layerCount = m_Layers;
 		vImageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
-		vImageViewCreateInfo.subresourceRange.levelCount = 1;
+		vImageViewCreateInfo.subresourceRange.levelCount = m_MipLevels;
 		vImageViewCreateInfo.subresourceRange.baseMipLevel = 0;
 		vImageViewCreateInfo.subresourceRange.aspectMask = getImageAspectFlags();
 		vImageViewCreateInfo.components.r = VkComponentSwizzle::VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -611,31 +634,7 @@ namespace Firefly
 
 	void Image::createImageSampler()
 	{
-		VkSamplerAddressMode addressMode = VkSamplerAddressMode::VK_SAMPLER_ADDRESS_MODE_REPEAT;
-
-		if (m_Type == ImageType::CubeMap)	// TODO
-			addressMode = VkSamplerAddressMode::VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-
-		VkSamplerCreateInfo vSamplerCreateInfo = {};
-		vSamplerCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		vSamplerCreateInfo.pNext = nullptr;
-		vSamplerCreateInfo.magFilter = VkFilter::VK_FILTER_LINEAR;
-		vSamplerCreateInfo.minFilter = VkFilter::VK_FILTER_LINEAR;
-		vSamplerCreateInfo.addressModeU = addressMode;
-		vSamplerCreateInfo.addressModeV = addressMode;
-		vSamplerCreateInfo.addressModeW = addressMode;
-		vSamplerCreateInfo.anisotropyEnable = VK_TRUE;
-		vSamplerCreateInfo.maxAnisotropy = getEngine()->getPhysicalDeviceProperties().limits.maxSamplerAnisotropy;
-		vSamplerCreateInfo.borderColor = VkBorderColor::VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-		vSamplerCreateInfo.unnormalizedCoordinates = VK_FALSE;
-		vSamplerCreateInfo.compareEnable = VK_FALSE;
-		vSamplerCreateInfo.compareOp = VkCompareOp::VK_COMPARE_OP_ALWAYS;
-		vSamplerCreateInfo.mipmapMode = VkSamplerMipmapMode::VK_SAMPLER_MIPMAP_MODE_LINEAR;
-		vSamplerCreateInfo.minLod = 0.0;
-		vSamplerCreateInfo.maxLod = 1;
-		vSamplerCreateInfo.mipLodBias = 0.0;
-
-		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkCreateSampler(getEngine()->getLogicalDevice(), &vSamplerCreateInfo, nullptr, &m_vSampler), "Failed to create the image sampler!");
+		m_vSampler = getEngine()->getSampler(m_SamplerSpecification);
 	}
 
 	VkImageAspectFlags Image::getImageAspectFlags() const
@@ -651,4 +650,126 @@ namespace Firefly
 
 		return 0;
 	}
+
+	void Image::recordCopyFromBuffer(const VkCommandBuffer vCommandBuffer, const VkBuffer vBuffer, const uint64_t bufferOffset, const std::vector<uint64_t>& mipLevelOffsets)
+	{
+		std::vector<VkBufferImageCopy> vImageCopies(mipLevelOffsets.size());
+		for (uint32_t mipLevel = 0; mipLevel < vImageCopies.size(); mipLevel++)
+		{
+			auto& vImageCopy = vImageCopies[mipLevel];
+			vImageCopy.imageExtent.width = std::max(m_Extent.width >> mipLevel, 1u);
+			vImageCopy.imageExtent.height = std::max(m_Extent.height >> mipLevel, 1u);
+			vImageCopy.imageExtent.depth = std::max(m_Extent.depth >> mipLevel, 1u);
+			vImageCopy.imageOffset = {};
+			vImageCopy.imageSubresource.aspectMask = getImageAspectFlags();
+			vImageCopy.imageSubresource.baseArrayLayer = 0;
+			vImageCopy.imageSubresource.layerCount = m_Layers;
+			vImageCopy.imageSubresource.mipLevel = mipLevel;
+			vImageCopy.bufferOffset = bufferOffset + mipLevelOffsets[mipLevel];
+			vImageCopy.bufferRowLength = 0;
+			vImageCopy.bufferImageHeight = 0;
+		}
+
+		const auto levelCount = static_cast<uint32_t>(vImageCopies.size());
+		const auto oldlayout = getImageLayout();
+
+		// Change the layout to transfer destination
+		changeMipLevelLayout(VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, levelCount, vCommandBuffer);
+
+		// Copy all the levels at once.
+		getEngine()->getDeviceTable().vkCmdCopyBufferToImage(vCommandBuffer, vBuffer, m_vImage, VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, levelCount, vImageCopies.data());
+
+		// Get it back to the old layout.
+		auto finalLayout = VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		if (oldlayout != VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED && oldlayout != VkImageLayout::VK_IMAGE_LAYOUT_PREINITIALIZED)
+			finalLayout = oldlayout;
+
+		// If only the base level was given, the rest of the mip levels are generated from it.
+		if (levelCount == 1 && m_MipLevels > 1)
+			generateMipMaps(finalLayout, vCommandBuffer);
+
+		else if (finalLayout != VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL || levelCount < m_MipLevels)
+			changeImageLayout(finalLayout, vCommandBuffer);
+	}
+
+	VkImageMemoryBarrier2 Image::createLayoutBarrier(const SubresourceState& oldState, const VkImageLayout newLayout, const uint32_t baseMipLevel, const uint32_t levelCount) const
+	{
+		const auto oldLayout = oldState.vLayout;
+
+		// Create the memory barrier.
+		VkImageMemoryBarrier2 vMemoryBarrier = {};
+		vMemoryBarrier.sType = VkStructureType::VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+		vMemoryBarrier.oldLayout = oldLayout;
+		vMemoryBarrier.newLayout = newLayout;
+		vMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		vMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		vMemoryBarrier.image = m_vImage;
+
+		if (oldLayout == VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL ||
+			oldLayout == VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL ||
+			oldLayout == VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL ||
+			newLayout == VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL ||
+			newLayout == VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL ||
+			newLayout == VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
+		{
+			vMemoryBarrier.subresourceRange.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_DEPTH_BIT;
+
+			if (hasStencilComponent())
+				vMemoryBarrier.subresourceRange.aspectMask |= VkImageAspectFlagBits::VK_IMAGE_ASPECT_STENCIL_BIT;
+		}
+		else
+			vMemoryBarrier.subresourceRange.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT;
+
+		vMemoryBarrier.subresourceRange.baseMipLevel = baseMipLevel;
+		vMemoryBarrier.subresourceRange.levelCount = levelCount;
+		vMemoryBarrier.subresourceRange.layerCount = m_Layers;
+		vMemoryBarrier.subresourceRange.baseArrayLayer = 0;
+
+		// The source scope is whatever the last transition made the subresources available to.
+		vMemoryBarrier.srcAccessMask = oldState.vAccessMask;
+		vMemoryBarrier.srcStageMask = oldState.vStageMask;
+		vMemoryBarrier.dstAccessMask = VK_ACCESS_2_NONE;
+
+		// Resolve the destination access masks.
+		switch (newLayout)
+		{
+		case VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED:
+		case VkImageLayout::VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+			break;
+
+		case VkImageLayout::VK_IMAGE_LAYOUT_GENERAL:
+			vMemoryBarrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+			break;
+
+		case VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+			vMemoryBarrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			break;
+
+		case VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+			vMemoryBarrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+			break;
+
+		case VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+			vMemoryBarrier.dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+			break;
+
+		case VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+			vMemoryBarrier.dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			break;
+
+		case VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+			vMemoryBarrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+			break;
+
+		case VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+			vMemoryBarrier.dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+			break;
+
+		default:
+			throw BackendError("Unsupported layout transition!");
+		}
+
+		vMemoryBarrier.dstStageMask = GetPipelineStageFlags(vMemoryBarrier.dstAccessMask, getEngine()->getFeatures());
+		return vMemoryBarrier;
+	}
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Firefly/Shader.hpp"
+#include "Firefly/ShaderReflectionCache.hpp"
 
 #include <fstream>
 
@@ -18,22 +19,20 @@ namespace /* anonymous */
 			throw Firefly::BackendError("Could not open the file specified!");
 
 		// Get the file size.
-		const auto size = shaderFile.tellg();
+		const auto size = static_cast<uint64_t>(shaderFile.tellg());
 		shaderFile.seekg(0);
 
+		if (size % sizeof(uint32_t) != 0)
+			throw Firefly::BackendError("The shader file size is not a multiple of 4!");
+
 		// Load its content.
-		Firefly::Shader::ShaderCode shaderCode(size);
+		Firefly::Shader::ShaderCode shaderCode(size / sizeof(uint32_t));
 		shaderFile.read(reinterpret_cast<char*>(shaderCode.data()), size);
 		shaderFile.close();
 
 		return shaderCode;
 	}
 
-	Firefly::Shader::ShaderCode ResolvePadding(const Firefly::Shader::ShaderCode& code)
-	{
-		return Firefly::Shader::ShaderCode(code.begin(), code.begin() + (code.size() / 4));
-	}
-
 	void ValidateReflection(const SpvReflectResult result)
 	{
 		switch (result)
@@ -83,24 +82,69 @@ namespace /* anonymous */
 		}
 	}
 
-	struct ReflectionResult
+	std::unordered_map<uint32_t, uint32_t> ReflectSpecializationConstants(const Firefly::ShaderCodeView& code)
 	{
-		Firefly::Shader::LayoutBindings m_LayoutBindings;
-		std::unordered_map<std::string, Firefly::ShaderBinding> m_Bindings;
-		std::vector<Firefly::ShaderAttribute> m_InputAttributes;
-		std::vector<Firefly::ShaderAttribute> m_OutputAttributes;
-		std::vector<VkPushConstantRange> m_PushConstants;
+		// SPIRV-Reflect does not report specialization constants, so we walk the instructions ourselves.
+		std::unordered_map<uint32_t, uint32_t> specIDs;			// Result ID -> SpecId.
+		std::unordered_map<uint32_t, uint32_t> typeSizes;		// Type ID -> size in bytes.
+		std::unordered_map<uint32_t, uint32_t> constantTypes;	// Result ID -> type ID.
 
-	};
+		// Skip the header (magic, version, generator, bound and schema).
+		for (uint64_t i = 5; i < code.m_WordCount;)
+		{
+			const auto opCode = code.m_pCode[i] & 0xFFFF;
+			const auto wordCount = code.m_pCode[i] >> 16;
+
+			if (wordCount == 0 || i + wordCount > code.m_WordCount)
+				break;
 
-	ReflectionResult PerformReflection(const Firefly::Shader::ShaderCode& code, const VkShaderStageFlags flags)
+			switch (opCode)
+			{
+			case SpvOpDecorate:
+				if (wordCount >= 4 && code.m_pCode[i + 2] == SpvDecorationSpecId)
+					specIDs[code.m_pCode[i + 1]] = code.m_pCode[i + 3];
+				break;
+
+			case SpvOpTypeBool:
+				typeSizes[code.m_pCode[i + 1]] = sizeof(VkBool32);
+				break;
+
+			case SpvOpTypeInt:
+			case SpvOpTypeFloat:
+				typeSizes[code.m_pCode[i + 1]] = code.m_pCode[i + 2] / 8;
+				break;
+
+			case SpvOpSpecConstantTrue:
+			case SpvOpSpecConstantFalse:
+			case SpvOpSpecConstant:
+				constantTypes[code.m_pCode[i + 2]] = code.m_pCode[i + 1];
+				break;
+
+			default:
+				break;
+			}
+
+			i += wordCount;
+		}
+
+		std::unordered_map<uint32_t, uint32_t> constants;
+		for (const auto& [resultID, specID] : specIDs)
+		{
+			const auto type = constantTypes.find(resultID);
+			if (type != constantTypes.end() && typeSizes.find(type->second) != typeSizes.end())
+				constants[specID] = typeSizes[type->second];
+		}
+
+		return constants;
+	}
+
+	Firefly::ShaderReflection PerformReflection(const Firefly::ShaderCodeView& code)
 	{
 		SpvReflectShaderModule shaderModule = {};
 		uint32_t variableCount = 0;
-		ReflectionResult result;
+		Firefly::ShaderReflection result;
 
-		const Firefly::Shader::ShaderCode shaderCode = ResolvePadding(code);
-		ValidateReflection(spvReflectCreateShaderModule(shaderCode.size() * sizeof(uint32_t), shaderCode.data(), &shaderModule));
+		ValidateReflection(spvReflectCreateShaderModule(code.m_WordCount * sizeof(uint32_t), code.m_pCode, &shaderModule));
 
 		// Resolve shader inputs.
 		{
@@ -179,27 +223,18 @@ namespace /* anonymous */
 			std::vector<SpvReflectDescriptorBinding*> pBindings(variableCount);
 			ValidateReflection(spvReflectEnumerateDescriptorBindings(&shaderModule, &variableCount, pBindings.data()));
 
-			result.m_LayoutBindings.reserve(variableCount);
-
-			VkDescriptorSetLayoutBinding vBinding = {};
-			vBinding.stageFlags = flags;
-			vBinding.pImmutableSamplers = VK_NULL_HANDLE;
+			result.m_Bindings.reserve(variableCount);
 
 			// Iterate over the resources and setup the bindings.
 			for (auto& resource : pBindings)
 			{
-				vBinding.descriptorType = GetVkDescriptorType(resource->descriptor_type);
-				vBinding.descriptorCount = resource->count;
-				vBinding.binding = resource->binding;
-
 				Firefly::ShaderBinding binding;
 				binding.m_Binding = resource->binding;
 				binding.m_Set = resource->set;
 				binding.m_Count = resource->count;
-				binding.m_Type = vBinding.descriptorType;
+				binding.m_Type = GetVkDescriptorType(resource->descriptor_type);
 
-				result.m_Bindings[resource->name] = binding;
-				result.m_LayoutBindings.emplace_back(vBinding);
+				result.m_Bindings.emplace_back(resource->name, binding);
 			}
 		}
 
@@ -211,7 +246,7 @@ namespace /* anonymous */
 			ValidateReflection(spvReflectEnumeratePushConstantBlocks(&shaderModule, &variableCount, pPushConstants.data()));
 
 			VkPushConstantRange vPushConstantRange = {};
-			vPushConstantRange.stageFlags = flags;
+			vPushConstantRange.stageFlags = 0;
 			vPushConstantRange.offset = 0;
 
 			// Iterate over the push constants and setup.
@@ -223,6 +258,9 @@ namespace /* anonymous */
 			}
 		}
 
+		// Resolve specialization constants.
+		result.m_SpecializationConstants = ReflectSpecializationConstants(code);
+
 		return result;
 	}
 }
@@ -255,6 +293,16 @@ namespace Firefly
 		const auto pointer = std::make_shared<Shader>(pEngine, flags);
 		FIREFLY_VALIDATE_OBJECT(pointer);
 
+		pointer->initialize(ShaderCodeView{ shaderCode.data(), shaderCode.size() });
+
+		return pointer;
+	}
+
+	std::shared_ptr<Shader> Shader::create(const std::shared_ptr<Engine>& pEngine, const ShaderCodeView& shaderCode, const VkShaderStageFlags flags)
+	{
+		const auto pointer = std::make_shared<Shader>(pEngine, flags);
+		FIREFLY_VALIDATE_OBJECT(pointer);
+
 		pointer->initialize(shaderCode);
 
 		return pointer;
@@ -262,39 +310,66 @@ namespace Firefly
 	
 	void Shader::terminate()
 	{
-		getEngine()->getDeviceTable().vkDestroyDescriptorSetLayout(getEngine()->getLogicalDevice(), m_vDescriptorSetLayout, nullptr);
 		getEngine()->getDeviceTable().vkDestroyShaderModule(getEngine()->getLogicalDevice(), m_vShaderModule, nullptr);
 		toggleTerminated();
 	}
 
-	void Shader::createShaderModule(const ShaderCode& code)
+	void Shader::createShaderModule(const ShaderCodeView& code)
 	{
 		VkShaderModuleCreateInfo vShaderModuleCreateInfo = {};
 		vShaderModuleCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 		vShaderModuleCreateInfo.pNext = VK_NULL_HANDLE;
 		vShaderModuleCreateInfo.flags = 0;
-		vShaderModuleCreateInfo.codeSize = code.size();
-		vShaderModuleCreateInfo.pCode = code.data();
+		vShaderModuleCreateInfo.codeSize = code.m_WordCount * sizeof(uint32_t);
+		vShaderModuleCreateInfo.pCode = code.m_pCode;
 
 		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkCreateShaderModule(getEngine()->getLogicalDevice(), &vShaderModuleCreateInfo, nullptr, &m_vShaderModule), "Failed to create the shader module!");
 	}
 
-	void Shader::createDescriptorSetLayout(const ShaderCode& code)
+	void Shader::createDescriptorSetLayout(const ShaderCodeView& code)
 	{
-		auto result = PerformReflection(code, m_Flags);
+		// Reflect the shader, unless the same code was reflected before.
+		auto& reflectionCache = getEngine()->getShaderReflectionCache();
+
+		ShaderReflection result;
+		if (!reflectionCache.find(code, result))
+		{
+			result = PerformReflection(code);
+			reflectionCache.store(code, result);
+		}
+
+		// Resolve the bindings using the shader stage.
+		LayoutBindings vLayoutBindings;
+		vLayoutBindings.reserve(result.m_Bindings.size());
+
+		for (auto& [name, binding] : result.m_Bindings)
+		{
+			m_Bindings[name] = binding;
+
+			// Runtime sized arrays are not part of the shader's own set, they are provided by a bindless table.
+			if (binding.m_Count == 0)
+				continue;
+
+			VkDescriptorSetLayoutBinding vBinding = {};
+			vBinding.binding = binding.m_Binding;
+			vBinding.descriptorType = binding.m_Type;
+			vBinding.descriptorCount = binding.m_Count;
+			vBinding.stageFlags = m_Flags;
+			vBinding.pImmutableSamplers = VK_NULL_HANDLE;
+
+			vLayoutBindings.emplace_back(vBinding);
+		}
+
+		for (auto& vPushConstantRange : result.m_PushConstants)
+			vPushConstantRange.stageFlags = m_Flags;
+
 		m_InputAttributes = std::move(result.m_InputAttributes);
 		m_OutputAttributes = std::move(result.m_OutputAttributes);
-		m_Bindings = std::move(result.m_Bindings);
 		m_PushConstants = std::move(result.m_PushConstants);
+		m_SpecializationConstants = std::move(result.m_SpecializationConstants);
 
-		VkDescriptorSetLayoutCreateInfo vDescriptorSetLayoutCreateInfo = {};
-		vDescriptorSetLayoutCreateInfo.sType = VkStructureType::VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		vDescriptorSetLayoutCreateInfo.pNext = nullptr;
-		vDescriptorSetLayoutCreateInfo.flags = 0;
-		vDescriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(result.m_LayoutBindings.size());
-		vDescriptorSetLayoutCreateInfo.pBindings = result.m_LayoutBindings.data();
-
-		FIREFLY_VALIDATE(getEngine()->getDeviceTable().vkCreateDescriptorSetLayout(getEngine()->getLogicalDevice(), &vDescriptorSetLayoutCreateInfo, nullptr, &m_vDescriptorSetLayout), "Failed to create descriptor set layout!");
+		// Identical bindings share the same layout, which keeps the descriptor sets compatible across pipelines.
+		m_vDescriptorSetLayout = getEngine()->getDescriptorSetLayout(vLayoutBindings);
 	}
 
 	void Shader::initialize(const std::filesystem::path& file)
@@ -302,14 +377,10 @@ namespace Firefly
 		// Load the shader data.
 		const auto shaderCode = LoadCode(file);
 
-		// Create the shader module.
-		createShaderModule(shaderCode);
-
-		// Create the descriptor set layout.
-		createDescriptorSetLayout(shaderCode);
+		initialize(ShaderCodeView{ shaderCode.data(), shaderCode.size() });
 	}
 
-	void Shader::initialize(const ShaderCode& shaderCode)
+	void Shader::initialize(const ShaderCodeView& shaderCode)
 	{
 		// Create the shader module.
 		createShaderModule(shaderCode);
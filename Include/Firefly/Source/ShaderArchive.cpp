@@ -0,0 +1,319 @@
+#include "Firefly/ShaderArchive.hpp"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	include <Windows.h>
+
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+
+#endif
+
+namespace /* anonymous */
+{
+	constexpr uint32_t ArchiveMagic = 0x41534646;	// "FFSA"
+	constexpr uint32_t SwappedArchiveMagic = 0x46465341;	// "FFSA" written by a host of the other byte order.
+	constexpr uint32_t ArchiveVersion = 1;
+
+	struct ArchiveHeader
+	{
+		uint32_t m_Magic = ArchiveMagic;
+		uint32_t m_Version = ArchiveVersion;
+		uint32_t m_EntryCount = 0;
+		uint32_t m_StringTableSize = 0;
+	};
+
+	struct ArchiveEntry
+	{
+		uint32_t m_NameOffset = 0;
+		uint32_t m_NameLength = 0;
+		uint32_t m_Flags = 0;
+		uint32_t m_Reserved = 0;
+		uint64_t m_CodeOffset = 0;
+		uint64_t m_CodeSize = 0;
+	};
+
+	/**
+	 * Align a size to 4 bytes.
+	 *
+	 * @param size The size to align.
+	 * @return The aligned size.
+	 */
+	constexpr uint64_t AlignToWord(const uint64_t size) { return (size + 3) & ~static_cast<uint64_t>(3); }
+}
+
+namespace Firefly
+{
+	ShaderArchive::ShaderArchive(const std::filesystem::path& file)
+	{
+		map(file);
+
+		try
+		{
+			parse();
+		}
+		catch (...)
+		{
+			unmap();
+			throw;
+		}
+	}
+
+	ShaderArchive::~ShaderArchive()
+	{
+		unmap();
+	}
+
+	ShaderCodeView ShaderArchive::getCode(const std::string& name) const
+	{
+		const auto itr = m_Entries.find(name);
+		if (itr == m_Entries.end())
+			throw BackendError("The shader is not present in the archive!");
+
+		return itr->second.m_Code;
+	}
+
+	VkShaderStageFlags ShaderArchive::getFlags(const std::string& name) const
+	{
+		const auto itr = m_Entries.find(name);
+		if (itr == m_Entries.end())
+			throw BackendError("The shader is not present in the archive!");
+
+		return itr->second.m_Flags;
+	}
+
+	std::vector<std::string> ShaderArchive::getNames() const
+	{
+		std::vector<std::string> names;
+		names.reserve(m_Entries.size());
+
+		for (const auto& [name, entry] : m_Entries)
+			names.emplace_back(name);
+
+		return names;
+	}
+
+	void ShaderArchive::map(const std::filesystem::path& file)
+	{
+#ifdef _WIN32
+		const auto hFile = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE)
+			throw BackendError("Could not open the shader archive!");
+
+		LARGE_INTEGER fileSize = {};
+		GetFileSizeEx(hFile, &fileSize);
+
+		const auto hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!hMapping)
+		{
+			CloseHandle(hFile);
+			throw BackendError("Could not map the shader archive!");
+		}
+
+		m_pData = static_cast<const uint8_t*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+		if (!m_pData)
+		{
+			CloseHandle(hMapping);
+			CloseHandle(hFile);
+			throw BackendError("Could not map the shader archive!");
+		}
+
+		m_Size = static_cast<uint64_t>(fileSize.QuadPart);
+		m_FileHandle = hFile;
+		m_MappingHandle = hMapping;
+
+#else
+		const auto fileDescriptor = open(file.c_str(), O_RDONLY);
+		if (fileDescriptor == -1)
+			throw BackendError("Could not open the shader archive!");
+
+		struct stat fileStat = {};
+		if (fstat(fileDescriptor, &fileStat) == -1 || fileStat.st_size == 0)
+		{
+			close(fileDescriptor);
+			throw BackendError("The shader archive is empty or could not be read!");
+		}
+
+		// The mapping stays valid after the descriptor is closed.
+		const auto pData = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		close(fileDescriptor);
+
+		if (pData == MAP_FAILED)
+			throw BackendError("Could not map the shader archive!");
+
+		m_pData = static_cast<const uint8_t*>(pData);
+		m_Size = static_cast<uint64_t>(fileStat.st_size);
+
+#endif
+	}
+
+	void ShaderArchive::unmap()
+	{
+		if (!m_pData)
+			return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(m_pData);
+		CloseHandle(static_cast<HANDLE>(m_MappingHandle));
+		CloseHandle(static_cast<HANDLE>(m_FileHandle));
+
+		m_MappingHandle = nullptr;
+		m_FileHandle = nullptr;
+
+#else
+		munmap(const_cast<uint8_t*>(m_pData), static_cast<size_t>(m_Size));
+
+#endif
+
+		m_Entries.clear();
+		m_pData = nullptr;
+		m_Size = 0;
+	}
+
+	void ShaderArchive::parse()
+	{
+		// Validate the header.
+		if (m_Size < sizeof(ArchiveHeader))
+			throw BackendError("The shader archive is too small!");
+
+		ArchiveHeader header;
+		std::memcpy(&header, m_pData, sizeof(ArchiveHeader));
+
+		if (header.m_Magic == SwappedArchiveMagic)
+			throw BackendError("The shader archive was written on a host with a different byte order!");
+
+		if (header.m_Magic != ArchiveMagic)
+			throw BackendError("The file is not a shader archive!");
+
+		if (header.m_Version != ArchiveVersion)
+			throw BackendError("Unsupported shader archive version!");
+
+		const auto entriesOffset = sizeof(ArchiveHeader);
+		const auto stringTableOffset = entriesOffset + static_cast<uint64_t>(header.m_EntryCount) * sizeof(ArchiveEntry);
+		if (stringTableOffset + header.m_StringTableSize > m_Size)
+			throw BackendError("The shader archive table of contents is truncated!");
+
+		// Build the lookup table. The names point straight into the mapping.
+		const auto pStringTable = reinterpret_cast<const char*>(m_pData + stringTableOffset);
+		m_Entries.reserve(header.m_EntryCount);
+
+		for (uint32_t i = 0; i < header.m_EntryCount; i++)
+		{
+			ArchiveEntry entry;
+			std::memcpy(&entry, m_pData + entriesOffset + i * sizeof(ArchiveEntry), sizeof(ArchiveEntry));
+
+			if (static_cast<uint64_t>(entry.m_NameOffset) + entry.m_NameLength > header.m_StringTableSize)
+				throw BackendError("Invalid shader archive entry name!");
+
+			if (entry.m_CodeOffset % sizeof(uint32_t) != 0 || entry.m_CodeSize % sizeof(uint32_t) != 0 || entry.m_CodeOffset > m_Size ||
+				entry.m_CodeSize > m_Size - entry.m_CodeOffset)
+				throw BackendError("Invalid shader archive entry code!");
+
+			Entry value;
+			value.m_Code.m_pCode = reinterpret_cast<const uint32_t*>(m_pData + entry.m_CodeOffset);
+			value.m_Code.m_WordCount = entry.m_CodeSize / sizeof(uint32_t);
+			value.m_Flags = entry.m_Flags;
+
+			m_Entries[std::string_view(pStringTable + entry.m_NameOffset, entry.m_NameLength)] = value;
+		}
+	}
+
+	void ShaderArchiveWriter::add(const std::string& name, const ShaderCodeView& code, const VkShaderStageFlags flags)
+	{
+		auto& entry = m_Entries[name];
+		entry.m_Code.assign(code.m_pCode, code.m_pCode + code.m_WordCount);
+		entry.m_Flags = flags;
+	}
+
+	void ShaderArchiveWriter::add(const std::string& name, const std::filesystem::path& file, const VkShaderStageFlags flags)
+	{
+		std::fstream shaderFile(file, std::ios::in | std::ios::binary | std::ios::ate);
+
+		if (!shaderFile.is_open())
+			throw BackendError("Could not open the file specified!");
+
+		const auto size = static_cast<uint64_t>(shaderFile.tellg());
+		shaderFile.seekg(0);
+
+		if (size % sizeof(uint32_t) != 0)
+			throw BackendError("The shader file size is not a multiple of 4!");
+
+		auto& entry = m_Entries[name];
+		entry.m_Code.resize(size / sizeof(uint32_t));
+		entry.m_Flags = flags;
+
+		shaderFile.read(reinterpret_cast<char*>(entry.m_Code.data()), size);
+	}
+
+	void ShaderArchiveWriter::merge(const ShaderArchive& archive)
+	{
+		for (const auto& name : archive.getNames())
+			add(name, archive.getCode(name), archive.getFlags(name));
+	}
+
+	void ShaderArchiveWriter::write(const std::filesystem::path& file) const
+	{
+		// Build the table of contents.
+		ArchiveHeader header;
+		header.m_EntryCount = static_cast<uint32_t>(m_Entries.size());
+
+		std::vector<ArchiveEntry> entries;
+		entries.reserve(m_Entries.size());
+
+		std::string stringTable;
+		for (const auto& [name, entry] : m_Entries)
+		{
+			ArchiveEntry archiveEntry;
+			archiveEntry.m_NameOffset = static_cast<uint32_t>(stringTable.size());
+			archiveEntry.m_NameLength = static_cast<uint32_t>(name.size());
+			archiveEntry.m_Flags = entry.m_Flags;
+			archiveEntry.m_CodeSize = entry.m_Code.size() * sizeof(uint32_t);
+
+			stringTable.append(name);
+			entries.emplace_back(archiveEntry);
+		}
+
+		header.m_StringTableSize = static_cast<uint32_t>(stringTable.size());
+
+		// Compute the code offsets. The code starts at the first 4 byte boundary after the string table.
+		auto offset = AlignToWord(sizeof(ArchiveHeader) + entries.size() * sizeof(ArchiveEntry) + stringTable.size());
+		for (auto& entry : entries)
+		{
+			entry.m_CodeOffset = offset;
+			offset += entry.m_CodeSize;
+		}
+
+		// Write everything to a temporary file and replace the destination with it.
+		auto temporaryFile = file;
+		temporaryFile += ".tmp";
+
+		{
+			std::fstream archiveFile(temporaryFile, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!archiveFile.is_open())
+				throw BackendError("Could not create the shader archive!");
+
+			constexpr std::array<char, 4> padding = {};
+			const auto tableOfContentsSize = sizeof(ArchiveHeader) + entries.size() * sizeof(ArchiveEntry) + stringTable.size();
+
+			archiveFile.write(reinterpret_cast<const char*>(&header), sizeof(ArchiveHeader));
+			archiveFile.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(ArchiveEntry));
+			archiveFile.write(stringTable.data(), stringTable.size());
+			archiveFile.write(padding.data(), AlignToWord(tableOfContentsSize) - tableOfContentsSize);
+
+			for (const auto& [name, entry] : m_Entries)
+				archiveFile.write(reinterpret_cast<const char*>(entry.m_Code.data()), entry.m_Code.size() * sizeof(uint32_t));
+
+			if (!archiveFile.good())
+				throw BackendError("Failed to write the shader archive!");
+		}
+
+		std::filesystem::rename(temporaryFile, file);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,327 @@
+#include "Firefly/ShaderReflectionCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace /* anonymous */
+{
+	constexpr uint32_t CacheMagic = 0x43524646;	// "FFRC"
+	constexpr uint32_t CacheVersion = 2;
+
+	/**
+	 * Binary writer structure.
+	 * This appends trivially copyable values and strings to a byte buffer.
+	 */
+	struct BinaryWriter
+	{
+		template<class Type>
+		void write(const Type& value)
+		{
+			const auto pBegin = reinterpret_cast<const uint8_t*>(&value);
+			m_Data.insert(m_Data.end(), pBegin, pBegin + sizeof(Type));
+		}
+
+		void write(const std::string& string)
+		{
+			write(static_cast<uint32_t>(string.size()));
+			m_Data.insert(m_Data.end(), string.begin(), string.end());
+		}
+
+		void write(const std::vector<uint32_t>& words)
+		{
+			write(static_cast<uint64_t>(words.size()));
+			const auto pBegin = reinterpret_cast<const uint8_t*>(words.data());
+			m_Data.insert(m_Data.end(), pBegin, pBegin + words.size() * sizeof(uint32_t));
+		}
+
+		std::vector<uint8_t> m_Data;
+	};
+
+	/**
+	 * Binary reader structure.
+	 * This reads the values written by the binary writer. Reads past the end fail instead of overrunning the buffer.
+	 */
+	struct BinaryReader
+	{
+		template<class Type>
+		bool read(Type& value)
+		{
+			if (m_Offset + sizeof(Type) > m_Size)
+				return false;
+
+			std::memcpy(&value, m_pData + m_Offset, sizeof(Type));
+			m_Offset += sizeof(Type);
+			return true;
+		}
+
+		bool read(std::string& string)
+		{
+			uint32_t length = 0;
+			if (!read(length) || m_Offset + length > m_Size)
+				return false;
+
+			string.assign(reinterpret_cast<const char*>(m_pData + m_Offset), length);
+			m_Offset += length;
+			return true;
+		}
+
+		bool read(std::vector<uint32_t>& words)
+		{
+			uint64_t count = 0;
+			if (!read(count) || count > (m_Size - m_Offset) / sizeof(uint32_t))
+				return false;
+
+			words.resize(count);
+			if (count > 0)
+				std::memcpy(words.data(), m_pData + m_Offset, count * sizeof(uint32_t));
+
+			m_Offset += count * sizeof(uint32_t);
+			return true;
+		}
+
+		/**
+		 * Read an element count.
+		 * The count is rejected if the remaining bytes cannot hold that many elements, so a corrupted count cannot trigger a huge allocation.
+		 *
+		 * @param count The count to read to.
+		 * @param minimumElementSize The minimum size of a single serialized element in bytes.
+		 * @return Whether the count could be read.
+		 */
+		bool readCount(uint32_t& count, const uint64_t minimumElementSize)
+		{
+			return read(count) && static_cast<uint64_t>(count) * minimumElementSize <= m_Size - m_Offset;
+		}
+
+		const uint8_t* m_pData = nullptr;
+		uint64_t m_Size = 0;
+		uint64_t m_Offset = 0;
+	};
+
+	void WriteAttributes(BinaryWriter& writer, const std::vector<Firefly::ShaderAttribute>& attributes)
+	{
+		writer.write(static_cast<uint32_t>(attributes.size()));
+		for (const auto& attribute : attributes)
+		{
+			writer.write(attribute.m_Name);
+			writer.write(attribute.m_Location);
+			writer.write(attribute.m_Size);
+		}
+	}
+
+	bool ReadAttributes(BinaryReader& reader, std::vector<Firefly::ShaderAttribute>& attributes)
+	{
+		// Name length, location and size.
+		uint32_t count = 0;
+		if (!reader.readCount(count, sizeof(uint32_t) * 3))
+			return false;
+
+		attributes.resize(count);
+		for (auto& attribute : attributes)
+		{
+			if (!reader.read(attribute.m_Name) || !reader.read(attribute.m_Location) || !reader.read(attribute.m_Size))
+				return false;
+		}
+
+		return true;
+	}
+
+	void WriteReflection(BinaryWriter& writer, const Firefly::ShaderReflection& reflection)
+	{
+		writer.write(static_cast<uint32_t>(reflection.m_Bindings.size()));
+		for (const auto& [name, binding] : reflection.m_Bindings)
+		{
+			writer.write(name);
+			writer.write(binding.m_Set);
+			writer.write(binding.m_Binding);
+			writer.write(binding.m_Count);
+			writer.write(binding.m_Type);
+		}
+
+		WriteAttributes(writer, reflection.m_InputAttributes);
+		WriteAttributes(writer, reflection.m_OutputAttributes);
+
+		writer.write(static_cast<uint32_t>(reflection.m_PushConstants.size()));
+		for (const auto& vRange : reflection.m_PushConstants)
+		{
+			writer.write(vRange.offset);
+			writer.write(vRange.size);
+		}
+
+		writer.write(static_cast<uint32_t>(reflection.m_SpecializationConstants.size()));
+		for (const auto& [constantID, size] : reflection.m_SpecializationConstants)
+		{
+			writer.write(constantID);
+			writer.write(size);
+		}
+	}
+
+	bool ReadReflection(BinaryReader& reader, Firefly::ShaderReflection& reflection)
+	{
+		// Name length, set, binding, count and type.
+		uint32_t count = 0;
+		if (!reader.readCount(count, sizeof(uint32_t) * 4 + sizeof(VkDescriptorType)))
+			return false;
+
+		reflection.m_Bindings.resize(count);
+		for (auto& [name, binding] : reflection.m_Bindings)
+		{
+			if (!reader.read(name) || !reader.read(binding.m_Set) || !reader.read(binding.m_Binding) || !reader.read(binding.m_Count) || !reader.read(binding.m_Type))
+				return false;
+		}
+
+		if (!ReadAttributes(reader, reflection.m_InputAttributes) || !ReadAttributes(reader, reflection.m_OutputAttributes))
+			return false;
+
+		// Offset and size.
+		if (!reader.readCount(count, sizeof(uint32_t) * 2))
+			return false;
+
+		reflection.m_PushConstants.resize(count);
+		for (auto& vRange : reflection.m_PushConstants)
+		{
+			vRange.stageFlags = 0;
+			if (!reader.read(vRange.offset) || !reader.read(vRange.size))
+				return false;
+		}
+
+		// Constant ID and size.
+		if (!reader.readCount(count, sizeof(uint32_t) * 2))
+			return false;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t constantID = 0;
+			uint32_t size = 0;
+			if (!reader.read(constantID) || !reader.read(size))
+				return false;
+
+			reflection.m_SpecializationConstants[constantID] = size;
+		}
+
+		return true;
+	}
+}
+
+namespace Firefly
+{
+	uint64_t ShaderReflectionCache::Hash(const ShaderCodeView& code)
+	{
+		const auto pBytes = reinterpret_cast<const uint8_t*>(code.m_pCode);
+		const auto size = code.m_WordCount * sizeof(uint32_t);
+
+		uint64_t hash = 14695981039346656037ull;
+		for (uint64_t i = 0; i < size; i++)
+		{
+			hash ^= pBytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	bool ShaderReflectionCache::find(const ShaderCodeView& code, ShaderReflection& reflection) const
+	{
+		const auto hash = Hash(code);
+		const auto lock = std::scoped_lock(m_Mutex);
+
+		// The code is compared as well, so a hash collision is treated as a miss instead of returning another shader's reflection.
+		const auto itr = m_Entries.find(hash);
+		if (itr == m_Entries.end() || itr->second.m_Code.size() != code.m_WordCount || !std::equal(itr->second.m_Code.begin(), itr->second.m_Code.end(), code.m_pCode))
+			return false;
+
+		reflection = itr->second.m_Reflection;
+		return true;
+	}
+
+	void ShaderReflectionCache::store(const ShaderCodeView& code, const ShaderReflection& reflection)
+	{
+		const auto hash = Hash(code);
+		const auto lock = std::scoped_lock(m_Mutex);
+
+		auto& entry = m_Entries[hash];
+		entry.m_Reflection = reflection;
+		entry.m_Code.assign(code.m_pCode, code.m_pCode + code.m_WordCount);
+	}
+
+	std::vector<uint8_t> ShaderReflectionCache::serialize() const
+	{
+		const auto lock = std::scoped_lock(m_Mutex);
+
+		BinaryWriter writer;
+		writer.write(CacheMagic);
+		writer.write(CacheVersion);
+		writer.write(static_cast<uint64_t>(m_Entries.size()));
+
+		for (const auto& [hash, entry] : m_Entries)
+		{
+			writer.write(hash);
+			writer.write(entry.m_Code);
+			WriteReflection(writer, entry.m_Reflection);
+		}
+
+		return writer.m_Data;
+	}
+
+	bool ShaderReflectionCache::deserialize(const uint8_t* pData, const uint64_t size)
+	{
+		BinaryReader reader;
+		reader.m_pData = pData;
+		reader.m_Size = size;
+
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		uint64_t count = 0;
+		if (!reader.read(magic) || !reader.read(version) || !reader.read(count) || magic != CacheMagic || version != CacheVersion)
+			return false;
+
+		const auto lock = std::scoped_lock(m_Mutex);
+		for (uint64_t i = 0; i < count; i++)
+		{
+			uint64_t hash = 0;
+			Entry entry;
+			if (!reader.read(hash) || !reader.read(entry.m_Code) || !ReadReflection(reader, entry.m_Reflection))
+				return false;
+
+			// Entries whose hash does not match their code would never be found.
+			if (hash != Hash({ entry.m_Code.data(), entry.m_Code.size() }))
+				return false;
+
+			m_Entries[hash] = std::move(entry);
+		}
+
+		return true;
+	}
+
+	void ShaderReflectionCache::save(const std::filesystem::path& file) const
+	{
+		const auto data = serialize();
+
+		std::fstream cacheFile(file, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!cacheFile.is_open())
+			throw BackendError("Could not create the shader reflection cache file!");
+
+		cacheFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+	}
+
+	bool ShaderReflectionCache::load(const std::filesystem::path& file)
+	{
+		std::fstream cacheFile(file, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!cacheFile.is_open())
+			return false;
+
+		const auto size = static_cast<uint64_t>(cacheFile.tellg());
+		cacheFile.seekg(0);
+
+		std::vector<uint8_t> data(size);
+		cacheFile.read(reinterpret_cast<char*>(data.data()), size);
+
+		return deserialize(data.data(), data.size());
+	}
+
+	uint64_t ShaderReflectionCache::size() const
+	{
+		const auto lock = std::scoped_lock(m_Mutex);
+		return m_Entries.size();
+	}
+}
\ No newline at end of file
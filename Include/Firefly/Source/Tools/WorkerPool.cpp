@@ -0,0 +1,65 @@
+#include "Firefly/Tools/WorkerPool.hpp"
+
+#include <algorithm>
+
+namespace Firefly
+{
+	WorkerPool::WorkerPool(uint32_t workerCount)
+	{
+		if (workerCount == 0)
+			workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+		m_Workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; i++)
+			m_Workers.emplace_back([this] { worker(); });
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		{
+			const auto lock = std::scoped_lock(m_Mutex);
+			m_bShouldStop = true;
+		}
+
+		m_Condition.notify_all();
+
+		for (auto& worker : m_Workers)
+			worker.join();
+	}
+
+	std::future<void> WorkerPool::submit(std::function<void()>&& function)
+	{
+		auto task = std::packaged_task<void()>(std::move(function));
+		auto future = task.get_future();
+
+		{
+			const auto lock = std::scoped_lock(m_Mutex);
+			m_Tasks.emplace(std::move(task));
+		}
+
+		m_Condition.notify_one();
+		return future;
+	}
+
+	void WorkerPool::worker()
+	{
+		while (true)
+		{
+			std::packaged_task<void()> task;
+
+			{
+				auto lock = std::unique_lock(m_Mutex);
+				m_Condition.wait(lock, [this] { return m_bShouldStop || !m_Tasks.empty(); });
+
+				// Finish the remaining tasks before stopping.
+				if (m_Tasks.empty())
+					return;
+
+				task = std::move(m_Tasks.front());
+				m_Tasks.pop();
+			}
+
+			task();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Firefly
+{
+	/**
+	 * Worker pool class.
+	 * This tool runs submitted tasks on a fixed number of worker threads.
+	 *
+	 * The destructor waits for all the submitted tasks to finish before joining the workers.
+	 */
+	class WorkerPool final
+	{
+	public:
+		/**
+		 * Constructor.
+		 *
+		 * @param workerCount The number of worker threads. If this is 0, it's set to the hardware concurrency - 1 (at least 1).
+		 */
+		explicit WorkerPool(uint32_t workerCount = 0);
+
+		/**
+		 * Destructor.
+		 */
+		~WorkerPool();
+
+		/**
+		 * Submit a task to the pool.
+		 *
+		 * @param function The function to execute.
+		 * @return The future which is set once the task finishes. Exceptions thrown by the task are stored in it.
+		 */
+		std::future<void> submit(std::function<void()>&& function);
+
+		/**
+		 * Get the number of worker threads.
+		 *
+		 * @return The worker count.
+		 */
+		uint64_t getWorkerCount() const { return m_Workers.size(); }
+
+	private:
+		/**
+		 * Worker thread function.
+		 */
+		void worker();
+
+	private:
+		std::vector<std::thread> m_Workers;
+		std::queue<std::packaged_task<void()>> m_Tasks;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+
+		bool m_bShouldStop = false;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,528 @@
+/**
+ * Shader interface generator.
+ * This tool reflects SPIR-V shaders and generates C++ headers with their interfaces, so that binding indices, uniform block layouts and vertex input
+ * layouts are resolved at compile time. Mismatches between the shaders and the C++ code fail the build through static assertions.
+ *
+ * Usage: ShaderInterfaceGenerator <output directory> <shader.spv>...
+ * A shader named "shader.vert.spv" generates "shader_vert.hpp" with its interface in the "ShaderInterface::shader_vert" namespace.
+ */
+
+#include <SPIRV-Reflect/spirv_reflect.h>
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace /* anonymous */
+{
+	/**
+	 * Convert a name to a valid C++ identifier.
+	 *
+	 * @param name The name to convert.
+	 * @param fallback The name to use if the name is empty.
+	 * @return The identifier.
+	 */
+	std::string ToIdentifier(const char* name, const std::string& fallback)
+	{
+		std::string identifier = name ? name : "";
+		if (identifier.empty())
+			identifier = fallback;
+
+		std::replace_if(identifier.begin(), identifier.end(), [](const char character) { return !std::isalnum(static_cast<unsigned char>(character)) && character != '_'; }, '_');
+
+		if (std::isdigit(static_cast<unsigned char>(identifier.front())))
+			identifier.insert(identifier.begin(), '_');
+
+		return identifier;
+	}
+
+	/**
+	 * Get the name of a descriptor type.
+	 *
+	 * @param type The descriptor type.
+	 * @return The Vulkan enum name.
+	 */
+	const char* GetDescriptorTypeName(const SpvReflectDescriptorType type)
+	{
+		switch (type)
+		{
+		case SPV_REFLECT_DESCRIPTOR_TYPE_SAMPLER:							return "VK_DESCRIPTOR_TYPE_SAMPLER";
+		case SPV_REFLECT_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:			return "VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER";
+		case SPV_REFLECT_DESCRIPTOR_TYPE_SAMPLED_IMAGE:						return "VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE";
+		case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_IMAGE:						return "VK_DESCRIPTOR_TYPE_STORAGE_IMAGE";
+		case SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:				return "VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER";
+		case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:				return "VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER";
+		case SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER:					return "VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER";
+		case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER:					return "VK_DESCRIPTOR_TYPE_STORAGE_BUFFER";
+		case SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:			return "VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC";
+		case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:			return "VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC";
+		case SPV_REFLECT_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:					return "VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT";
+		case SPV_REFLECT_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:		return "VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR";
+		default:															return "VK_DESCRIPTOR_TYPE_MAX_ENUM";
+		}
+	}
+
+	/**
+	 * Get the C++ type of a numeric value.
+	 *
+	 * @param typeFlags The reflected type flags.
+	 * @param numeric The numeric traits.
+	 * @param size The size of the C++ type in bytes.
+	 * @return The type name. This is empty if the type can't be represented.
+	 */
+	std::string GetNumericType(const SpvReflectTypeFlags typeFlags, const SpvReflectNumericTraits& numeric, uint32_t& size)
+	{
+		const auto width = numeric.scalar.width;
+		const auto componentCount = std::max(numeric.vector.component_count, uint32_t(1));
+
+		// Matrices are emitted as an array of column vectors, so that the column stride is kept.
+		if (typeFlags & SPV_REFLECT_TYPE_FLAG_MATRIX)
+		{
+			if (width != 32 || numeric.matrix.stride != 16)
+				return "";
+
+			size = numeric.matrix.column_count * 16;
+			if (numeric.matrix.column_count == 4 && numeric.matrix.row_count == 4)
+				return "glm::mat4";
+
+			return "glm::vec4[" + std::to_string(numeric.matrix.column_count) + "]";
+		}
+
+		std::string prefix;
+		std::string scalar;
+		if (typeFlags & SPV_REFLECT_TYPE_FLAG_FLOAT)
+		{
+			prefix = width == 64 ? "glm::dvec" : "glm::vec";
+			scalar = width == 64 ? "double" : "float";
+		}
+		else if (typeFlags & SPV_REFLECT_TYPE_FLAG_INT)
+		{
+			prefix = numeric.scalar.signedness ? "glm::ivec" : "glm::uvec";
+			scalar = numeric.scalar.signedness ? "int32_t" : "uint32_t";
+
+			if (width != 32)
+				return "";
+		}
+		else if (typeFlags & SPV_REFLECT_TYPE_FLAG_BOOL)
+		{
+			// Booleans are 32-bit in the buffer layouts.
+			prefix = "glm::uvec";
+			scalar = "uint32_t";
+		}
+		else
+		{
+			return "";
+		}
+
+		size = (width == 64 ? 8 : 4) * componentCount;
+		return componentCount == 1 ? scalar : prefix + std::to_string(componentCount);
+	}
+
+	/**
+	 * Header writer class.
+	 * This generates the header of a single shader.
+	 */
+	class HeaderWriter final
+	{
+	public:
+		/**
+		 * Constructor.
+		 *
+		 * @param module The reflected shader module.
+		 */
+		explicit HeaderWriter(const SpvReflectShaderModule& module) : m_Module(module) {}
+
+		/**
+		 * Generate the header.
+		 *
+		 * @param source The source file name.
+		 * @param namespaceName The namespace of the interface.
+		 * @return The header contents.
+		 */
+		std::string generate(const std::string& source, const std::string& namespaceName)
+		{
+			m_Stream << "#pragma once\n\n";
+			m_Stream << "// Generated by the ShaderInterfaceGenerator from " << source << ". Do not edit.\n\n";
+			m_Stream << "#include <Firefly/Imports.hpp>\n";
+			m_Stream << "#include <glm/glm.hpp>\n\n";
+			m_Stream << "#include <cstddef>\n";
+			m_Stream << "#include <cstdint>\n\n";
+			m_Stream << "namespace ShaderInterface::" << namespaceName << "\n{\n";
+
+			writeBindings();
+			writeUniformBlocks();
+			writePushConstants();
+			writeVertexInputs();
+
+			m_Stream << "}";
+
+			// Remove the blank lines left before the closing braces.
+			auto contents = m_Stream.str();
+			for (const auto& [pattern, replacement] : { std::pair<std::string, std::string>("\n\n\t}", "\n\t}"), std::pair<std::string, std::string>("\n\n}", "\n}") })
+			{
+				for (auto position = contents.find(pattern); position != std::string::npos; position = contents.find(pattern, position))
+					contents.replace(position, pattern.size(), replacement);
+			}
+
+			return contents;
+		}
+
+	private:
+		/**
+		 * Write the descriptor binding indices.
+		 */
+		void writeBindings()
+		{
+			uint32_t count = 0;
+			spvReflectEnumerateDescriptorBindings(&m_Module, &count, nullptr);
+
+			std::vector<SpvReflectDescriptorBinding*> pBindings(count);
+			spvReflectEnumerateDescriptorBindings(&m_Module, &count, pBindings.data());
+
+			if (pBindings.empty())
+				return;
+
+			m_Stream << "\t// Descriptor bindings. The names match the keys of Shader::getBinding().\n";
+			m_Stream << "\t// ShaderSet is the set declared in the shader. The engine binds the set of a shader at the shader's index within the pipeline\n";
+			m_Stream << "\t// instead, so use Package::getSetIndex() when a set index is needed.\n";
+			m_Stream << "\tnamespace Bindings\n\t{\n";
+
+			for (const auto pBinding : pBindings)
+			{
+				const auto name = ToIdentifier(pBinding->name, "Set" + std::to_string(pBinding->set) + "Binding" + std::to_string(pBinding->binding));
+
+				m_Stream << "\t\tstruct " << name << "\n\t\t{\n";
+				m_Stream << "\t\t\tstatic constexpr uint32_t ShaderSet = " << pBinding->set << ";\n";
+				m_Stream << "\t\t\tstatic constexpr uint32_t Binding = " << pBinding->binding << ";\n";
+				m_Stream << "\t\t\tstatic constexpr uint32_t Count = " << pBinding->count << ";\n";
+				m_Stream << "\t\t\tstatic constexpr VkDescriptorType Type = VkDescriptorType::" << GetDescriptorTypeName(pBinding->descriptor_type) << ";\n";
+				m_Stream << "\t\t};\n\n";
+
+				if (pBinding->descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER || pBinding->descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+					pBinding->descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER || pBinding->descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+					m_pBlocks.emplace_back(&pBinding->block, name);
+			}
+
+			m_Stream << "\t}\n\n";
+		}
+
+		/**
+		 * Write the uniform and storage block structures.
+		 */
+		void writeUniformBlocks()
+		{
+			if (m_pBlocks.empty())
+				return;
+
+			m_Stream << "\t// Buffer block layouts. Padding is explicit, so these can be copied to the buffers as they are.\n";
+			m_Stream << "\tnamespace Blocks\n\t{\n";
+
+			for (const auto& [pBlock, bindingName] : m_pBlocks)
+			{
+				const auto typeName = pBlock->type_description && pBlock->type_description->type_name ? pBlock->type_description->type_name : nullptr;
+				writeStruct(*pBlock, ToIdentifier(typeName, bindingName + "Block"));
+			}
+
+			m_Stream << "\t}\n\n";
+		}
+
+		/**
+		 * Write the push constant block structures.
+		 */
+		void writePushConstants()
+		{
+			uint32_t count = 0;
+			spvReflectEnumeratePushConstantBlocks(&m_Module, &count, nullptr);
+
+			std::vector<SpvReflectBlockVariable*> pBlocks(count);
+			spvReflectEnumeratePushConstantBlocks(&m_Module, &count, pBlocks.data());
+
+			if (pBlocks.empty())
+				return;
+
+			m_Stream << "\t// Push constant block layouts. The offsets are the push constant offsets used by the shader.\n";
+			m_Stream << "\tnamespace PushConstants\n\t{\n";
+
+			for (const auto pBlock : pBlocks)
+			{
+				const auto typeName = pBlock->type_description && pBlock->type_description->type_name ? pBlock->type_description->type_name : nullptr;
+				writeStruct(*pBlock, ToIdentifier(typeName, "PushConstantBlock"));
+			}
+
+			m_Stream << "\t}\n\n";
+		}
+
+		/**
+		 * Write a block structure and the structures of its members.
+		 *
+		 * @param block The block variable.
+		 * @param name The structure name.
+		 */
+		void writeStruct(const SpvReflectBlockVariable& block, const std::string& name)
+		{
+			if (!m_WrittenStructs.insert(name).second)
+				return;
+
+			// Write the member structures first.
+			for (uint32_t i = 0; i < block.member_count; i++)
+			{
+				const auto& member = block.members[i];
+				if (member.type_description && (member.type_description->type_flags & SPV_REFLECT_TYPE_FLAG_STRUCT))
+					writeStruct(member, getStructName(member));
+			}
+
+			std::stringstream assertions;
+			uint32_t offset = 0;
+			uint32_t paddingIndex = 0;
+
+			m_Stream << "\t\tstruct " << name << "\n\t\t{\n";
+
+			for (uint32_t i = 0; i < block.member_count; i++)
+			{
+				const auto& member = block.members[i];
+				const auto memberName = ToIdentifier(member.name, "member" + std::to_string(i));
+
+				const auto memberOffset = member.offset;
+
+				if (memberOffset > offset)
+				{
+					m_Stream << "\t\t\tuint8_t _padding" << paddingIndex++ << "[" << memberOffset - offset << "];\n";
+					offset = memberOffset;
+				}
+
+				offset += writeMember(member, memberName);
+				assertions << "\tstatic_assert(offsetof(" << name << ", " << memberName << ") == " << memberOffset << ", \"" << name << "::" << memberName << " does not match the shader!\");\n";
+			}
+
+			const auto size = std::max(block.padded_size, block.size);
+			if (size > offset)
+				m_Stream << "\t\t\tuint8_t _padding" << paddingIndex++ << "[" << size - offset << "];\n";
+
+			m_Stream << "\t\t};\n\n";
+
+			// The assertions are indented to the namespace level.
+			std::string line;
+			while (std::getline(assertions, line))
+				m_Stream << "\t" << line << "\n";
+
+			m_Stream << "\t\tstatic_assert(sizeof(" << name << ") == " << size << ", \"" << name << " does not match the shader!\");\n\n";
+		}
+
+		/**
+		 * Write a single block member.
+		 *
+		 * @param member The member variable.
+		 * @param name The member name.
+		 * @return The size of the written member.
+		 */
+		uint32_t writeMember(const SpvReflectBlockVariable& member, const std::string& name)
+		{
+			const auto typeFlags = member.type_description ? member.type_description->type_flags : 0;
+
+			std::string type;
+			uint32_t elementSize = 0;
+
+			if (typeFlags & SPV_REFLECT_TYPE_FLAG_STRUCT)
+			{
+				type = getStructName(member);
+				elementSize = member.array.dims_count > 0 ? member.array.stride : member.size;
+			}
+			else
+			{
+				type = GetNumericType(typeFlags, member.numeric, elementSize);
+			}
+
+			// Arrays are only typed if the element type matches the array stride, else they are emitted as raw bytes.
+			uint64_t elementCount = 1;
+			for (uint32_t i = 0; i < member.array.dims_count; i++)
+				elementCount *= member.array.dims[i];
+
+			const auto bIsArray = member.array.dims_count > 0;
+			const auto bIsRuntimeArray = bIsArray && elementCount == 0;
+
+			if (type.empty() || (bIsArray && member.array.stride != elementSize) || bIsRuntimeArray)
+			{
+				if (bIsRuntimeArray)
+				{
+					m_Stream << "\t\t\t// Runtime array with a stride of " << member.array.stride << " bytes follows.\n";
+					return 0;
+				}
+
+				m_Stream << "\t\t\tuint8_t " << name << "[" << member.size << "];\t// Layout can't be represented, stride: " << member.array.stride << ".\n";
+				return member.size;
+			}
+
+			// Matrix types are emitted as arrays of columns.
+			std::string dimensions;
+			const auto bracket = type.find('[');
+			if (bracket != std::string::npos)
+			{
+				dimensions = type.substr(bracket);
+				type = type.substr(0, bracket);
+			}
+
+			m_Stream << "\t\t\t" << type << " " << name;
+			if (bIsArray)
+				m_Stream << "[" << elementCount << "]";
+
+			m_Stream << dimensions << ";\n";
+			return static_cast<uint32_t>(elementSize * elementCount);
+		}
+
+		/**
+		 * Get the structure name of a struct member.
+		 *
+		 * @param member The member variable.
+		 * @return The structure name.
+		 */
+		std::string getStructName(const SpvReflectBlockVariable& member) const
+		{
+			const auto typeName = member.type_description && member.type_description->type_name ? member.type_description->type_name : nullptr;
+			return ToIdentifier(typeName, ToIdentifier(member.name, "Struct") + "Type");
+		}
+
+		/**
+		 * Write the vertex input layout.
+		 */
+		void writeVertexInputs()
+		{
+			if (m_Module.shader_stage != SPV_REFLECT_SHADER_STAGE_VERTEX_BIT)
+				return;
+
+			uint32_t count = 0;
+			spvReflectEnumerateInputVariables(&m_Module, &count, nullptr);
+
+			std::vector<SpvReflectInterfaceVariable*> pInputs(count);
+			spvReflectEnumerateInputVariables(&m_Module, &count, pInputs.data());
+
+			// Skip the built in inputs and sort by location, the same way the graphics pipeline does.
+			pInputs.erase(std::remove_if(pInputs.begin(), pInputs.end(), [](const SpvReflectInterfaceVariable* pInput)
+				{ return pInput->built_in != -1 || pInput->format == SPV_REFLECT_FORMAT_UNDEFINED; }), pInputs.end());
+
+			std::sort(pInputs.begin(), pInputs.end(), [](const SpvReflectInterfaceVariable* pLhs, const SpvReflectInterfaceVariable* pRhs) { return pLhs->location < pRhs->location; });
+
+			if (pInputs.empty())
+				return;
+
+			std::stringstream locations;
+			std::stringstream assertions;
+			uint32_t offset = 0;
+
+			m_Stream << "\t// Vertex input layout. The attributes are tightly packed in the order of their locations.\n";
+			m_Stream << "\tnamespace VertexInput\n\t{\n";
+			m_Stream << "\t\tstruct Vertex\n\t\t{\n";
+
+			for (const auto pInput : pInputs)
+			{
+				const auto name = ToIdentifier(pInput->name, "location" + std::to_string(pInput->location));
+
+				uint32_t size = 0;
+				const auto type = GetNumericType(pInput->type_description ? pInput->type_description->type_flags : 0, pInput->numeric, size);
+
+				if (type.empty() || type.find('[') != std::string::npos)
+				{
+					std::cerr << "Warning: The vertex input " << name << " can't be represented, it's emitted as raw bytes." << std::endl;
+					size = (pInput->numeric.scalar.width / 8) * std::max(pInput->numeric.vector.component_count, uint32_t(1));
+					m_Stream << "\t\t\tuint8_t " << name << "[" << size << "];\n";
+				}
+				else
+				{
+					m_Stream << "\t\t\t" << type << " " << name << ";\n";
+				}
+
+				locations << "\t\tconstexpr uint32_t " << name << "Location = " << pInput->location << ";\n";
+				assertions << "\t\tstatic_assert(offsetof(Vertex, " << name << ") == " << offset << ", \"Vertex::" << name << " does not match the shader!\");\n";
+				offset += size;
+			}
+
+			m_Stream << "\t\t};\n\n";
+			m_Stream << assertions.str();
+			m_Stream << "\t\tstatic_assert(sizeof(Vertex) == " << offset << ", \"Vertex does not match the shader!\");\n\n";
+			m_Stream << locations.str();
+			m_Stream << "\t}\n";
+		}
+
+	private:
+		const SpvReflectShaderModule& m_Module;
+		std::vector<std::pair<const SpvReflectBlockVariable*, std::string>> m_pBlocks;
+		std::set<std::string> m_WrittenStructs;
+		std::stringstream m_Stream;
+	};
+
+	/**
+	 * Generate the header of a single shader.
+	 *
+	 * @param shader The shader file.
+	 * @param outputDirectory The directory to write the header to.
+	 * @return Boolean stating if the header was generated or not.
+	 */
+	bool GenerateHeader(const std::filesystem::path& shader, const std::filesystem::path& outputDirectory)
+	{
+		std::ifstream shaderFile(shader, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!shaderFile.is_open())
+		{
+			std::cerr << "Could not open " << shader << "!" << std::endl;
+			return false;
+		}
+
+		const auto size = static_cast<uint64_t>(shaderFile.tellg());
+		shaderFile.seekg(0);
+
+		std::vector<uint32_t> code(size / sizeof(uint32_t));
+		shaderFile.read(reinterpret_cast<char*>(code.data()), code.size() * sizeof(uint32_t));
+
+		SpvReflectShaderModule module = {};
+		if (spvReflectCreateShaderModule(code.size() * sizeof(uint32_t), code.data(), &module) != SPV_REFLECT_RESULT_SUCCESS)
+		{
+			std::cerr << "Failed to reflect " << shader << "!" << std::endl;
+			return false;
+		}
+
+		// "shader.vert.spv" -> "shader_vert".
+		const auto name = ToIdentifier(shader.stem().string().c_str(), "Shader");
+		const auto contents = HeaderWriter(module).generate(shader.filename().string(), name);
+		spvReflectDestroyShaderModule(&module);
+
+		// Only write the header if it changed, so that the dependents are not rebuilt every time.
+		const auto header = outputDirectory / (name + ".hpp");
+		{
+			std::ifstream existingFile(header, std::ios::in | std::ios::binary);
+			const std::string existing((std::istreambuf_iterator<char>(existingFile)), std::istreambuf_iterator<char>());
+
+			if (existing == contents)
+				return true;
+		}
+
+		std::ofstream headerFile(header, std::ios::out | std::ios::binary | std::ios::trunc);
+		headerFile << contents;
+
+		std::cout << "Generated " << header.string() << std::endl;
+		return headerFile.good();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cerr << "Usage: ShaderInterfaceGenerator <output directory> <shader.spv>..." << std::endl;
+		return 1;
+	}
+
+	const std::filesystem::path outputDirectory = argv[1];
+	std::filesystem::create_directories(outputDirectory);
+
+	bool bSucceeded = true;
+	for (int i = 2; i < argc; i++)
+		bSucceeded &= GenerateHeader(argv[i], outputDirectory);
+
+	return bSucceeded ? 0 : 1;
+}
+
+#include <SPIRV-Reflect/spirv_reflect.c>
\ No newline at end of file
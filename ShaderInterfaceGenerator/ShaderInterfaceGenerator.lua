@@ -0,0 +1,28 @@
+project "ShaderInterfaceGenerator"
+	kind "ConsoleApp"
+	cppdialect "C++17"
+	language "C++"
+	systemversion "latest"
+	staticruntime "on"
+
+	flags { "MultiProcessorCompile" }
+
+	targetdir "%{wks.location}/Builds/%{cfg.longname}"
+	objdir "%{wks.location}/Builds/Intermediate/%{cfg.longname}"
+
+	files {
+		"**.cpp",
+		"**.lua",
+	}
+
+	includedirs {
+		"%{wks.location}/Include",
+	}
+
+	filter { "toolset:msc", "configurations:Debug" }
+	    buildoptions "/MTd"
+
+	filter { "toolset:msc", "configurations:Release" }
+	    buildoptions "/MT"
+
+	filter ""
\ No newline at end of file
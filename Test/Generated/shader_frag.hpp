@@ -0,0 +1,26 @@
+#pragma once
+
+// Generated by the ShaderInterfaceGenerator from shader.frag.spv. Do not edit.
+
+#include <Firefly/Imports.hpp>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ShaderInterface::shader_frag
+{
+	// Descriptor bindings. The names match the keys of Shader::getBinding().
+	// ShaderSet is the set declared in the shader. The engine binds the set of a shader at the shader's index within the pipeline
+	// instead, so use Package::getSetIndex() when a set index is needed.
+	namespace Bindings
+	{
+		struct texSampler
+		{
+			static constexpr uint32_t ShaderSet = 1;
+			static constexpr uint32_t Binding = 0;
+			static constexpr uint32_t Count = 1;
+			static constexpr VkDescriptorType Type = VkDescriptorType::VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+// Generated by the ShaderInterfaceGenerator from shader.vert.spv. Do not edit.
+
+#include <Firefly/Imports.hpp>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ShaderInterface::shader_vert
+{
+	// Descriptor bindings. The names match the keys of Shader::getBinding().
+	// ShaderSet is the set declared in the shader. The engine binds the set of a shader at the shader's index within the pipeline
+	// instead, so use Package::getSetIndex() when a set index is needed.
+	namespace Bindings
+	{
+		struct cam
+		{
+			static constexpr uint32_t ShaderSet = 0;
+			static constexpr uint32_t Binding = 0;
+			static constexpr uint32_t Count = 1;
+			static constexpr VkDescriptorType Type = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		};
+
+		struct model
+		{
+			static constexpr uint32_t ShaderSet = 0;
+			static constexpr uint32_t Binding = 1;
+			static constexpr uint32_t Count = 1;
+			static constexpr VkDescriptorType Type = VkDescriptorType::VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		};
+	}
+
+	// Buffer block layouts. Padding is explicit, so these can be copied to the buffers as they are.
+	namespace Blocks
+	{
+		struct Camera
+		{
+			glm::mat4 view;
+			glm::mat4 proj;
+		};
+
+		static_assert(offsetof(Camera, view) == 0, "Camera::view does not match the shader!");
+		static_assert(offsetof(Camera, proj) == 64, "Camera::proj does not match the shader!");
+		static_assert(sizeof(Camera) == 128, "Camera does not match the shader!");
+
+		struct Model
+		{
+			glm::mat4 model;
+		};
+
+		static_assert(offsetof(Model, model) == 0, "Model::model does not match the shader!");
+		static_assert(sizeof(Model) == 64, "Model does not match the shader!");
+	}
+
+	// Vertex input layout. The attributes are tightly packed in the order of their locations.
+	namespace VertexInput
+	{
+		struct Vertex
+		{
+			glm::vec3 inPos;
+			glm::vec4 inColor;
+			glm::vec2 inTexture;
+		};
+
+		static_assert(offsetof(Vertex, inPos) == 0, "Vertex::inPos does not match the shader!");
+		static_assert(offsetof(Vertex, inColor) == 12, "Vertex::inColor does not match the shader!");
+		static_assert(offsetof(Vertex, inTexture) == 28, "Vertex::inTexture does not match the shader!");
+		static_assert(sizeof(Vertex) == 36, "Vertex does not match the shader!");
+
+		constexpr uint32_t inPosLocation = 0;
+		constexpr uint32_t inColorLocation = 1;
+		constexpr uint32_t inTextureLocation = 2;
+	}
+}
\ No newline at end of file
@@ -32,6 +32,18 @@ project "Test"
 		"%{Binary.GLFW}"
 	}
 
+	-- Generate the shader interface headers before building.
+	dependson { "ShaderInterfaceGenerator" }
+
+	local shaders = {}
+	for _, shader in ipairs(os.matchfiles("Shaders/*.spv")) do
+		table.insert(shaders, '"' .. path.getabsolute(shader) .. '"')
+	end
+
+	prebuildcommands {
+		'"%{cfg.buildtarget.directory}/ShaderInterfaceGenerator" "%{wks.location}/Test/Generated" ' .. table.concat(shaders, " ")
+	}
+
 	filter { "toolset:msc", "configurations:Debug" }
 	    buildoptions "/MTd"
 
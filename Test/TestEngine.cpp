@@ -6,6 +6,9 @@
 
 #include "Firefly/ImportSourceFiles.hpp"
 
+#include "Generated/shader_vert.hpp"
+#include "Generated/shader_frag.hpp"
+
 #include <fstream>
 
 void logger(const Firefly::Utility::LogLevel level, const std::string_view& message)
@@ -21,6 +24,19 @@ TestEngine::TestEngine()
 	m_Instance = Firefly::Instance::create();
 	m_GraphicsEngine = Firefly::GraphicsEngine::create(m_Instance);
 	m_RenderTarget = Firefly::RenderTarget::create(m_GraphicsEngine, { 1280, 720, 1 }, VkFormat::VK_FORMAT_R8G8B8A8_SRGB, 1);
+	m_RenderTarget->setBakedMode(true);
+
+	// Submitting an invalidated frame without recording it must be rejected instead of resubmitting stale commands.
+	m_RenderTarget->invalidateFrames();
+	try
+	{
+		m_RenderTarget->submitFrame();
+		throw std::runtime_error("Submitting an unrecorded frame was not rejected!");
+	}
+	catch (const Firefly::BackendError&)
+	{
+	}
+
 	m_Surface = Firefly::Surface::create(m_Instance, 1280, 720, "Firefly");
 
 	m_VertexShader = Firefly::Shader::create(m_GraphicsEngine, "Shaders/shader.vert.spv", VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT);
@@ -41,22 +57,25 @@ TestEngine::TestEngine()
 		m_IndexCount = static_cast<uint32_t>(model.m_IndexCount);
 	}
 
-	m_UniformBuffer = Firefly::Buffer::create(m_GraphicsEngine, sizeof(glm::mat4), Firefly::BufferType::Uniform);
-	auto& modelMatrix = *reinterpret_cast<glm::mat4*>(m_UniformBuffer->mapMemory());
-	modelMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	using namespace ShaderInterface;
+	static_assert(sizeof(Firefly::ObjVertex) == sizeof(shader_vert::VertexInput::Vertex), "The model vertex does not match the vertex shader input!");
+	static_assert(sizeof(Firefly::CameraMatrix) == sizeof(shader_vert::Blocks::Camera), "The camera matrix does not match the camera block!");
+
+	m_UniformBuffer = Firefly::Buffer::create(m_GraphicsEngine, sizeof(shader_vert::Blocks::Model), Firefly::BufferType::Uniform);
+	auto& modelBlock = *reinterpret_cast<shader_vert::Blocks::Model*>(m_UniformBuffer->mapMemory());
+	modelBlock.model = glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
 	m_UniformBuffer->unmapMemory();
 
 	m_LeftEyeUniform = Firefly::CameraMatrix::createBuffer(m_GraphicsEngine);
 	m_RightEyeUniform = Firefly::CameraMatrix::createBuffer(m_GraphicsEngine);
 
-	m_VertexResourcePackageLeft->bindResources(0, { m_LeftEyeUniform });
-	m_VertexResourcePackageLeft->bindResources(1, { m_UniformBuffer });
-	m_VertexResourcePackageRight->bindResources(0, { m_RightEyeUniform });
-	m_VertexResourcePackageRight->bindResources(1, { m_UniformBuffer });
+	m_VertexResourcePackageLeft->bindResources(shader_vert::Bindings::cam::Binding, { m_LeftEyeUniform });
+	m_VertexResourcePackageLeft->bindResources(shader_vert::Bindings::model::Binding, { m_UniformBuffer });
+	m_VertexResourcePackageRight->bindResources(shader_vert::Bindings::cam::Binding, { m_RightEyeUniform });
+	m_VertexResourcePackageRight->bindResources(shader_vert::Bindings::model::Binding, { m_UniformBuffer });
 
 	m_Texture = Firefly::LoadImageFromFile(m_GraphicsEngine, "Assets/VikingRoom/texture.png");
-	m_Texture->changeImageLayout(VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-	m_FragmentResourcePackage->bindResources(0, { m_Texture });
+	m_FragmentResourcePackage->bindResources(shader_frag::Bindings::texSampler::Binding, { m_Texture });
 }
 
 std::shared_ptr<Firefly::Image> TestEngine::draw()
@@ -69,36 +88,40 @@ std::shared_ptr<Firefly::Image> TestEngine::draw()
 	m_Camera.update();
 	m_Camera.copyToBuffer(m_LeftEyeUniform.get(), m_RightEyeUniform.get());
 
-	VkViewport viewport = {};
-	viewport.width = static_cast<float>(m_RenderTarget->getExtent().width) / 2;
-	viewport.height = static_cast<float>(m_RenderTarget->getExtent().height);
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-
-	VkRect2D scissor = {};
-	scissor.extent.width = m_RenderTarget->getExtent().width;
-	scissor.extent.height = m_RenderTarget->getExtent().height;
-	scissor.offset.x = 0;
-	scissor.offset.y = 0;
-
-	const auto pCommandBuffer = m_RenderTarget->setupFrame(Firefly::CreateClearValues(Firefly::CreateColor256(0), Firefly::CreateColor256(0), Firefly::CreateColor256(0)));
-
-	pCommandBuffer->bindVertexBuffer(m_VertexBuffer.get());
-	pCommandBuffer->bindIndexBuffer(m_IndexBuffer.get());
-	pCommandBuffer->bindGraphicsPipeline(m_Pipeline.get(), { m_VertexResourcePackageLeft.get(), m_FragmentResourcePackage.get() });
-
-	// Left eye. 
-	pCommandBuffer->bindScissor(scissor);
-	pCommandBuffer->bindViewport(viewport);
-	pCommandBuffer->drawIndices(m_IndexCount);
-
-	// Right eye.
-	viewport.x = viewport.width;
-	pCommandBuffer->bindViewport(viewport);
-	pCommandBuffer->bindScissor(scissor);
-	pCommandBuffer->drawIndices(m_IndexCount);
+	// The scene is static, so we only need to record the commands once per frame index.
+	if (!m_RenderTarget->isFrameRecorded())
+	{
+		VkViewport viewport = {};
+		viewport.width = static_cast<float>(m_RenderTarget->getExtent().width) / 2;
+		viewport.height = static_cast<float>(m_RenderTarget->getExtent().height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+
+		VkRect2D scissor = {};
+		scissor.extent.width = m_RenderTarget->getExtent().width;
+		scissor.extent.height = m_RenderTarget->getExtent().height;
+		scissor.offset.x = 0;
+		scissor.offset.y = 0;
+
+		const auto pCommandBuffer = m_RenderTarget->setupFrame(Firefly::CreateClearValues(Firefly::CreateColor256(0), Firefly::CreateColor256(0), Firefly::CreateColor256(0)));
+
+		pCommandBuffer->bindVertexBuffer(m_VertexBuffer.get());
+		pCommandBuffer->bindIndexBuffer(m_IndexBuffer.get());
+		pCommandBuffer->bindGraphicsPipeline(m_Pipeline.get(), { m_VertexResourcePackageLeft.get(), m_FragmentResourcePackage.get() });
+
+		// Left eye. 
+		pCommandBuffer->bindScissor(scissor);
+		pCommandBuffer->bindViewport(viewport);
+		pCommandBuffer->drawIndices(m_IndexCount);
+
+		// Right eye.
+		viewport.x = viewport.width;
+		pCommandBuffer->bindViewport(viewport);
+		pCommandBuffer->bindScissor(scissor);
+		pCommandBuffer->drawIndices(m_IndexCount);
+	}
 
 	m_RenderTarget->submitFrame();
 
@@ -38,4 +38,5 @@ workspace "Firefly"
 
 	-- Include the projects.
 	include "Include/Firefly.lua"
+	include "ShaderInterfaceGenerator/ShaderInterfaceGenerator.lua"
 	include "Test/Test.lua"
\ No newline at end of file